@@ -6250,27 +6250,24 @@ static inline void bfq_update_insert_stats(struct request_queue *q,
 
 static struct bfq_queue *bfq_init_rq(struct request *rq);
 
-static void bfq_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
-			       blk_insert_t flags)
+/*
+ * Insert @rq with bfqd->lock held. Returns false if @rq has been merged into
+ * another request and added to @free, true otherwise.
+ */
+static bool bfq_insert_request_locked(struct bfq_data *bfqd,
+				      struct request *rq, blk_insert_t flags,
+				      struct bfq_queue **bfqqp,
+				      bool *idle_timer_disabled,
+				      struct list_head *free)
 {
-	struct request_queue *q = hctx->queue;
-	struct bfq_data *bfqd = q->elevator->elevator_data;
+	struct request_queue *q = rq->q;
 	struct bfq_queue *bfqq;
-	bool idle_timer_disabled = false;
-	blk_opf_t cmd_flags;
-	LIST_HEAD(free);
 
-#ifdef CONFIG_BFQ_GROUP_IOSCHED
-	if (!cgroup_subsys_on_dfl(io_cgrp_subsys) && rq->bio)
-		bfqg_stats_update_legacy_io(q, rq);
-#endif
-	spin_lock_irq(&bfqd->lock);
+	lockdep_assert_held(&bfqd->lock);
+
 	bfqq = bfq_init_rq(rq);
-	if (blk_mq_sched_try_insert_merge(q, rq, &free)) {
-		spin_unlock_irq(&bfqd->lock);
-		blk_mq_free_requests(&free);
-		return;
-	}
+	if (blk_mq_sched_try_insert_merge(q, rq, free))
+		return false;
 
 	trace_block_rq_insert(rq);
 
@@ -6279,7 +6276,7 @@ static void bfq_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
 	} else if (!bfqq) {
 		list_add_tail(&rq->queuelist, &bfqd->dispatch);
 	} else {
-		idle_timer_disabled = __bfq_insert_request(bfqd, rq);
+		*idle_timer_disabled = __bfq_insert_request(bfqd, rq);
 		/*
 		 * Update bfqq, because, if a queue merge has occurred
 		 * in __bfq_insert_request, then rq has been
@@ -6294,6 +6291,32 @@ static void bfq_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
 		}
 	}
 
+	*bfqqp = bfqq;
+	return true;
+}
+
+static void bfq_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
+			       blk_insert_t flags)
+{
+	struct request_queue *q = hctx->queue;
+	struct bfq_data *bfqd = q->elevator->elevator_data;
+	struct bfq_queue *bfqq;
+	bool idle_timer_disabled = false;
+	blk_opf_t cmd_flags;
+	LIST_HEAD(free);
+
+#ifdef CONFIG_BFQ_GROUP_IOSCHED
+	if (!cgroup_subsys_on_dfl(io_cgrp_subsys) && rq->bio)
+		bfqg_stats_update_legacy_io(q, rq);
+#endif
+	spin_lock_irq(&bfqd->lock);
+	if (!bfq_insert_request_locked(bfqd, rq, flags, &bfqq,
+				       &idle_timer_disabled, &free)) {
+		spin_unlock_irq(&bfqd->lock);
+		blk_mq_free_requests(&free);
+		return;
+	}
+
 	/*
 	 * Cache cmd_flags before releasing scheduler lock, because rq
 	 * may disappear afterwards (for example, because of a request
@@ -6310,13 +6333,54 @@ static void bfq_insert_requests(struct blk_mq_hw_ctx *hctx,
 				struct list_head *list,
 				blk_insert_t flags)
 {
+	struct request_queue *q = hctx->queue;
+	struct bfq_data *bfqd = q->elevator->elevator_data;
+	LIST_HEAD(free);
+
+	/*
+	 * The debug statistics are updated under the queue lock after
+	 * bfqd->lock has been dropped, one request at a time.
+	 */
+	if (IS_ENABLED(CONFIG_BFQ_CGROUP_DEBUG) || list_is_singular(list)) {
+		while (!list_empty(list)) {
+			struct request *rq;
+
+			rq = list_first_entry(list, struct request, queuelist);
+			list_del_init(&rq->queuelist);
+			bfq_insert_request(hctx, rq, flags);
+		}
+		return;
+	}
+
+#ifdef CONFIG_BFQ_GROUP_IOSCHED
+	if (!cgroup_subsys_on_dfl(io_cgrp_subsys)) {
+		struct request *rq;
+
+		list_for_each_entry(rq, list, queuelist)
+			if (rq->bio)
+				bfqg_stats_update_legacy_io(q, rq);
+	}
+#endif
+
+	/*
+	 * Insert the whole batch with a single acquisition of bfqd->lock,
+	 * so that a flushed plug does not bounce the scheduler lock once
+	 * per request against concurrent dispatchers.
+	 */
+	spin_lock_irq(&bfqd->lock);
 	while (!list_empty(list)) {
+		struct bfq_queue *bfqq;
+		bool idle_timer_disabled = false;
 		struct request *rq;
 
 		rq = list_first_entry(list, struct request, queuelist);
 		list_del_init(&rq->queuelist);
-		bfq_insert_request(hctx, rq, flags);
+		bfq_insert_request_locked(bfqd, rq, flags, &bfqq,
+					  &idle_timer_disabled, &free);
 	}
+	spin_unlock_irq(&bfqd->lock);
+
+	blk_mq_free_requests(&free);
 }
 
 static void bfq_update_hw_tag(struct bfq_data *bfqd)
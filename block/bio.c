@@ -18,6 +18,8 @@
 #include <linux/highmem.h>
 #include <linux/blk-crypto.h>
 #include <linux/xarray.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include <trace/events/block.h>
 #include "blk.h"
@@ -34,6 +36,16 @@ struct bio_alloc_cache {
 	unsigned int		nr_irq;
 };
 
+/* hit rate of the per-cpu bio caches, summed over all bio_sets */
+struct bio_alloc_cache_stats {
+	unsigned long		alloc_hit;
+	unsigned long		alloc_miss;
+	unsigned long		put_cached;
+	unsigned long		put_freed;
+};
+
+static DEFINE_PER_CPU(struct bio_alloc_cache_stats, bio_cache_stats);
+
 static struct biovec_slab {
 	int nr_vecs;
 	char *name;
@@ -453,6 +465,7 @@ static struct bio *bio_alloc_percpu_cache(struct block_device *bdev,
 		if (READ_ONCE(cache->nr_irq) >= ALLOC_CACHE_THRESHOLD)
 			bio_alloc_irq_cache_splice(cache);
 		if (!cache->free_list) {
+			this_cpu_inc(bio_cache_stats.alloc_miss);
 			put_cpu();
 			return NULL;
 		}
@@ -460,6 +473,7 @@ static struct bio *bio_alloc_percpu_cache(struct block_device *bdev,
 	bio = cache->free_list;
 	cache->free_list = bio->bi_next;
 	cache->nr--;
+	this_cpu_inc(bio_cache_stats.alloc_hit);
 	put_cpu();
 
 	bio_init(bio, bdev, nr_vecs ? bio->bi_inline_vecs : NULL, nr_vecs, opf);
@@ -772,6 +786,7 @@ static void bio_alloc_cache_destroy(struct bio_set *bs)
 static inline void bio_put_percpu_cache(struct bio *bio)
 {
 	struct bio_alloc_cache *cache;
+	unsigned long flags;
 
 	cache = per_cpu_ptr(bio->bi_pool->cache, get_cpu());
 	if (READ_ONCE(cache->nr_irq) + cache->nr > ALLOC_CACHE_MAX)
@@ -791,12 +806,25 @@ static inline void bio_put_percpu_cache(struct bio *bio)
 		bio->bi_next = cache->free_list_irq;
 		cache->free_list_irq = bio;
 		cache->nr_irq++;
+	} else if (in_serving_softirq()) {
+		/*
+		 * Most non-polled completions end up here.  The irq list is
+		 * also fed from hardirq context, so keep it out while we add.
+		 */
+		bio_uninit(bio);
+		local_irq_save(flags);
+		bio->bi_next = cache->free_list_irq;
+		cache->free_list_irq = bio;
+		cache->nr_irq++;
+		local_irq_restore(flags);
 	} else {
 		goto out_free;
 	}
+	this_cpu_inc(bio_cache_stats.put_cached);
 	put_cpu();
 	return;
 out_free:
+	this_cpu_inc(bio_cache_stats.put_freed);
 	put_cpu();
 	bio_free(bio);
 }
@@ -1851,3 +1879,36 @@ static int __init init_bio(void)
 	return 0;
 }
 subsys_initcall(init_bio);
+
+#ifdef CONFIG_DEBUG_FS
+static int bio_alloc_cache_show(struct seq_file *m, void *v)
+{
+	struct bio_alloc_cache_stats sum = { };
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct bio_alloc_cache_stats *s = per_cpu_ptr(&bio_cache_stats,
+							      cpu);
+
+		sum.alloc_hit += READ_ONCE(s->alloc_hit);
+		sum.alloc_miss += READ_ONCE(s->alloc_miss);
+		sum.put_cached += READ_ONCE(s->put_cached);
+		sum.put_freed += READ_ONCE(s->put_freed);
+	}
+
+	seq_printf(m, "alloc_hit %lu\nalloc_miss %lu\n",
+		   sum.alloc_hit, sum.alloc_miss);
+	seq_printf(m, "put_cached %lu\nput_freed %lu\n",
+		   sum.put_cached, sum.put_freed);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(bio_alloc_cache);
+
+static int __init bio_debugfs_init(void)
+{
+	debugfs_create_file("bio_alloc_cache", 0400, blk_debugfs_root, NULL,
+			    &bio_alloc_cache_fops);
+	return 0;
+}
+late_initcall(bio_debugfs_init);
+#endif /* CONFIG_DEBUG_FS */
@@ -44,7 +44,12 @@
  * /sys/fs/cgroup/io.cost.model.
  *
  * If needed, tools/cgroup/iocost_coef_gen.py can be used to generate
- * device-specific coefficients.
+ * device-specific coefficients.  Alternatively, the parameters can be
+ * fitted online from completion samples ("fit=propose" or "fit=apply" in
+ * io.cost.model).  The device time consumed by a completed request is
+ * estimated as the time since either its issue or the previous
+ * completion, whichever is later, and regressed against its size for
+ * sequential and random IOs separately, sharing the per-page slope.
  *
  * 2. Control Strategy
  *
@@ -312,6 +317,19 @@ enum {
 
 	/* if apart further than 16M, consider randio for linear model */
 	LCOEF_RANDIO_PAGES	= 4096,
+
+	/*
+	 * Online cost model fitting.  Samples are clamped so that the sums
+	 * can't overflow and halved once there are enough of them so that
+	 * the fit follows drifting devices.
+	 */
+	FIT_MAX_SAMPLE_NS	= 1 << 24,
+	FIT_MAX_SAMPLE_PAGES	= 1 << 12,
+	FIT_MIN_SAMPLES		= 256,
+	FIT_FULL_CONF_SAMPLES	= 16384,
+	FIT_DECAY_SAMPLES	= 65536,
+	FIT_APPLY_CONF_PCT	= 90,
+	FIT_APPLY_NSEC		= 10LLU * NSEC_PER_SEC,
 };
 
 enum ioc_running {
@@ -342,9 +360,34 @@ enum {
 enum {
 	COST_CTRL,
 	COST_MODEL,
+	COST_FIT,
 	NR_COST_CTRL_PARAMS,
 };
 
+/* online cost model fitting modes */
+enum {
+	FIT_OFF,
+	FIT_PROPOSE,
+	FIT_APPLY,
+};
+
+/* sequential and random samples are fitted separately */
+enum {
+	FIT_SEQ,
+	FIT_RAND,
+	NR_FIT_KINDS,
+};
+
+/* sums for the least squares fit, x is in pages and y in nsecs */
+enum {
+	FIT_N,
+	FIT_SX,
+	FIT_SY,
+	FIT_SXX,
+	FIT_SXY,
+	NR_FIT_SUMS,
+};
+
 /* builtin linear cost model coefficients */
 enum {
 	I_LCOEF_RBPS,
@@ -395,11 +438,18 @@ struct ioc_missed {
 	u32				last_missed;
 };
 
+struct ioc_fit_stat {
+	local64_t			sums[NR_FIT_SUMS];
+	u64				last[NR_FIT_SUMS];
+};
+
 struct ioc_pcpu_stat {
 	struct ioc_missed		missed[2];
 
 	local64_t			rq_wait_ns;
 	u64				last_rq_wait_ns;
+
+	struct ioc_fit_stat		fit[2][NR_FIT_KINDS];
 };
 
 /* per device */
@@ -445,6 +495,15 @@ struct ioc {
 	int				autop_idx;
 	bool				user_qos_params:1;
 	bool				user_cost_model:1;
+
+	/* online cost model fitting */
+	int				fit_mode;
+	atomic64_t			fit_last_done_ns;
+	sector_t			fit_last_end[2];
+	u64				fit_sums[2][NR_FIT_KINDS][NR_FIT_SUMS];
+	u64				fit_i_lcoefs[NR_I_LCOEFS];
+	u32				fit_conf_pct[2];
+	u64				fit_applied_at;
 };
 
 struct iocg_pcpu_stat {
@@ -1635,6 +1694,131 @@ static void ioc_lat_stat(struct ioc *ioc, u32 *missed_ppm_ar, u32 *rq_wait_pct_p
 				   ioc->period_us * NSEC_PER_USEC);
 }
 
+/*
+ * Fit the linear model for one direction from the accumulated samples and
+ * store the result in the i_lcoefs format in @u.  Returns the confidence in
+ * percent.  Coefficients which can't be determined are left alone.
+ */
+static u32 ioc_fit_dir(struct ioc *ioc, int rw, u64 *u)
+{
+	u64 (*sums)[NR_FIT_SUMS] = ioc->fit_sums[rw];
+	u64 page_vtime = ioc->params.lcoefs[rw == READ ? LCOEF_RPAGE : LCOEF_WPAGE];
+	u64 cxx = 0, nr = 0, page_ns;
+	s64 cxy = 0;
+	bool slope_known;
+	u32 conf;
+	int k;
+
+	for (k = 0; k < NR_FIT_KINDS; k++) {
+		u64 *f = sums[k];
+
+		if (f[FIT_N] < FIT_MIN_SAMPLES)
+			continue;
+		nr += f[FIT_N];
+		cxx += f[FIT_SXX] -
+			mul_u64_u64_div_u64(f[FIT_SX], f[FIT_SX], f[FIT_N]);
+		cxy += (s64)(f[FIT_SXY] -
+			     mul_u64_u64_div_u64(f[FIT_SX], f[FIT_SY], f[FIT_N]));
+	}
+
+	if (nr < FIT_MIN_SAMPLES)
+		return 0;
+
+	/*
+	 * The per-page cost is the slope pooled over both kinds.  If all IOs
+	 * are of about the same size, it can't be told apart from the per-IO
+	 * cost; keep the current page cost and fit only the latter.
+	 */
+	slope_known = cxy > 0 && cxx >= nr;
+	if (slope_known)
+		page_ns = max_t(u64, div64_u64(cxy, cxx), 1);
+	else
+		page_ns = max_t(u64, div64_u64(page_vtime, VTIME_PER_NSEC), 1);
+
+	u[I_LCOEF_RBPS] = div64_u64((u64)IOC_PAGE_SIZE * NSEC_PER_SEC, page_ns);
+
+	for (k = 0; k < NR_FIT_KINDS; k++) {
+		u64 *f = sums[k];
+		u64 size_ns, io_ns;
+
+		if (f[FIT_N] < FIT_MIN_SAMPLES)
+			continue;
+
+		size_ns = page_ns * f[FIT_SX];
+		io_ns = f[FIT_SY] > size_ns ?
+			div64_u64(f[FIT_SY] - size_ns, f[FIT_N]) : 0;
+		u[k == FIT_SEQ ? I_LCOEF_RSEQIOPS : I_LCOEF_RRANDIOPS] =
+			div64_u64(NSEC_PER_SEC, page_ns + io_ns);
+	}
+
+	conf = min_t(u64, div64_u64(nr * 100, FIT_FULL_CONF_SAMPLES), 100);
+	if (!slope_known)
+		conf /= 2;
+	return conf;
+}
+
+/* fold in this period's samples and refresh the fitted coefficients */
+static void ioc_fit_update(struct ioc *ioc, struct ioc_now *now)
+{
+	u64 u[NR_I_LCOEFS];
+	bool apply = false;
+	int cpu, rw, k, i;
+
+	lockdep_assert_held(&ioc->lock);
+
+	for_each_online_cpu(cpu) {
+		struct ioc_pcpu_stat *stat = per_cpu_ptr(ioc->pcpu_stat, cpu);
+
+		for (rw = READ; rw <= WRITE; rw++) {
+			for (k = 0; k < NR_FIT_KINDS; k++) {
+				struct ioc_fit_stat *fs = &stat->fit[rw][k];
+
+				for (i = 0; i < NR_FIT_SUMS; i++) {
+					u64 v = local64_read(&fs->sums[i]);
+
+					ioc->fit_sums[rw][k][i] += v - fs->last[i];
+					fs->last[i] = v;
+				}
+			}
+		}
+	}
+
+	memcpy(u, ioc->params.i_lcoefs, sizeof(u));
+
+	for (rw = READ; rw <= WRITE; rw++) {
+		/* WBPS, WSEQIOPS and WRANDIOPS follow their read counterparts */
+		u64 *ud = &u[rw == READ ? I_LCOEF_RBPS : I_LCOEF_WBPS];
+
+		for (k = 0; k < NR_FIT_KINDS; k++) {
+			if (ioc->fit_sums[rw][k][FIT_N] < FIT_DECAY_SAMPLES)
+				continue;
+			for (i = 0; i < NR_FIT_SUMS; i++)
+				ioc->fit_sums[rw][k][i] /= 2;
+		}
+
+		ioc->fit_conf_pct[rw] = ioc_fit_dir(ioc, rw, ud);
+		if (ioc->fit_conf_pct[rw] >= FIT_APPLY_CONF_PCT)
+			apply = true;
+	}
+
+	memcpy(ioc->fit_i_lcoefs, u, sizeof(u));
+
+	if (ioc->fit_mode != FIT_APPLY || ioc->user_cost_model || !apply ||
+	    now->now_ns - ioc->fit_applied_at < FIT_APPLY_NSEC)
+		return;
+
+	for (rw = READ; rw <= WRITE; rw++) {
+		int base = rw == READ ? I_LCOEF_RBPS : I_LCOEF_WBPS;
+
+		if (ioc->fit_conf_pct[rw] < FIT_APPLY_CONF_PCT)
+			continue;
+		for (i = base; i < base + 3; i++)
+			ioc->params.i_lcoefs[i] = u[i];
+	}
+	ioc_refresh_lcoefs(ioc);
+	ioc->fit_applied_at = now->now_ns;
+}
+
 /* was iocg idle this period? */
 static bool iocg_is_idle(struct ioc_gq *iocg)
 {
@@ -2272,6 +2456,9 @@ static void ioc_timer_fn(struct timer_list *timer)
 
 	nr_debtors = ioc_check_iocgs(ioc, &now);
 
+	if (ioc->fit_mode != FIT_OFF)
+		ioc_fit_update(ioc, &now);
+
 	/*
 	 * Wait and indebt stat are flushed above and the donation calculation
 	 * below needs updated usage stat. Let's bring stat up-to-date.
@@ -2806,11 +2993,45 @@ static void ioc_rqos_done_bio(struct rq_qos *rqos, struct bio *bio)
 		atomic64_add(bio->bi_iocost_cost, &iocg->done_vtime);
 }
 
+/*
+ * Record a sample for the online model fit. The device time @rq consumed is
+ * the time since it was issued or since the previous completion, whichever
+ * is later, which holds whether the device is idle or saturated.
+ */
+static void ioc_fit_sample(struct ioc *ioc, struct ioc_pcpu_stat *ccs,
+			   struct request *rq, int rw, u64 now_ns)
+{
+	u64 prev_ns = atomic64_xchg(&ioc->fit_last_done_ns, now_ns);
+	sector_t last_end = READ_ONCE(ioc->fit_last_end[rw]);
+	struct ioc_fit_stat *fs;
+	u64 x, y, seek_pages;
+
+	WRITE_ONCE(ioc->fit_last_end[rw], blk_rq_pos(rq) + blk_rq_sectors(rq));
+
+	if (!rq->io_start_time_ns || now_ns <= rq->io_start_time_ns)
+		return;
+
+	y = now_ns - max(prev_ns, rq->io_start_time_ns);
+	y = min_t(u64, y, FIT_MAX_SAMPLE_NS);
+	x = blk_rq_sectors(rq) >> IOC_SECT_TO_PAGE_SHIFT;
+	x = clamp_t(u64, x, 1, FIT_MAX_SAMPLE_PAGES);
+
+	seek_pages = abs((s64)(blk_rq_pos(rq) - last_end));
+	seek_pages >>= IOC_SECT_TO_PAGE_SHIFT;
+	fs = &ccs->fit[rw][seek_pages > LCOEF_RANDIO_PAGES ? FIT_RAND : FIT_SEQ];
+
+	local64_inc(&fs->sums[FIT_N]);
+	local64_add(x, &fs->sums[FIT_SX]);
+	local64_add(y, &fs->sums[FIT_SY]);
+	local64_add(x * x, &fs->sums[FIT_SXX]);
+	local64_add(x * y, &fs->sums[FIT_SXY]);
+}
+
 static void ioc_rqos_done(struct rq_qos *rqos, struct request *rq)
 {
 	struct ioc *ioc = rqos_to_ioc(rqos);
 	struct ioc_pcpu_stat *ccs;
-	u64 on_q_ns, rq_wait_ns, size_nsec;
+	u64 now_ns, on_q_ns, rq_wait_ns, size_nsec;
 	int pidx, rw;
 
 	if (!ioc->enabled || !rq->alloc_time_ns || !rq->start_time_ns)
@@ -2829,12 +3050,16 @@ static void ioc_rqos_done(struct rq_qos *rqos, struct request *rq)
 		return;
 	}
 
-	on_q_ns = blk_time_get_ns() - rq->alloc_time_ns;
+	now_ns = blk_time_get_ns();
+	on_q_ns = now_ns - rq->alloc_time_ns;
 	rq_wait_ns = rq->start_time_ns - rq->alloc_time_ns;
 	size_nsec = div64_u64(calc_size_vtime_cost(rq, ioc), VTIME_PER_NSEC);
 
 	ccs = get_cpu_ptr(ioc->pcpu_stat);
 
+	if (READ_ONCE(ioc->fit_mode) != FIT_OFF)
+		ioc_fit_sample(ioc, ccs, rq, rw, now_ns);
+
 	if (on_q_ns <= size_nsec ||
 	    on_q_ns - size_nsec <= ioc->params.qos[pidx] * NSEC_PER_USEC)
 		local_inc(&ccs->missed[rw].nr_met);
@@ -3372,10 +3597,24 @@ static u64 ioc_cost_model_prfill(struct seq_file *sf,
 	spin_lock(&ioc->lock);
 	seq_printf(sf, "%s ctrl=%s model=linear "
 		   "rbps=%llu rseqiops=%llu rrandiops=%llu "
-		   "wbps=%llu wseqiops=%llu wrandiops=%llu\n",
+		   "wbps=%llu wseqiops=%llu wrandiops=%llu",
 		   dname, ioc->user_cost_model ? "user" : "auto",
 		   u[I_LCOEF_RBPS], u[I_LCOEF_RSEQIOPS], u[I_LCOEF_RRANDIOPS],
 		   u[I_LCOEF_WBPS], u[I_LCOEF_WSEQIOPS], u[I_LCOEF_WRANDIOPS]);
+	if (ioc->fit_mode != FIT_OFF) {
+		u64 *f = ioc->fit_i_lcoefs;
+
+		seq_printf(sf, " fit=%s "
+			   "fit_rbps=%llu fit_rseqiops=%llu fit_rrandiops=%llu "
+			   "fit_wbps=%llu fit_wseqiops=%llu fit_wrandiops=%llu "
+			   "fit_rconf=%u fit_wconf=%u",
+			   ioc->fit_mode == FIT_APPLY ? "apply" : "propose",
+			   f[I_LCOEF_RBPS], f[I_LCOEF_RSEQIOPS],
+			   f[I_LCOEF_RRANDIOPS], f[I_LCOEF_WBPS],
+			   f[I_LCOEF_WSEQIOPS], f[I_LCOEF_WRANDIOPS],
+			   ioc->fit_conf_pct[READ], ioc->fit_conf_pct[WRITE]);
+	}
+	seq_putc(sf, '\n');
 	spin_unlock(&ioc->lock);
 	return 0;
 }
@@ -3392,6 +3631,7 @@ static int ioc_cost_model_show(struct seq_file *sf, void *v)
 static const match_table_t cost_ctrl_tokens = {
 	{ COST_CTRL,		"ctrl=%s"	},
 	{ COST_MODEL,		"model=%s"	},
+	{ COST_FIT,		"fit=%s"	},
 	{ NR_COST_CTRL_PARAMS,	NULL		},
 };
 
@@ -3414,6 +3654,7 @@ static ssize_t ioc_cost_model_write(struct kernfs_open_file *of, char *input,
 	struct ioc *ioc;
 	u64 u[NR_I_LCOEFS];
 	bool user;
+	int fit_mode;
 	char *body, *p;
 	int ret;
 
@@ -3444,6 +3685,7 @@ static ssize_t ioc_cost_model_write(struct kernfs_open_file *of, char *input,
 	spin_lock_irq(&ioc->lock);
 	memcpy(u, ioc->params.i_lcoefs, sizeof(u));
 	user = ioc->user_cost_model;
+	fit_mode = ioc->fit_mode;
 
 	while ((p = strsep(&body, " \t\n"))) {
 		substring_t args[MAX_OPT_ARGS];
@@ -3469,8 +3711,23 @@ static ssize_t ioc_cost_model_write(struct kernfs_open_file *of, char *input,
 			if (strcmp(buf, "linear"))
 				goto einval;
 			continue;
+		case COST_FIT:
+			match_strlcpy(buf, &args[0], sizeof(buf));
+			if (!strcmp(buf, "off"))
+				fit_mode = FIT_OFF;
+			else if (!strcmp(buf, "propose"))
+				fit_mode = FIT_PROPOSE;
+			else if (!strcmp(buf, "apply"))
+				fit_mode = FIT_APPLY;
+			else
+				goto einval;
+			continue;
 		}
 
+		/* fitted values are read-only, allow echoing them back */
+		if (!strncmp(p, "fit_", 4))
+			continue;
+
 		tok = match_token(p, i_lcoef_tokens, args);
 		if (tok == NR_I_LCOEFS)
 			goto einval;
@@ -3486,6 +3743,12 @@ static ssize_t ioc_cost_model_write(struct kernfs_open_file *of, char *input,
 	} else {
 		ioc->user_cost_model = false;
 	}
+	if (fit_mode != ioc->fit_mode) {
+		memset(ioc->fit_sums, 0, sizeof(ioc->fit_sums));
+		memset(ioc->fit_conf_pct, 0, sizeof(ioc->fit_conf_pct));
+		memcpy(ioc->fit_i_lcoefs, u, sizeof(u));
+		WRITE_ONCE(ioc->fit_mode, fit_mode);
+	}
 	ioc_refresh_params(ioc, true);
 	spin_unlock_irq(&ioc->lock);
 
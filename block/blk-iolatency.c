@@ -148,6 +148,9 @@ struct iolatency_grp {
 	u64 min_lat_nsec;
 	u64 cur_win_nsec;
 
+	/* Percentile of IOs that must meet min_lat_nsec, non-rotational only. */
+	unsigned int lat_pct;
+
 	/* total running average of our io latency. */
 	u64 lat_avg;
 
@@ -158,6 +161,7 @@ struct iolatency_grp {
 	struct child_latency_info child_lat;
 };
 
+#define BLKIOLATENCY_DFL_PCT 90
 #define BLKIOLATENCY_MIN_WIN_SIZE (100 * NSEC_PER_MSEC)
 #define BLKIOLATENCY_MAX_WIN_SIZE NSEC_PER_SEC
 /*
@@ -233,7 +237,8 @@ static inline bool latency_sum_ok(struct iolatency_grp *iolat,
 				  struct latency_stat *stat)
 {
 	if (iolat->ssd) {
-		u64 thresh = div64_u64(stat->ps.total, 10);
+		u64 thresh = div64_u64(stat->ps.total * (100 - iolat->lat_pct),
+				       100);
 		thresh = max(thresh, 1ULL);
 		return stat->ps.missed < thresh;
 	}
@@ -836,6 +841,7 @@ static ssize_t iolatency_set_limit(struct kernfs_open_file *of, char *buf,
 	struct iolatency_grp *iolat;
 	char *p, *tok;
 	u64 lat_val = 0;
+	unsigned int lat_pct;
 	u64 oldval;
 	int ret;
 
@@ -860,6 +866,7 @@ static ssize_t iolatency_set_limit(struct kernfs_open_file *of, char *buf,
 		goto out;
 
 	iolat = blkg_to_lat(ctx.blkg);
+	lat_pct = iolat->lat_pct;
 	p = ctx.body;
 
 	ret = -EINVAL;
@@ -879,6 +886,10 @@ static ssize_t iolatency_set_limit(struct kernfs_open_file *of, char *buf,
 				lat_val = v * NSEC_PER_USEC;
 			else
 				goto out;
+		} else if (!strcmp(key, "pct")) {
+			if (sscanf(val, "%u", &lat_pct) != 1 ||
+			    !lat_pct || lat_pct > 99)
+				goto out;
 		} else {
 			goto out;
 		}
@@ -887,6 +898,7 @@ static ssize_t iolatency_set_limit(struct kernfs_open_file *of, char *buf,
 	/* Walk up the tree to see if our new val is lower than it should be. */
 	blkg = ctx.blkg;
 	oldval = iolat->min_lat_nsec;
+	WRITE_ONCE(iolat->lat_pct, lat_pct);
 
 	iolatency_set_min_lat_nsec(blkg, lat_val);
 	if (oldval != iolat->min_lat_nsec)
@@ -905,8 +917,11 @@ static u64 iolatency_prfill_limit(struct seq_file *sf,
 
 	if (!dname || !iolat->min_lat_nsec)
 		return 0;
-	seq_printf(sf, "%s target=%llu\n",
+	seq_printf(sf, "%s target=%llu",
 		   dname, div_u64(iolat->min_lat_nsec, NSEC_PER_USEC));
+	if (iolat->ssd)
+		seq_printf(sf, " pct=%u", iolat->lat_pct);
+	seq_putc(sf, '\n');
 	return 0;
 }
 
@@ -995,6 +1010,7 @@ static void iolatency_pd_init(struct blkg_policy_data *pd)
 		iolat->ssd = true;
 	else
 		iolat->ssd = false;
+	iolat->lat_pct = BLKIOLATENCY_DFL_PCT;
 
 	for_each_possible_cpu(cpu) {
 		struct latency_stat *stat;
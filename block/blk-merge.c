@@ -753,7 +753,7 @@ static struct request *attempt_merge(struct request_queue *q,
 
 	req->__data_len += blk_rq_bytes(next);
 
-	if (!blk_discard_mergable(req))
+	if (!blk_discard_mergable(req) && q->elevator)
 		elv_merge_requests(q, req, next);
 
 	blk_crypto_rq_put_keyslot(next);
@@ -843,6 +843,20 @@ enum elv_merge blk_try_merge(struct request *rq, struct bio *bio)
 	return ELEVATOR_NO_MERGE;
 }
 
+/*
+ * Cheap pre-filter for blk_try_merge(): can @bio be merged with @rq
+ * based on position alone?
+ */
+static inline bool blk_rq_bio_adjacent(struct request *rq, struct bio *bio)
+{
+	sector_t sector = bio->bi_iter.bi_sector;
+
+	if (blk_discard_mergable(rq))
+		return true;
+	return blk_rq_pos(rq) + blk_rq_sectors(rq) == sector ||
+		blk_rq_pos(rq) - bio_sectors(bio) == sector;
+}
+
 static void blk_account_io_merge_bio(struct request *req)
 {
 	if (req->rq_flags & RQF_IO_STAT) {
@@ -976,9 +990,11 @@ static enum bio_merge_status blk_attempt_bio_merge(struct request_queue *q,
  * @nr_segs: number of segments in @bio
  * from the passed in @q already in the plug list
  *
- * Determine whether @bio being queued on @q can be merged with the previous
- * request on %current's plugged list.  Returns %true if merge was successful,
- * otherwise %false.
+ * Determine whether @bio being queued on @q can be merged with a request
+ * on %current's plugged list.  The most recently plugged request is tried
+ * first; if @bio isn't contiguous with it, the remaining requests for @q
+ * are searched for a sector-adjacent one.  Returns %true if merge was
+ * successful, otherwise %false.
  *
  * Plugging coalesces IOs from the same issuer for the same purpose without
  * going through @q->queue_lock.  As such it's more of an issuing mechanism
@@ -999,19 +1015,32 @@ bool blk_attempt_plug_merge(struct request_queue *q, struct bio *bio,
 		return false;
 
 	rq = plug->mq_list.tail;
-	if (rq->q == q)
-		return blk_attempt_bio_merge(q, rq, bio, nr_segs, false) ==
-			BIO_MERGE_OK;
-	else if (!plug->multiple_queues)
+	if (rq->q == q) {
+		switch (blk_attempt_bio_merge(q, rq, bio, nr_segs, false)) {
+		case BIO_MERGE_OK:
+			return true;
+		case BIO_MERGE_FAILED:
+			return false;
+		case BIO_MERGE_NONE:
+			break;
+		}
+	} else if (!plug->multiple_queues) {
 		return false;
+	}
 
+	/*
+	 * The tail didn't match, which is common when several streams are
+	 * interleaved in one plug.  The plug is bounded by
+	 * blk_plug_max_rq_count(), so walk it, but only bother with the full
+	 * merge checks for requests that are sector-adjacent to @bio.
+	 */
 	rq_list_for_each(&plug->mq_list, rq) {
-		if (rq->q != q)
+		if (rq->q != q || rq == plug->mq_list.tail)
 			continue;
-		if (blk_attempt_bio_merge(q, rq, bio, nr_segs, false) ==
-		    BIO_MERGE_OK)
-			return true;
-		break;
+		if (!blk_rq_bio_adjacent(rq, bio))
+			continue;
+		return blk_attempt_bio_merge(q, rq, bio, nr_segs, false) ==
+			BIO_MERGE_OK;
 	}
 	return false;
 }
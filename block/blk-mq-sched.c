@@ -485,6 +485,8 @@ int blk_mq_init_sched(struct request_queue *q, struct elevator_type *e)
 		ret = blk_mq_sched_alloc_map_and_rqs(q, hctx, i);
 		if (ret)
 			goto err_free_map_and_rqs;
+		/* driver tags are no longer allocated from the tag cache */
+		blk_mq_tag_cache_drain(hctx->tags);
 	}
 
 	ret = e->ops.init_sched(q, e);
@@ -14,6 +14,91 @@
 #include "blk-mq.h"
 #include "blk-mq-sched.h"
 
+/*
+ * Small per-cpu magazine of free tags. Allocations without an I/O scheduler
+ * on queues that don't share their tags refill it from the sbitmap in
+ * batches and frees return to it, so that the sbitmap words aren't bounced
+ * between CPUs for every request. Cached tags look allocated to the sbitmap,
+ * so they are handed back whenever someone has to wait for a tag.
+ */
+#define BLK_MQ_TAG_CACHE_SIZE	8
+
+struct blk_mq_tag_cache {
+	spinlock_t lock;
+	unsigned int nr;
+	int tags[BLK_MQ_TAG_CACHE_SIZE];
+};
+
+static bool blk_mq_tag_cache_usable(struct blk_mq_alloc_data *data,
+				    struct blk_mq_tags *tags)
+{
+	return tags->pcpu_cache && !data->q->elevator && !data->shallow_depth &&
+		!(data->flags & BLK_MQ_REQ_RESERVED) &&
+		!(data->hctx->flags & BLK_MQ_F_TAG_QUEUE_SHARED);
+}
+
+static int blk_mq_tag_cache_get(struct blk_mq_tags *tags)
+{
+	struct blk_mq_tag_cache *cache;
+	unsigned long flags;
+	int tag = BLK_MQ_NO_TAG;
+
+	local_irq_save(flags);
+	cache = this_cpu_ptr(tags->pcpu_cache);
+	spin_lock(&cache->lock);
+	if (!cache->nr) {
+		unsigned int offset, bit;
+		unsigned long mask;
+
+		mask = __sbitmap_queue_get_batch(&tags->bitmap_tags,
+						 BLK_MQ_TAG_CACHE_SIZE, &offset);
+		for_each_set_bit(bit, &mask, BITS_PER_LONG)
+			cache->tags[cache->nr++] = offset + bit;
+	}
+	if (cache->nr)
+		tag = cache->tags[--cache->nr];
+	spin_unlock(&cache->lock);
+	local_irq_restore(flags);
+
+	return tag;
+}
+
+/*
+ * Return all cached tags to the sbitmap, waking up anyone waiting for them.
+ * Called before sleeping for a tag and whenever the tags are reconfigured.
+ */
+void blk_mq_tag_cache_drain(struct blk_mq_tags *tags)
+{
+	int cpu;
+
+	if (!tags->pcpu_cache)
+		return;
+
+	/*
+	 * Order a waiter's ws_active increment before the cache locks below.
+	 * blk_mq_put_tag_cached() checks ws_active under the same lock, so
+	 * either it sees the waiter and doesn't cache, or we see its tag.
+	 */
+	smp_mb();
+
+	for_each_possible_cpu(cpu) {
+		struct blk_mq_tag_cache *cache = per_cpu_ptr(tags->pcpu_cache, cpu);
+		int batch[BLK_MQ_TAG_CACHE_SIZE];
+		unsigned long flags;
+		unsigned int nr;
+
+		spin_lock_irqsave(&cache->lock, flags);
+		nr = cache->nr;
+		memcpy(batch, cache->tags, nr * sizeof(batch[0]));
+		cache->nr = 0;
+		spin_unlock_irqrestore(&cache->lock, flags);
+
+		if (nr)
+			sbitmap_queue_clear_batch(&tags->bitmap_tags, 0,
+						  batch, nr);
+	}
+}
+
 /*
  * Recalculate wakeup batch when tag is shared by hctx.
  */
@@ -152,6 +237,12 @@ unsigned int blk_mq_get_tag(struct blk_mq_alloc_data *data)
 		tag_offset = tags->nr_reserved_tags;
 	}
 
+	if (blk_mq_tag_cache_usable(data, tags)) {
+		tag = blk_mq_tag_cache_get(tags);
+		if (tag != BLK_MQ_NO_TAG)
+			goto found_tag;
+	}
+
 	tag = __blk_mq_get_tag(data, bt);
 	if (tag != BLK_MQ_NO_TAG)
 		goto found_tag;
@@ -180,6 +271,14 @@ unsigned int blk_mq_get_tag(struct blk_mq_alloc_data *data)
 
 		sbitmap_prepare_to_wait(bt, ws, &wait, TASK_UNINTERRUPTIBLE);
 
+		/*
+		 * Free tags may be sitting in other CPUs' caches. Now that
+		 * we're counted as a waiter nothing new gets cached, flush
+		 * them back and retry.
+		 */
+		if (bt == &tags->bitmap_tags)
+			blk_mq_tag_cache_drain(tags);
+
 		tag = __blk_mq_get_tag(data, bt);
 		if (tag != BLK_MQ_NO_TAG)
 			break;
@@ -235,6 +334,39 @@ void blk_mq_put_tag(struct blk_mq_tags *tags, struct blk_mq_ctx *ctx,
 	}
 }
 
+/*
+ * Like blk_mq_put_tag(), but keep the tag in the per-cpu cache if possible.
+ * Only for tags allocated without an I/O scheduler from a hctx whose tags
+ * aren't shared, see blk_mq_tag_cache_usable().
+ */
+void blk_mq_put_tag_cached(struct blk_mq_tags *tags, struct blk_mq_ctx *ctx,
+			   unsigned int tag)
+{
+	struct blk_mq_tag_cache *cache;
+	unsigned long flags;
+	bool cached = false;
+
+	if (!tags->pcpu_cache || blk_mq_tag_is_reserved(tags, tag)) {
+		blk_mq_put_tag(tags, ctx, tag);
+		return;
+	}
+
+	local_irq_save(flags);
+	cache = this_cpu_ptr(tags->pcpu_cache);
+	spin_lock(&cache->lock);
+	/* Paired with the smp_mb() in blk_mq_tag_cache_drain() */
+	if (!atomic_read(&tags->bitmap_tags.ws_active) &&
+	    cache->nr < BLK_MQ_TAG_CACHE_SIZE) {
+		cache->tags[cache->nr++] = tag - tags->nr_reserved_tags;
+		cached = true;
+	}
+	spin_unlock(&cache->lock);
+	local_irq_restore(flags);
+
+	if (!cached)
+		blk_mq_put_tag(tags, ctx, tag);
+}
+
 void blk_mq_put_tags(struct blk_mq_tags *tags, int *tag_array, int nr_tags)
 {
 	sbitmap_queue_clear_batch(&tags->bitmap_tags, tags->nr_reserved_tags,
@@ -567,8 +699,25 @@ struct blk_mq_tags *blk_mq_init_tags(unsigned int total_tags,
 	if (bt_alloc(&tags->breserved_tags, reserved_tags, round_robin, node))
 		goto out_free_bitmap_tags;
 
+	/*
+	 * Caching is pointless without enough tags to go around, and tags
+	 * shared by all hardware queues need fair sharing instead.
+	 */
+	if (!(flags & BLK_MQ_F_TAG_HCTX_SHARED) &&
+	    depth >= 4 * BLK_MQ_TAG_CACHE_SIZE) {
+		int cpu;
+
+		tags->pcpu_cache = alloc_percpu(struct blk_mq_tag_cache);
+		if (!tags->pcpu_cache)
+			goto out_free_reserved_tags;
+		for_each_possible_cpu(cpu)
+			spin_lock_init(&per_cpu_ptr(tags->pcpu_cache, cpu)->lock);
+	}
+
 	return tags;
 
+out_free_reserved_tags:
+	sbitmap_queue_free(&tags->breserved_tags);
 out_free_bitmap_tags:
 	sbitmap_queue_free(&tags->bitmap_tags);
 out_free_tags:
@@ -578,6 +727,7 @@ struct blk_mq_tags *blk_mq_init_tags(unsigned int total_tags,
 
 void blk_mq_free_tags(struct blk_mq_tags *tags)
 {
+	free_percpu(tags->pcpu_cache);
 	sbitmap_queue_free(&tags->bitmap_tags);
 	sbitmap_queue_free(&tags->breserved_tags);
 	kfree(tags);
@@ -628,6 +778,7 @@ int blk_mq_tag_update_depth(struct blk_mq_hw_ctx *hctx,
 		 * Don't need (or can't) update reserved tags here, they
 		 * remain static and should never need resizing.
 		 */
+		blk_mq_tag_cache_drain(tags);
 		sbitmap_queue_resize(&tags->bitmap_tags,
 				tdepth - tags->nr_reserved_tags);
 	}
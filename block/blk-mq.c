@@ -159,6 +159,20 @@ static bool blk_unfreeze_check_owner(struct request_queue *q)
 }
 #endif
 
+/*
+ * Hand the tags parked in the per-cpu tag caches back to the sbitmap, so
+ * that a frozen or quiesced queue, or an hctx going offline, holds no tags
+ * other than those of live requests.
+ */
+static void blk_mq_queue_tag_cache_drain(struct request_queue *q)
+{
+	struct blk_mq_hw_ctx *hctx;
+	unsigned long i;
+
+	queue_for_each_hw_ctx(q, hctx, i)
+		blk_mq_tag_cache_drain(hctx->tags);
+}
+
 bool __blk_freeze_queue_start(struct request_queue *q,
 			      struct task_struct *owner)
 {
@@ -188,15 +202,21 @@ EXPORT_SYMBOL_GPL(blk_freeze_queue_start);
 void blk_mq_freeze_queue_wait(struct request_queue *q)
 {
 	wait_event(q->mq_freeze_wq, percpu_ref_is_zero(&q->q_usage_counter));
+	blk_mq_queue_tag_cache_drain(q);
 }
 EXPORT_SYMBOL_GPL(blk_mq_freeze_queue_wait);
 
 int blk_mq_freeze_queue_wait_timeout(struct request_queue *q,
 				     unsigned long timeout)
 {
-	return wait_event_timeout(q->mq_freeze_wq,
-					percpu_ref_is_zero(&q->q_usage_counter),
-					timeout);
+	int ret;
+
+	ret = wait_event_timeout(q->mq_freeze_wq,
+				 percpu_ref_is_zero(&q->q_usage_counter),
+				 timeout);
+	if (ret)
+		blk_mq_queue_tag_cache_drain(q);
+	return ret;
 }
 EXPORT_SYMBOL_GPL(blk_mq_freeze_queue_wait_timeout);
 
@@ -299,8 +319,10 @@ void blk_mq_quiesce_queue(struct request_queue *q)
 {
 	blk_mq_quiesce_queue_nowait(q);
 	/* nothing to wait for non-mq queues */
-	if (queue_is_mq(q))
+	if (queue_is_mq(q)) {
 		blk_mq_wait_quiesce_done(q->tag_set);
+		blk_mq_queue_tag_cache_drain(q);
+	}
 }
 EXPORT_SYMBOL_GPL(blk_mq_quiesce_queue);
 
@@ -779,7 +801,12 @@ static void __blk_mq_free_request(struct request *rq)
 
 	if (rq->tag != BLK_MQ_NO_TAG) {
 		blk_mq_dec_active_requests(hctx);
-		blk_mq_put_tag(hctx->tags, ctx, rq->tag);
+		if (sched_tag == BLK_MQ_NO_TAG &&
+		    !(hctx->flags & BLK_MQ_F_TAG_QUEUE_SHARED) &&
+		    !test_bit(BLK_MQ_S_INACTIVE, &hctx->state))
+			blk_mq_put_tag_cached(hctx->tags, ctx, rq->tag);
+		else
+			blk_mq_put_tag(hctx->tags, ctx, rq->tag);
 	}
 	if (sched_tag != BLK_MQ_NO_TAG)
 		blk_mq_put_tag(hctx->sched_tags, ctx, sched_tag);
@@ -2553,12 +2580,49 @@ static void blk_mq_request_bypass_insert(struct request *rq, blk_insert_t flags)
 	spin_unlock(&hctx->lock);
 }
 
+/*
+ * How many requests at the tail of a software queue are looked at when
+ * trying to merge a newly inserted request into one that is still waiting
+ * for dispatch.
+ */
+#define BLK_MQ_INSERT_MERGE_DEPTH	8
+
+/*
+ * Without an I/O scheduler, requests from different plugs only meet in the
+ * software queue once the hardware queue is busy.  Try to back merge @rq into
+ * one of the requests queued there, so that concurrent submitters streaming
+ * to adjacent sectors end up as fewer, larger commands.  Called with
+ * ctx->lock held.
+ */
+static bool blk_mq_ctx_attempt_insert_merge(struct request_queue *q,
+		struct list_head *head, struct request *rq,
+		struct list_head *free)
+{
+	struct request *pos;
+	int depth = 0;
+
+	list_for_each_entry_reverse(pos, head, queuelist) {
+		if (++depth > BLK_MQ_INSERT_MERGE_DEPTH)
+			break;
+		if (blk_rq_pos(pos) + blk_rq_sectors(pos) != blk_rq_pos(rq))
+			continue;
+		if (blk_attempt_req_merge(q, pos, rq)) {
+			list_add(&rq->queuelist, free);
+			return true;
+		}
+		break;
+	}
+	return false;
+}
+
 static void blk_mq_insert_requests(struct blk_mq_hw_ctx *hctx,
 		struct blk_mq_ctx *ctx, struct list_head *list,
 		bool run_queue_async)
 {
-	struct request *rq;
+	struct request_queue *q = hctx->queue;
+	struct request *rq, *next;
 	enum hctx_type type = hctx->type;
+	LIST_HEAD(free);
 
 	/*
 	 * Try to issue requests directly if the hw queue isn't busy to save an
@@ -2583,9 +2647,21 @@ static void blk_mq_insert_requests(struct blk_mq_hw_ctx *hctx,
 	}
 
 	spin_lock(&ctx->lock);
-	list_splice_tail_init(list, &ctx->rq_lists[type]);
+	if (!blk_queue_nomerges(q) && !q->elevator &&
+	    !list_empty(&ctx->rq_lists[type])) {
+		list_for_each_entry_safe(rq, next, list, queuelist) {
+			list_del_init(&rq->queuelist);
+			if (!blk_mq_ctx_attempt_insert_merge(q,
+					&ctx->rq_lists[type], rq, &free))
+				list_add_tail(&rq->queuelist,
+					      &ctx->rq_lists[type]);
+		}
+	} else {
+		list_splice_tail_init(list, &ctx->rq_lists[type]);
+	}
 	blk_mq_hctx_mark_pending(hctx, ctx);
 	spin_unlock(&ctx->lock);
+	blk_mq_free_requests(&free);
 out:
 	blk_mq_run_hw_queue(hctx, run_queue_async);
 }
@@ -3727,10 +3803,16 @@ static int blk_mq_hctx_notify_offline(unsigned int cpu, struct hlist_node *node)
 	 * Try to grab a reference to the queue and wait for any outstanding
 	 * requests.  If we could not grab a reference the queue has been
 	 * frozen and there are no requests.
+	 *
+	 * Requests freed on an inactive hctx don't park their tag in the
+	 * per-cpu caches, but ones cached before may still be, drain them.
 	 */
 	if (percpu_ref_tryget(&hctx->queue->q_usage_counter)) {
-		while (blk_mq_hctx_has_requests(hctx))
+		blk_mq_tag_cache_drain(hctx->tags);
+		while (blk_mq_hctx_has_requests(hctx)) {
 			msleep(5);
+			blk_mq_tag_cache_drain(hctx->tags);
+		}
 		percpu_ref_put(&hctx->queue->q_usage_counter);
 	}
 
@@ -4264,6 +4346,8 @@ static void queue_set_hctx_shared(struct request_queue *q, bool shared)
 	queue_for_each_hw_ctx(q, hctx, i) {
 		if (shared) {
 			hctx->flags |= BLK_MQ_F_TAG_QUEUE_SHARED;
+			/* shared tags are distributed by hctx_may_queue() */
+			blk_mq_tag_cache_drain(hctx->tags);
 		} else {
 			blk_mq_tag_idle(hctx);
 			hctx->flags &= ~BLK_MQ_F_TAG_QUEUE_SHARED;
@@ -47,6 +47,87 @@ void blk_rq_stat_add(struct blk_rq_stat *stat, u64 value)
 	stat->nr_samples++;
 }
 
+static unsigned int blk_rq_stat_hist_bucket(u64 value)
+{
+	u64 units = value >> BLK_STAT_HIST_UNIT_SHIFT;
+	unsigned int msb, shift;
+
+	if (units < (1U << BLK_STAT_HIST_SUB_BITS))
+		return units;
+
+	msb = fls64(units) - 1;
+	if (msb > BLK_STAT_HIST_MAX_SHIFT)
+		return BLK_STAT_HIST_BUCKETS - 1;
+
+	/* the top BLK_STAT_HIST_SUB_BITS + 1 bits select the bucket */
+	shift = msb - BLK_STAT_HIST_SUB_BITS;
+	return (shift << BLK_STAT_HIST_SUB_BITS) + (units >> shift);
+}
+
+/* Return the largest latency in nsecs that is counted in @bucket. */
+u64 blk_rq_stat_hist_bucket_max(unsigned int bucket)
+{
+	unsigned int shift;
+	u64 top;
+
+	if (bucket >= BLK_STAT_HIST_BUCKETS - 1)
+		return U64_MAX;
+	if (bucket < (1U << BLK_STAT_HIST_SUB_BITS))
+		return ((u64)(bucket + 1) << BLK_STAT_HIST_UNIT_SHIFT) - 1;
+
+	shift = (bucket >> BLK_STAT_HIST_SUB_BITS) - 1;
+	top = bucket - ((u64)shift << BLK_STAT_HIST_SUB_BITS);
+	return ((top + 1) << (shift + BLK_STAT_HIST_UNIT_SHIFT)) - 1;
+}
+
+void blk_rq_stat_hist_init(struct blk_rq_stat_hist *hist)
+{
+	memset(hist, 0, sizeof(*hist));
+}
+
+void blk_rq_stat_hist_sum(struct blk_rq_stat_hist *dst,
+			  struct blk_rq_stat_hist *src)
+{
+	unsigned int i;
+
+	if (!src->nr_samples)
+		return;
+
+	for (i = 0; i < BLK_STAT_HIST_BUCKETS; i++)
+		dst->buckets[i] += src->buckets[i];
+	dst->nr_samples += src->nr_samples;
+}
+
+void blk_rq_stat_hist_add(struct blk_rq_stat_hist *hist, u64 value)
+{
+	hist->buckets[blk_rq_stat_hist_bucket(value)]++;
+	hist->nr_samples++;
+}
+
+/*
+ * Return an upper bound of the @pct'th percentile latency in nsecs, or 0 if
+ * there are no samples.
+ */
+u64 blk_rq_stat_hist_percentile(const struct blk_rq_stat_hist *hist,
+				unsigned int pct)
+{
+	u64 target, seen = 0;
+	unsigned int i;
+
+	if (!hist->nr_samples)
+		return 0;
+
+	target = DIV_ROUND_UP_ULL((u64)hist->nr_samples * min(pct, 100U), 100);
+	target = max(target, 1ULL);
+
+	for (i = 0; i < BLK_STAT_HIST_BUCKETS; i++) {
+		seen += hist->buckets[i];
+		if (seen >= target)
+			return blk_rq_stat_hist_bucket_max(i);
+	}
+	return U64_MAX;
+}
+
 void blk_stat_add(struct request *rq, u64 now)
 {
 	struct request_queue *q = rq->q;
@@ -69,6 +150,10 @@ void blk_stat_add(struct request *rq, u64 now)
 
 		stat = &per_cpu_ptr(cb->cpu_stat, cpu)[bucket];
 		blk_rq_stat_add(stat, value);
+
+		if (cb->cpu_hist)
+			blk_rq_stat_hist_add(&per_cpu_ptr(cb->cpu_hist, cpu)[bucket],
+					     value);
 	}
 	put_cpu();
 	rcu_read_unlock();
@@ -93,6 +178,22 @@ static void blk_stat_timer_fn(struct timer_list *t)
 		}
 	}
 
+	if (cb->cpu_hist) {
+		for (bucket = 0; bucket < cb->buckets; bucket++)
+			blk_rq_stat_hist_init(&cb->hist[bucket]);
+
+		for_each_online_cpu(cpu) {
+			struct blk_rq_stat_hist *cpu_hist;
+
+			cpu_hist = per_cpu_ptr(cb->cpu_hist, cpu);
+			for (bucket = 0; bucket < cb->buckets; bucket++) {
+				blk_rq_stat_hist_sum(&cb->hist[bucket],
+						     &cpu_hist[bucket]);
+				blk_rq_stat_hist_init(&cpu_hist[bucket]);
+			}
+		}
+	}
+
 	cb->timer_fn(cb);
 }
 
@@ -125,11 +226,30 @@ blk_stat_alloc_callback(void (*timer_fn)(struct blk_stat_callback *),
 	cb->bucket_fn = bucket_fn;
 	cb->data = data;
 	cb->buckets = buckets;
+	cb->cpu_hist = NULL;
+	cb->hist = NULL;
 	timer_setup(&cb->timer, blk_stat_timer_fn, 0);
 
 	return cb;
 }
 
+int blk_stat_enable_hist(struct blk_stat_callback *cb)
+{
+	cb->hist = kcalloc(cb->buckets, sizeof(struct blk_rq_stat_hist),
+			   GFP_KERNEL);
+	if (!cb->hist)
+		return -ENOMEM;
+	cb->cpu_hist = __alloc_percpu(cb->buckets *
+				      sizeof(struct blk_rq_stat_hist),
+				      __alignof__(struct blk_rq_stat_hist));
+	if (!cb->cpu_hist) {
+		kfree(cb->hist);
+		cb->hist = NULL;
+		return -ENOMEM;
+	}
+	return 0;
+}
+
 void blk_stat_add_callback(struct request_queue *q,
 			   struct blk_stat_callback *cb)
 {
@@ -143,6 +263,11 @@ void blk_stat_add_callback(struct request_queue *q,
 		cpu_stat = per_cpu_ptr(cb->cpu_stat, cpu);
 		for (bucket = 0; bucket < cb->buckets; bucket++)
 			blk_rq_stat_init(&cpu_stat[bucket]);
+
+		if (!cb->cpu_hist)
+			continue;
+		for (bucket = 0; bucket < cb->buckets; bucket++)
+			blk_rq_stat_hist_init(&per_cpu_ptr(cb->cpu_hist, cpu)[bucket]);
 	}
 
 	spin_lock_irqsave(&q->stats->lock, flags);
@@ -170,6 +295,8 @@ static void blk_stat_free_callback_rcu(struct rcu_head *head)
 	struct blk_stat_callback *cb;
 
 	cb = container_of(head, struct blk_stat_callback, rcu);
+	free_percpu(cb->cpu_hist);
+	kfree(cb->hist);
 	free_percpu(cb->cpu_stat);
 	kfree(cb->stat);
 	kfree(cb);
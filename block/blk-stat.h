@@ -8,6 +8,24 @@
 #include <linux/rcupdate.h>
 #include <linux/timer.h>
 
+/*
+ * Log-linear latency histogram. Latencies are counted in units of
+ * 2^BLK_STAT_HIST_UNIT_SHIFT nsecs (~1us); each power of two is split into
+ * 2^BLK_STAT_HIST_SUB_BITS linear buckets, which bounds the relative error of
+ * a percentile to 1/8. The last bucket collects everything above ~16s.
+ */
+#define BLK_STAT_HIST_UNIT_SHIFT	10
+#define BLK_STAT_HIST_SUB_BITS		3
+#define BLK_STAT_HIST_MAX_SHIFT		24
+#define BLK_STAT_HIST_BUCKETS		\
+	((BLK_STAT_HIST_MAX_SHIFT - BLK_STAT_HIST_SUB_BITS + 2) << \
+	 BLK_STAT_HIST_SUB_BITS)
+
+struct blk_rq_stat_hist {
+	u32 nr_samples;
+	u32 buckets[BLK_STAT_HIST_BUCKETS];
+};
+
 /**
  * struct blk_stat_callback - Block statistics callback.
  *
@@ -49,6 +67,17 @@ struct blk_stat_callback {
 	 */
 	struct blk_rq_stat *stat;
 
+	/**
+	 * @cpu_hist: Optional per-cpu latency histograms, one per bucket.
+	 */
+	struct blk_rq_stat_hist __percpu *cpu_hist;
+
+	/**
+	 * @hist: Latency histograms, one per bucket. Only valid if
+	 * blk_stat_enable_hist() was called for this callback.
+	 */
+	struct blk_rq_stat_hist *hist;
+
 	/**
 	 * @fn: Callback function.
 	 */
@@ -87,6 +116,14 @@ blk_stat_alloc_callback(void (*timer_fn)(struct blk_stat_callback *),
 			int (*bucket_fn)(const struct request *),
 			unsigned int buckets, void *data);
 
+/**
+ * blk_stat_enable_hist() - Also collect latency histograms for a callback.
+ * @cb: The callback, must not have been added to a queue yet.
+ *
+ * Return: 0 on success or -ENOMEM.
+ */
+int blk_stat_enable_hist(struct blk_stat_callback *cb);
+
 /**
  * blk_stat_add_callback() - Add a block statistics callback to be run on a
  * request queue.
@@ -169,4 +206,11 @@ void blk_rq_stat_add(struct blk_rq_stat *, u64);
 void blk_rq_stat_sum(struct blk_rq_stat *, struct blk_rq_stat *);
 void blk_rq_stat_init(struct blk_rq_stat *);
 
+void blk_rq_stat_hist_add(struct blk_rq_stat_hist *, u64);
+void blk_rq_stat_hist_sum(struct blk_rq_stat_hist *, struct blk_rq_stat_hist *);
+void blk_rq_stat_hist_init(struct blk_rq_stat_hist *);
+u64 blk_rq_stat_hist_bucket_max(unsigned int bucket);
+u64 blk_rq_stat_hist_percentile(const struct blk_rq_stat_hist *,
+				unsigned int pct);
+
 #endif
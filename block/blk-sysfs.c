@@ -633,6 +633,44 @@ static ssize_t queue_wb_lat_store(struct gendisk *disk, const char *page,
 }
 
 QUEUE_RW_ENTRY(queue_wb_lat, "wbt_lat_usec");
+
+static ssize_t queue_wb_lat_pct_show(struct gendisk *disk, char *page)
+{
+	ssize_t ret;
+	struct request_queue *q = disk->queue;
+
+	mutex_lock(&disk->rqos_state_mutex);
+	if (!wbt_rq_qos(q))
+		ret = -EINVAL;
+	else
+		ret = sysfs_emit(page, "%u\n", wbt_get_lat_pct(q));
+	mutex_unlock(&disk->rqos_state_mutex);
+	return ret;
+}
+
+static ssize_t queue_wb_lat_pct_store(struct gendisk *disk, const char *page,
+				      size_t count)
+{
+	struct request_queue *q = disk->queue;
+	unsigned long pct;
+	ssize_t ret;
+
+	ret = queue_var_store(&pct, page, count);
+	if (ret < 0)
+		return ret;
+	if (pct > 100)
+		return -EINVAL;
+
+	mutex_lock(&disk->rqos_state_mutex);
+	if (!wbt_rq_qos(q))
+		ret = -EINVAL;
+	else
+		wbt_set_lat_pct(q, pct);
+	mutex_unlock(&disk->rqos_state_mutex);
+	return ret;
+}
+
+QUEUE_RW_ENTRY(queue_wb_lat_pct, "wbt_lat_pct");
 #endif
 
 /* Common attributes for bio-based and request-based queues. */
@@ -702,6 +740,7 @@ static struct attribute *blk_mq_queue_attrs[] = {
 	&queue_requests_entry.attr,
 #ifdef CONFIG_BLK_WBT
 	&queue_wb_lat_entry.attr,
+	&queue_wb_lat_pct_entry.attr,
 #endif
 	/*
 	 * Attributes which don't require locking.
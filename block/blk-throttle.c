@@ -823,6 +823,39 @@ static unsigned long tg_within_bps_limit(struct throtl_grp *tg, struct bio *bio,
 	return jiffy_wait;
 }
 
+/*
+ * Token bucket style bursting: give a group that has been idle for @idle
+ * jiffies the budget it didn't use, capped at its burst size, by starting
+ * the new slice with negative dispatch counts, the same way carryover is
+ * represented.
+ */
+static void tg_start_slice_with_burst(struct throtl_grp *tg, bool rw,
+				      unsigned long idle)
+{
+	u64 bps_limit = tg_bps_limit(tg, rw);
+	u32 iops_limit = tg_iops_limit(tg, rw);
+	u64 bytes = 0;
+	unsigned int ios = 0;
+
+	if (tg->bps_burst[rw] && bps_limit != U64_MAX) {
+		bytes = min(calculate_bytes_allowed(bps_limit, idle),
+			    tg->bps_burst[rw]);
+		bytes = min_t(u64, bytes, S64_MAX);
+		tg->bytes_disp[rw] = -(s64)bytes;
+	}
+	if (tg->iops_burst[rw] && iops_limit != UINT_MAX) {
+		ios = min(calculate_io_allowed(iops_limit, idle),
+			  tg->iops_burst[rw]);
+		ios = min_t(unsigned int, ios, INT_MAX);
+		tg->io_disp[rw] = -(int)ios;
+	}
+
+	if (bytes || ios)
+		throtl_log(&tg->service_queue,
+			   "[%c] burst credit bytes=%llu io=%u idle=%lu",
+			   rw == READ ? 'R' : 'W', bytes, ios, idle);
+}
+
 static void throtl_charge_bps_bio(struct throtl_grp *tg, struct bio *bio)
 {
 	unsigned int bio_size = throtl_bio_data_size(bio);
@@ -850,10 +883,17 @@ static void throtl_charge_iops_bio(struct throtl_grp *tg, struct bio *bio)
 static void tg_update_slice(struct throtl_grp *tg, bool rw)
 {
 	if (throtl_slice_used(tg, rw) &&
-	    sq_queued(&tg->service_queue, rw) == 0)
+	    sq_queued(&tg->service_queue, rw) == 0) {
+		unsigned long idle = 0;
+
+		if (time_after(jiffies, tg->slice_end[rw]))
+			idle = jiffies - tg->slice_end[rw];
 		throtl_start_new_slice(tg, rw, true);
-	else
+		if (idle)
+			tg_start_slice_with_burst(tg, rw, idle);
+	} else {
 		throtl_extend_slice(tg, rw, jiffies + tg->td->throtl_slice);
+	}
 }
 
 static unsigned long tg_dispatch_bps_time(struct throtl_grp *tg, struct bio *bio)
@@ -1510,7 +1550,9 @@ static u64 tg_prfill_limit(struct seq_file *sf, struct blkg_policy_data *pd,
 	if (tg->bps[READ] == bps_dft &&
 	    tg->bps[WRITE] == bps_dft &&
 	    tg->iops[READ] == iops_dft &&
-	    tg->iops[WRITE] == iops_dft)
+	    tg->iops[WRITE] == iops_dft &&
+	    !tg->bps_burst[READ] && !tg->bps_burst[WRITE] &&
+	    !tg->iops_burst[READ] && !tg->iops_burst[WRITE])
 		return 0;
 
 	seq_printf(sf, "%s", dname);
@@ -1534,6 +1576,15 @@ static u64 tg_prfill_limit(struct seq_file *sf, struct blkg_policy_data *pd,
 	else
 		seq_printf(sf, " wiops=%u", tg->iops[WRITE]);
 
+	if (tg->bps_burst[READ])
+		seq_printf(sf, " rbps_burst=%llu", tg->bps_burst[READ]);
+	if (tg->bps_burst[WRITE])
+		seq_printf(sf, " wbps_burst=%llu", tg->bps_burst[WRITE]);
+	if (tg->iops_burst[READ])
+		seq_printf(sf, " riops_burst=%u", tg->iops_burst[READ]);
+	if (tg->iops_burst[WRITE])
+		seq_printf(sf, " wiops_burst=%u", tg->iops_burst[WRITE]);
+
 	seq_printf(sf, "\n");
 	return 0;
 }
@@ -1551,7 +1602,7 @@ static ssize_t tg_set_limit(struct kernfs_open_file *of,
 	struct blkcg *blkcg = css_to_blkcg(of_css(of));
 	struct blkg_conf_ctx ctx;
 	struct throtl_grp *tg;
-	u64 v[4];
+	u64 v[4], burst[4];
 	int ret;
 
 	blkg_conf_init(&ctx, buf);
@@ -1577,14 +1628,18 @@ static ssize_t tg_set_limit(struct kernfs_open_file *of,
 	v[1] = tg->bps[WRITE];
 	v[2] = tg->iops[READ];
 	v[3] = tg->iops[WRITE];
+	burst[0] = tg->bps_burst[READ];
+	burst[1] = tg->bps_burst[WRITE];
+	burst[2] = tg->iops_burst[READ];
+	burst[3] = tg->iops_burst[WRITE];
 
 	while (true) {
-		char tok[27];	/* wiops=18446744073709551616 */
+		char tok[33];	/* wiops_burst=18446744073709551616 */
 		char *p;
 		u64 val = U64_MAX;
 		int len;
 
-		if (sscanf(ctx.body, "%26s%n", tok, &len) != 1)
+		if (sscanf(ctx.body, "%32s%n", tok, &len) != 1)
 			break;
 		if (tok[0] == '\0')
 			break;
@@ -1596,6 +1651,17 @@ static ssize_t tg_set_limit(struct kernfs_open_file *of,
 		if (!p || (sscanf(p, "%llu", &val) != 1 && strcmp(p, "max")))
 			goto out_finish;
 
+		/* a burst of 0 disables bursting, "max" is not meaningful */
+		if (!strcmp(tok, "rbps_burst") || !strcmp(tok, "wbps_burst") ||
+		    !strcmp(tok, "riops_burst") || !strcmp(tok, "wiops_burst")) {
+			int i = (tok[0] == 'w') + 2 * (tok[1] == 'i');
+
+			if (!strcmp(p, "max"))
+				goto out_finish;
+			burst[i] = i < 2 ? val : min_t(u64, val, UINT_MAX);
+			continue;
+		}
+
 		ret = -ERANGE;
 		if (!val)
 			goto out_finish;
@@ -1617,6 +1683,10 @@ static ssize_t tg_set_limit(struct kernfs_open_file *of,
 	tg->bps[WRITE] = v[1];
 	tg->iops[READ] = v[2];
 	tg->iops[WRITE] = v[3];
+	tg->bps_burst[READ] = burst[0];
+	tg->bps_burst[WRITE] = burst[1];
+	tg->iops_burst[READ] = burst[2];
+	tg->iops_burst[WRITE] = burst[3];
 
 	tg_conf_updated(tg, false);
 	ret = 0;
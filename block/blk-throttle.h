@@ -109,6 +109,14 @@ struct throtl_grp {
 	/* IOPS limits */
 	unsigned int iops[2];
 
+	/*
+	 * Burst sizes, 0 if bursting is disabled. While a group is idle it
+	 * accumulates credit at its configured rate, up to these amounts,
+	 * which it can spend above the rate limit once it becomes busy again.
+	 */
+	uint64_t bps_burst[2];
+	unsigned int iops_burst[2];
+
 	/*
 	 * Number of bytes/bio's dispatched in current slice.
 	 * When new configuration is submitted while some bios are still throttled,
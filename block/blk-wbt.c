@@ -88,6 +88,7 @@ struct rq_wb {
 	unsigned long last_issue;		/* last non-throttled issue */
 	unsigned long last_comp;		/* last non-throttled comp */
 	unsigned long min_lat_nsec;
+	unsigned int lat_pct;			/* 0: compare min latency */
 	struct rq_qos rqos;
 	struct rq_wait rq_wait[WBT_NUM_RWQ];
 	struct rq_depth rq_depth;
@@ -340,10 +341,16 @@ static int latency_exceeded(struct rq_wb *rwb, struct blk_rq_stat *stat)
 	}
 
 	/*
-	 * If the 'min' latency exceeds our target, step down.
+	 * If the 'min' latency, or the configured read latency percentile,
+	 * exceeds our target, step down.
 	 */
-	if (stat[READ].min > rwb->min_lat_nsec) {
-		trace_wbt_lat(bdi, stat[READ].min);
+	if (rwb->lat_pct)
+		thislat = blk_rq_stat_hist_percentile(&rwb->cb->hist[READ],
+						      rwb->lat_pct);
+	else
+		thislat = stat[READ].min;
+	if (thislat > rwb->min_lat_nsec) {
+		trace_wbt_lat(bdi, thislat);
 		trace_wbt_stat(bdi, stat);
 		return LAT_EXCEEDED;
 	}
@@ -505,6 +512,23 @@ u64 wbt_get_min_lat(struct request_queue *q)
 	return RQWB(rqos)->min_lat_nsec;
 }
 
+unsigned int wbt_get_lat_pct(struct request_queue *q)
+{
+	struct rq_qos *rqos = wbt_rq_qos(q);
+	if (!rqos)
+		return 0;
+	return RQWB(rqos)->lat_pct;
+}
+
+void wbt_set_lat_pct(struct request_queue *q, unsigned int pct)
+{
+	struct rq_qos *rqos = wbt_rq_qos(q);
+	if (!rqos)
+		return;
+
+	WRITE_ONCE(RQWB(rqos)->lat_pct, min(pct, 100U));
+}
+
 void wbt_set_min_lat(struct request_queue *q, u64 val)
 {
 	struct rq_qos *rqos = wbt_rq_qos(q);
@@ -835,6 +859,20 @@ static int wbt_min_lat_nsec_show(void *data, struct seq_file *m)
 	return 0;
 }
 
+static int wbt_read_lat_show(void *data, struct seq_file *m)
+{
+	struct rq_qos *rqos = data;
+	struct rq_wb *rwb = RQWB(rqos);
+	struct blk_rq_stat_hist *hist = &rwb->cb->hist[READ];
+
+	seq_printf(m, "samples=%u p50=%llu p90=%llu p99=%llu\n",
+		   hist->nr_samples,
+		   blk_rq_stat_hist_percentile(hist, 50),
+		   blk_rq_stat_hist_percentile(hist, 90),
+		   blk_rq_stat_hist_percentile(hist, 99));
+	return 0;
+}
+
 static int wbt_unknown_cnt_show(void *data, struct seq_file *m)
 {
 	struct rq_qos *rqos = data;
@@ -868,6 +906,7 @@ static const struct blk_mq_debugfs_attr wbt_debugfs_attrs[] = {
 	{"id", 0400, wbt_id_show},
 	{"inflight", 0400, wbt_inflight_show},
 	{"min_lat_nsec", 0400, wbt_min_lat_nsec_show},
+	{"read_lat_nsec", 0400, wbt_read_lat_show},
 	{"unknown_cnt", 0400, wbt_unknown_cnt_show},
 	{"wb_normal", 0400, wbt_normal_show},
 	{"wb_background", 0400, wbt_background_show},
@@ -905,6 +944,11 @@ int wbt_init(struct gendisk *disk)
 		kfree(rwb);
 		return -ENOMEM;
 	}
+	if (blk_stat_enable_hist(rwb->cb)) {
+		blk_stat_free_callback(rwb->cb);
+		kfree(rwb);
+		return -ENOMEM;
+	}
 
 	for (i = 0; i < WBT_NUM_RWQ; i++)
 		rq_wait_init(&rwb->rq_wait[i]);
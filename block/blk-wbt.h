@@ -10,6 +10,8 @@ void wbt_enable_default(struct gendisk *disk);
 
 u64 wbt_get_min_lat(struct request_queue *q);
 void wbt_set_min_lat(struct request_queue *q, u64 val);
+unsigned int wbt_get_lat_pct(struct request_queue *q);
+void wbt_set_lat_pct(struct request_queue *q, unsigned int pct);
 bool wbt_disabled(struct request_queue *);
 
 u64 wbt_default_latency_nsec(struct request_queue *);
@@ -1148,6 +1148,15 @@ bool blk_zone_plug_bio(struct bio *bio, unsigned int nr_segs)
 	 * Zone append operations for devices that requested emulation must
 	 * also be plugged so that these BIOs can be changed into regular
 	 * write BIOs.
+	 * The reverse, turning plugged regular writes into native zone
+	 * appends to have several of them in flight per zone, is not possible:
+	 * a zone append is written at whatever the device write pointer is
+	 * when the command executes, so appends that are reordered anywhere
+	 * between the plug and the media would store data at sectors other than
+	 * the ones the regular writes targeted. Users wanting more than one
+	 * write in flight per zone must issue REQ_OP_ZONE_APPEND themselves and
+	 * use the written sector returned on completion, which native zone
+	 * append BIOs already allow as they are not plugged.
 	 * Zone reset, reset all and finish commands need special treatment
 	 * to correctly track the write pointer offset of zones. These commands
 	 * are not plugged as we do not need serialization with write
@@ -15,6 +15,8 @@
 #include <linux/compiler.h>
 #include <linux/rbtree.h>
 #include <linux/sbitmap.h>
+#include <linux/percpu.h>
+#include <linux/cpumask.h>
 
 #include <trace/events/block.h>
 
@@ -79,6 +81,16 @@ struct dd_per_prio {
 	struct io_stats_per_prio stats;
 };
 
+/*
+ * Requests inserted without BLK_MQ_INSERT_AT_HEAD are first staged on a
+ * per-CPU list so that inserters do not need dd->lock. The dispatch path
+ * moves them into the sort and fifo lists while it holds dd->lock anyway.
+ */
+struct dd_stage {
+	spinlock_t lock;
+	struct list_head list;
+};
+
 struct deadline_data {
 	/*
 	 * run time data
@@ -100,8 +112,13 @@ struct deadline_data {
 	int front_merges;
 	u32 async_depth;
 	int prio_aging_expire;
+	int stage_inserts;
 
 	spinlock_t lock;
+
+	struct dd_stage __percpu *stage;
+	/* CPUs that may have requests on their dd_stage list. */
+	cpumask_var_t staged;
 };
 
 /* Maps an I/O priority class to a deadline scheduler priority. */
@@ -451,6 +468,44 @@ static struct request *dd_dispatch_prio_aged_requests(struct deadline_data *dd,
 	return NULL;
 }
 
+static void dd_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
+			      blk_insert_t flags, unsigned long insert_time,
+			      struct list_head *free);
+
+/*
+ * Move requests from the per-CPU staging lists into the sort and fifo lists.
+ * The staged requests carry their insertion time in fifo_time, so expiry and
+ * priority aging are computed exactly as if they had been inserted directly.
+ */
+static void dd_drain_stage(struct deadline_data *dd, struct blk_mq_hw_ctx *hctx,
+			   struct list_head *free)
+{
+	int cpu;
+
+	lockdep_assert_held(&dd->lock);
+
+	for_each_cpu(cpu, dd->staged) {
+		struct dd_stage *stage = per_cpu_ptr(dd->stage, cpu);
+		LIST_HEAD(list);
+
+		if (!cpumask_test_and_clear_cpu(cpu, dd->staged))
+			continue;
+
+		spin_lock(&stage->lock);
+		list_splice_init(&stage->list, &list);
+		spin_unlock(&stage->lock);
+
+		while (!list_empty(&list)) {
+			struct request *rq;
+
+			rq = list_first_entry(&list, struct request, queuelist);
+			list_del_init(&rq->queuelist);
+			dd_insert_request(hctx, rq, 0,
+					  (unsigned long)rq->fifo_time, free);
+		}
+	}
+}
+
 /*
  * Called from blk_mq_run_hw_queue() -> __blk_mq_sched_dispatch_requests().
  *
@@ -465,8 +520,12 @@ static struct request *dd_dispatch_request(struct blk_mq_hw_ctx *hctx)
 	const unsigned long now = jiffies;
 	struct request *rq;
 	enum dd_prio prio;
+	LIST_HEAD(free);
 
 	spin_lock(&dd->lock);
+	if (!cpumask_empty(dd->staged))
+		dd_drain_stage(dd, hctx, &free);
+
 	rq = dd_dispatch_prio_aged_requests(dd, now);
 	if (rq)
 		goto unlock;
@@ -484,6 +543,8 @@ static struct request *dd_dispatch_request(struct blk_mq_hw_ctx *hctx)
 unlock:
 	spin_unlock(&dd->lock);
 
+	blk_mq_free_requests(&free);
+
 	return rq;
 }
 
@@ -562,6 +623,9 @@ static void dd_exit_sched(struct elevator_queue *e)
 			  stats->dispatched, atomic_read(&stats->completed));
 	}
 
+	WARN_ON_ONCE(!cpumask_empty(dd->staged));
+	free_cpumask_var(dd->staged);
+	free_percpu(dd->stage);
 	kfree(dd);
 }
 
@@ -574,6 +638,7 @@ static int dd_init_sched(struct request_queue *q, struct elevator_type *e)
 	struct elevator_queue *eq;
 	enum dd_prio prio;
 	int ret = -ENOMEM;
+	int cpu;
 
 	eq = elevator_alloc(q, e);
 	if (!eq)
@@ -583,6 +648,18 @@ static int dd_init_sched(struct request_queue *q, struct elevator_type *e)
 	if (!dd)
 		goto put_eq;
 
+	dd->stage = alloc_percpu(struct dd_stage);
+	if (!dd->stage)
+		goto free_dd;
+	if (!zalloc_cpumask_var(&dd->staged, GFP_KERNEL))
+		goto free_stage;
+	for_each_possible_cpu(cpu) {
+		struct dd_stage *stage = per_cpu_ptr(dd->stage, cpu);
+
+		spin_lock_init(&stage->lock);
+		INIT_LIST_HEAD(&stage->list);
+	}
+
 	eq->elevator_data = dd;
 
 	for (prio = 0; prio <= DD_PRIO_MAX; prio++) {
@@ -601,6 +678,7 @@ static int dd_init_sched(struct request_queue *q, struct elevator_type *e)
 	dd->last_dir = DD_WRITE;
 	dd->fifo_batch = fifo_batch;
 	dd->prio_aging_expire = prio_aging_expire;
+	dd->stage_inserts = 1;
 	spin_lock_init(&dd->lock);
 
 	/* We dispatch from request queue wide instead of hw queue */
@@ -609,6 +687,10 @@ static int dd_init_sched(struct request_queue *q, struct elevator_type *e)
 	q->elevator = eq;
 	return 0;
 
+free_stage:
+	free_percpu(dd->stage);
+free_dd:
+	kfree(dd);
 put_eq:
 	kobject_put(&eq->kobj);
 	return ret;
@@ -667,11 +749,33 @@ static bool dd_bio_merge(struct request_queue *q, struct bio *bio,
 	return ret;
 }
 
+/*
+ * Requests moved from the per-CPU staging lists may arrive slightly out of
+ * order relative to each other. Keep the fifo list sorted by expiry time so
+ * that deadline_check_fifo() only has to look at the first entry.
+ */
+static void dd_add_rq_fifo(struct dd_per_prio *per_prio, struct request *rq,
+			   enum dd_data_dir data_dir)
+{
+	struct list_head *head = &per_prio->fifo_list[data_dir];
+	struct request *pos;
+
+	list_for_each_entry_reverse(pos, head, queuelist) {
+		if (!time_after((unsigned long)pos->fifo_time,
+				(unsigned long)rq->fifo_time)) {
+			list_add(&rq->queuelist, &pos->queuelist);
+			return;
+		}
+	}
+	list_add(&rq->queuelist, head);
+}
+
 /*
  * add rq to rbtree and fifo
  */
 static void dd_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
-			      blk_insert_t flags, struct list_head *free)
+			      blk_insert_t flags, unsigned long insert_time,
+			      struct list_head *free)
 {
 	struct request_queue *q = hctx->queue;
 	struct deadline_data *dd = q->elevator->elevator_data;
@@ -696,7 +800,7 @@ static void dd_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
 
 	if (flags & BLK_MQ_INSERT_AT_HEAD) {
 		list_add(&rq->queuelist, &per_prio->dispatch);
-		rq->fifo_time = jiffies;
+		rq->fifo_time = insert_time;
 	} else {
 		deadline_add_rq_rb(per_prio, rq);
 
@@ -709,8 +813,8 @@ static void dd_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
 		/*
 		 * set expire time and add to fifo list
 		 */
-		rq->fifo_time = jiffies + dd->fifo_expire[data_dir];
-		list_add_tail(&rq->queuelist, &per_prio->fifo_list[data_dir]);
+		rq->fifo_time = insert_time + dd->fifo_expire[data_dir];
+		dd_add_rq_fifo(per_prio, rq, data_dir);
 	}
 }
 
@@ -723,15 +827,35 @@ static void dd_insert_requests(struct blk_mq_hw_ctx *hctx,
 {
 	struct request_queue *q = hctx->queue;
 	struct deadline_data *dd = q->elevator->elevator_data;
+	const unsigned long now = jiffies;
 	LIST_HEAD(free);
 
+	if (READ_ONCE(dd->stage_inserts) && !(flags & BLK_MQ_INSERT_AT_HEAD)) {
+		int cpu = raw_smp_processor_id();
+		struct dd_stage *stage = per_cpu_ptr(dd->stage, cpu);
+		struct request *rq;
+
+		/*
+		 * Record the insertion time in fifo_time; dd_drain_stage()
+		 * turns it into the expiry time once the request is sorted.
+		 */
+		list_for_each_entry(rq, list, queuelist)
+			rq->fifo_time = now;
+
+		spin_lock(&stage->lock);
+		list_splice_tail_init(list, &stage->list);
+		cpumask_set_cpu(cpu, dd->staged);
+		spin_unlock(&stage->lock);
+		return;
+	}
+
 	spin_lock(&dd->lock);
 	while (!list_empty(list)) {
 		struct request *rq;
 
 		rq = list_first_entry(list, struct request, queuelist);
 		list_del_init(&rq->queuelist);
-		dd_insert_request(hctx, rq, flags, &free);
+		dd_insert_request(hctx, rq, flags, now, &free);
 	}
 	spin_unlock(&dd->lock);
 
@@ -772,6 +896,9 @@ static bool dd_has_work(struct blk_mq_hw_ctx *hctx)
 	struct deadline_data *dd = hctx->queue->elevator->elevator_data;
 	enum dd_prio prio;
 
+	if (!cpumask_empty(dd->staged))
+		return true;
+
 	for (prio = 0; prio <= DD_PRIO_MAX; prio++)
 		if (dd_has_work_for_prio(&dd->per_prio[prio]))
 			return true;
@@ -797,6 +924,7 @@ SHOW_INT(deadline_writes_starved_show, dd->writes_starved);
 SHOW_INT(deadline_front_merges_show, dd->front_merges);
 SHOW_INT(deadline_async_depth_show, dd->async_depth);
 SHOW_INT(deadline_fifo_batch_show, dd->fifo_batch);
+SHOW_INT(deadline_stage_inserts_show, dd->stage_inserts);
 #undef SHOW_INT
 #undef SHOW_JIFFIES
 
@@ -827,6 +955,7 @@ STORE_INT(deadline_writes_starved_store, &dd->writes_starved, INT_MIN, INT_MAX);
 STORE_INT(deadline_front_merges_store, &dd->front_merges, 0, 1);
 STORE_INT(deadline_async_depth_store, &dd->async_depth, 1, INT_MAX);
 STORE_INT(deadline_fifo_batch_store, &dd->fifo_batch, 0, INT_MAX);
+STORE_INT(deadline_stage_inserts_store, &dd->stage_inserts, 0, 1);
 #undef STORE_FUNCTION
 #undef STORE_INT
 #undef STORE_JIFFIES
@@ -842,6 +971,7 @@ static const struct elv_fs_entry deadline_attrs[] = {
 	DD_ATTR(async_depth),
 	DD_ATTR(fifo_batch),
 	DD_ATTR(prio_aging_expire),
+	DD_ATTR(stage_inserts),
 	__ATTR_NULL
 };
 
@@ -79,6 +79,7 @@ struct loop_device {
 struct loop_cmd {
 	struct list_head list_entry;
 	bool use_aio; /* use AIO interface to handle I/O */
+	bool nowait_failed; /* NOWAIT attempt got -EAGAIN, use the worker */
 	atomic_t ref; /* only for aio */
 	long ret;
 	struct kiocb iocb;
@@ -276,6 +277,15 @@ static void lo_complete_rq(struct request *rq)
 	struct loop_cmd *cmd = blk_mq_rq_to_pdu(rq);
 	blk_status_t ret = BLK_STS_OK;
 
+	/* NOWAIT I/O that could only fail late, retry it from the worker */
+	if (cmd->ret == -EAGAIN && cmd->use_aio &&
+	    (cmd->iocb.ki_flags & IOCB_NOWAIT)) {
+		cmd->ret = 0;
+		cmd->nowait_failed = true;
+		blk_mq_requeue_request(rq, true);
+		return;
+	}
+
 	if (cmd->ret < 0 || cmd->ret == blk_rq_bytes(rq) ||
 	    req_op(rq) != REQ_OP_READ) {
 		if (cmd->ret < 0)
@@ -327,8 +337,13 @@ static void lo_rw_aio_complete(struct kiocb *iocb, long ret)
 	lo_rw_aio_do_completion(cmd);
 }
 
+/*
+ * With @nowait, nothing may block and -EAGAIN is returned, with @cmd left
+ * untouched, if the backing file would have to, so that the caller can
+ * punt the command to the worker instead.
+ */
 static int lo_rw_aio(struct loop_device *lo, struct loop_cmd *cmd,
-		     loff_t pos, int rw)
+		     loff_t pos, int rw, bool nowait)
 {
 	struct iov_iter iter;
 	struct req_iterator rq_iter;
@@ -347,9 +362,9 @@ static int lo_rw_aio(struct loop_device *lo, struct loop_cmd *cmd,
 	if (rq->bio != rq->biotail) {
 
 		bvec = kmalloc_array(nr_bvec, sizeof(struct bio_vec),
-				     GFP_NOIO);
+				     nowait ? GFP_NOWAIT : GFP_NOIO);
 		if (!bvec)
-			return -EIO;
+			return nowait ? -EAGAIN : -EIO;
 		cmd->bvec = bvec;
 
 		/*
@@ -384,17 +399,36 @@ static int lo_rw_aio(struct loop_device *lo, struct loop_cmd *cmd,
 	if (cmd->use_aio) {
 		cmd->iocb.ki_complete = lo_rw_aio_complete;
 		cmd->iocb.ki_flags = IOCB_DIRECT;
+		if (nowait)
+			cmd->iocb.ki_flags |= IOCB_NOWAIT;
 	} else {
 		cmd->iocb.ki_complete = NULL;
 		cmd->iocb.ki_flags = 0;
 	}
 
 	if (rw == ITER_SOURCE) {
-		kiocb_start_write(&cmd->iocb);
-		ret = file->f_op->write_iter(&cmd->iocb, &iter);
+		struct super_block *sb = file_inode(file)->i_sb;
+
+		if (!nowait) {
+			kiocb_start_write(&cmd->iocb);
+			ret = file->f_op->write_iter(&cmd->iocb, &iter);
+		} else if (sb_start_write_trylock(sb)) {
+			__sb_writers_release(sb, SB_FREEZE_WRITE);
+			ret = file->f_op->write_iter(&cmd->iocb, &iter);
+			if (ret == -EAGAIN)
+				kiocb_end_write(&cmd->iocb);
+		} else {
+			ret = -EAGAIN;
+		}
 	} else
 		ret = file->f_op->read_iter(&cmd->iocb, &iter);
 
+	if (nowait && ret == -EAGAIN) {
+		kfree(cmd->bvec);
+		cmd->bvec = NULL;
+		return -EAGAIN;
+	}
+
 	lo_rw_aio_do_completion(cmd);
 
 	if (ret != -EIOCBQUEUED)
@@ -422,9 +456,9 @@ static int do_req_filebacked(struct loop_device *lo, struct request *rq)
 	case REQ_OP_DISCARD:
 		return lo_fallocate(lo, rq, pos, FALLOC_FL_PUNCH_HOLE);
 	case REQ_OP_WRITE:
-		return lo_rw_aio(lo, cmd, pos, ITER_SOURCE);
+		return lo_rw_aio(lo, cmd, pos, ITER_SOURCE, false);
 	case REQ_OP_READ:
-		return lo_rw_aio(lo, cmd, pos, ITER_DEST);
+		return lo_rw_aio(lo, cmd, pos, ITER_DEST, false);
 	default:
 		WARN_ON_ONCE(1);
 		return -EIO;
@@ -1811,10 +1845,65 @@ static const struct kernel_param_ops loop_hw_qdepth_param_ops = {
 device_param_cb(hw_queue_depth, &loop_hw_qdepth_param_ops, &hw_queue_depth, 0444);
 MODULE_PARM_DESC(hw_queue_depth, "Queue depth for each hardware queue. Default: " __stringify(LOOP_DEFAULT_HW_Q_DEPTH));
 
+static bool nowait_dio;
+module_param(nowait_dio, bool, 0444);
+MODULE_PARM_DESC(nowait_dio, "Try direct I/O with IOCB_NOWAIT from the submitting context (makes ->queue_rq blocking). Default: false");
+
 MODULE_DESCRIPTION("Loopback device support");
 MODULE_LICENSE("GPL");
 MODULE_ALIAS_BLOCKDEV_MAJOR(LOOP_MAJOR);
 
+/*
+ * Direct I/O reads and writes are first issued with IOCB_NOWAIT right
+ * from ->queue_rq, which saves the hop to the worker and lets
+ * submissions from different CPUs reach the backing file in parallel.
+ * Only the worker can charge I/O to the originating cgroups, so this is
+ * limited to commands that would go to the root worker anyway.
+ */
+static bool loop_try_nowait(struct loop_device *lo, struct loop_cmd *cmd)
+{
+	struct request *rq = blk_mq_rq_from_pdu(cmd);
+	loff_t pos = ((loff_t) blk_rq_pos(rq) << 9) + lo->lo_offset;
+	struct cgroup_subsys_state *cmd_memcg_css = cmd->memcg_css;
+	int rw;
+
+	/* NOWAIT file I/O may still sleep briefly, needs a blocking hctx */
+	if (!(lo->tag_set.flags & BLK_MQ_F_BLOCKING))
+		return false;
+	if (cmd->nowait_failed) {
+		cmd->nowait_failed = false;
+		return false;
+	}
+	if (!cmd->use_aio || !queue_on_root_worker(cmd->blkcg_css))
+		return false;
+	if (!(lo->lo_backing_file->f_mode & FMODE_NOWAIT))
+		return false;
+
+	switch (req_op(rq)) {
+	case REQ_OP_READ:
+		rw = ITER_DEST;
+		break;
+	case REQ_OP_WRITE:
+		if (lo->lo_flags & LO_FLAGS_READ_ONLY)
+			return false;
+		rw = ITER_SOURCE;
+		break;
+	default:
+		return false;
+	}
+
+	/*
+	 * Unless -EAGAIN is returned, the command may already have completed
+	 * and been reused, so don't touch it afterwards.
+	 */
+	if (lo_rw_aio(lo, cmd, pos, rw, true) == -EAGAIN)
+		return false;
+
+	if (cmd_memcg_css)
+		css_put(cmd_memcg_css);
+	return true;
+}
+
 static blk_status_t loop_queue_rq(struct blk_mq_hw_ctx *hctx,
 		const struct blk_mq_queue_data *bd)
 {
@@ -1853,6 +1942,9 @@ static blk_status_t loop_queue_rq(struct blk_mq_hw_ctx *hctx,
 #endif
 	}
 #endif
+	if (loop_try_nowait(lo, cmd))
+		return BLK_STS_OK;
+
 	loop_queue_work(lo, cmd);
 
 	return BLK_STS_OK;
@@ -2003,6 +2095,9 @@ static int loop_add(int i)
 	lo->tag_set.numa_node = NUMA_NO_NODE;
 	lo->tag_set.cmd_size = sizeof(struct loop_cmd);
 	lo->tag_set.flags = BLK_MQ_F_STACKING | BLK_MQ_F_NO_SCHED_BY_DEFAULT;
+	/* ->queue_rq may issue NOWAIT I/O, which can still briefly sleep */
+	if (nowait_dio)
+		lo->tag_set.flags |= BLK_MQ_F_BLOCKING;
 	lo->tag_set.driver_data = lo;
 
 	err = blk_mq_alloc_tag_set(&lo->tag_set);
@@ -63,6 +63,7 @@ struct nbd_sock {
 	int fallback_index;
 	int cookie;
 	struct work_struct work;
+	atomic64_t inflight_bytes;	/* sent, reply not received yet */
 };
 
 struct recv_thread_args {
@@ -85,6 +86,7 @@ struct link_dead_args {
 #define NBD_RT_BOUND			5
 #define NBD_RT_DISCONNECT_ON_CLOSE	6
 #define NBD_RT_HAS_BACKEND_FILE		7
+#define NBD_RT_LEAST_LOADED		8
 
 #define NBD_DESTROY_ON_DISCONNECT	0
 #define NBD_DISCONNECT_REQUESTED	1
@@ -154,6 +156,8 @@ struct nbd_cmd {
 	blk_status_t status;
 	unsigned long flags;
 	u32 cmd_cookie;
+	struct nbd_sock *inflight_sock;	/* charged with inflight_bytes */
+	u32 inflight_bytes;
 };
 
 #if IS_ENABLED(CONFIG_DEBUG_FS)
@@ -181,6 +185,20 @@ static inline struct device *nbd_to_dev(struct nbd_device *nbd)
 	return disk_to_dev(nbd->disk);
 }
 
+/*
+ * Give back the bytes a sent request was charged to its connection. Called
+ * with cmd->lock held wherever NBD_CMD_INFLIGHT is cleared.
+ */
+static void nbd_cmd_uncharge(struct nbd_cmd *cmd)
+{
+	lockdep_assert_held(&cmd->lock);
+
+	if (!cmd->inflight_sock)
+		return;
+	atomic64_sub(cmd->inflight_bytes, &cmd->inflight_sock->inflight_bytes);
+	cmd->inflight_sock = NULL;
+}
+
 static void nbd_requeue_cmd(struct nbd_cmd *cmd)
 {
 	struct request *req = blk_mq_rq_from_pdu(cmd);
@@ -195,6 +213,7 @@ static void nbd_requeue_cmd(struct nbd_cmd *cmd)
 	 * time.
 	 */
 	__clear_bit(NBD_CMD_INFLIGHT, &cmd->flags);
+	nbd_cmd_uncharge(cmd);
 
 	if (!test_and_set_bit(NBD_CMD_REQUEUED, &cmd->flags))
 		blk_mq_requeue_request(req, true);
@@ -472,6 +491,7 @@ static enum blk_eh_timer_return nbd_xmit_timeout(struct request *req)
 	if (!config) {
 		cmd->status = BLK_STS_TIMEOUT;
 		__clear_bit(NBD_CMD_INFLIGHT, &cmd->flags);
+		nbd_cmd_uncharge(cmd);
 		mutex_unlock(&cmd->lock);
 		goto done;
 	}
@@ -540,6 +560,7 @@ static enum blk_eh_timer_return nbd_xmit_timeout(struct request *req)
 	set_bit(NBD_RT_TIMEDOUT, &config->runtime_flags);
 	cmd->status = BLK_STS_IOERR;
 	__clear_bit(NBD_CMD_INFLIGHT, &cmd->flags);
+	nbd_cmd_uncharge(cmd);
 	mutex_unlock(&cmd->lock);
 	sock_shutdown(nbd);
 	nbd_config_put(nbd);
@@ -781,6 +802,9 @@ static blk_status_t nbd_send_cmd(struct nbd_device *nbd, struct nbd_cmd *cmd,
 	trace_nbd_payload_sent(req, handle);
 	nsock->pending = NULL;
 	nsock->sent = 0;
+	cmd->inflight_bytes = blk_rq_bytes(req);
+	cmd->inflight_sock = nsock;
+	atomic64_add(cmd->inflight_bytes, &nsock->inflight_bytes);
 	__set_bit(NBD_CMD_INFLIGHT, &cmd->flags);
 	return BLK_STS_OK;
 
@@ -1007,6 +1031,8 @@ static void recv_work(struct work_struct *work)
 			mutex_lock(&cmd->lock);
 			complete = __test_and_clear_bit(NBD_CMD_INFLIGHT,
 							&cmd->flags);
+			if (complete)
+				nbd_cmd_uncharge(cmd);
 			mutex_unlock(&cmd->lock);
 			if (complete)
 				blk_mq_complete_request(rq);
@@ -1037,6 +1063,7 @@ static bool nbd_clear_req(struct request *req, void *data)
 		mutex_unlock(&cmd->lock);
 		return true;
 	}
+	nbd_cmd_uncharge(cmd);
 	cmd->status = BLK_STS_IOERR;
 	mutex_unlock(&cmd->lock);
 
@@ -1111,6 +1138,35 @@ static int wait_for_reconnect(struct nbd_device *nbd)
 	return !test_bit(NBD_RT_DISCONNECTED, &config->runtime_flags);
 }
 
+/*
+ * Pick the live connection with the fewest bytes in flight, preferring
+ * @index on ties.  This is only a hint: the chosen socket is rechecked
+ * under its tx_lock and the usual fallback applies if it died since.
+ */
+static int nbd_least_loaded_sock(struct nbd_config *config, int index)
+{
+	s64 best = atomic64_read(&config->socks[index]->inflight_bytes);
+	int i, best_index = index;
+
+	if (READ_ONCE(config->socks[index]->dead))
+		best = S64_MAX;
+
+	for (i = 0; i < config->num_connections; i++) {
+		struct nbd_sock *nsock = config->socks[i];
+		s64 bytes;
+
+		if (i == index || READ_ONCE(nsock->dead) ||
+		    READ_ONCE(nsock->pending))
+			continue;
+		bytes = atomic64_read(&nsock->inflight_bytes);
+		if (bytes < best) {
+			best = bytes;
+			best_index = i;
+		}
+	}
+	return best_index;
+}
+
 static blk_status_t nbd_handle_cmd(struct nbd_cmd *cmd, int index)
 {
 	struct request *req = blk_mq_rq_from_pdu(cmd);
@@ -1134,6 +1190,9 @@ static blk_status_t nbd_handle_cmd(struct nbd_cmd *cmd, int index)
 		nbd_config_put(nbd);
 		return BLK_STS_IOERR;
 	}
+	if (test_bit(NBD_RT_LEAST_LOADED, &config->runtime_flags) &&
+	    config->num_connections > 1)
+		index = nbd_least_loaded_sock(config, index);
 	cmd->status = BLK_STS_OK;
 again:
 	nsock = config->socks[index];
@@ -1286,6 +1345,7 @@ static int nbd_add_socket(struct nbd_device *nbd, unsigned long arg,
 	nsock->pending = NULL;
 	nsock->sent = 0;
 	nsock->cookie = 0;
+	atomic64_set(&nsock->inflight_bytes, 0);
 	INIT_WORK(&nsock->work, nbd_pending_cmd_work);
 	socks[config->num_connections++] = nsock;
 	atomic_inc(&config->live_connections);
@@ -1796,6 +1856,34 @@ static int nbd_dbg_flags_show(struct seq_file *s, void *unused)
 
 DEFINE_SHOW_ATTRIBUTE(nbd_dbg_flags);
 
+static int nbd_dbg_conns_show(struct seq_file *s, void *unused)
+{
+	struct nbd_device *nbd = s->private;
+	struct nbd_config *config;
+	int i;
+
+	/*
+	 * Removing the debugfs dir waits for readers with config_lock held,
+	 * so don't block on it here.
+	 */
+	if (!mutex_trylock(&nbd->config_lock))
+		return -EBUSY;
+
+	config = nbd->config;
+	for (i = 0; config && i < config->num_connections; i++) {
+		struct nbd_sock *nsock = config->socks[i];
+
+		seq_printf(s, "%d: %s inflight_bytes %lld\n", i,
+			   READ_ONCE(nsock->dead) ? "dead" : "live",
+			   atomic64_read(&nsock->inflight_bytes));
+	}
+	mutex_unlock(&nbd->config_lock);
+
+	return 0;
+}
+
+DEFINE_SHOW_ATTRIBUTE(nbd_dbg_conns);
+
 static int nbd_dev_dbg_init(struct nbd_device *nbd)
 {
 	struct dentry *dir;
@@ -1817,6 +1905,8 @@ static int nbd_dev_dbg_init(struct nbd_device *nbd)
 	debugfs_create_u32("timeout", 0444, dir, &nbd->tag_set.timeout);
 	debugfs_create_u32("blocksize_bits", 0444, dir, &config->blksize_bits);
 	debugfs_create_file("flags", 0444, dir, nbd, &nbd_dbg_flags_fops);
+	debugfs_create_file("connections", 0444, dir, nbd,
+			    &nbd_dbg_conns_fops);
 
 	return 0;
 }
@@ -1872,6 +1962,7 @@ static int nbd_init_request(struct blk_mq_tag_set *set, struct request *rq,
 	struct nbd_cmd *cmd = blk_mq_rq_to_pdu(rq);
 	cmd->nbd = set->driver_data;
 	cmd->flags = 0;
+	cmd->inflight_sock = NULL;
 	mutex_init(&cmd->lock);
 	return 0;
 }
@@ -2166,6 +2257,8 @@ static int nbd_genl_connect(struct sk_buff *skb, struct genl_info *info)
 			set_bit(NBD_RT_DISCONNECT_ON_CLOSE,
 				&config->runtime_flags);
 		}
+		if (flags & NBD_CFLAG_LEAST_LOADED)
+			set_bit(NBD_RT_LEAST_LOADED, &config->runtime_flags);
 	}
 
 	if (info->attrs[NBD_ATTR_SOCKETS]) {
@@ -2379,6 +2472,11 @@ static int nbd_genl_reconfigure(struct sk_buff *skb, struct genl_info *info)
 			clear_bit(NBD_RT_DISCONNECT_ON_CLOSE,
 					&config->runtime_flags);
 		}
+
+		if (flags & NBD_CFLAG_LEAST_LOADED)
+			set_bit(NBD_RT_LEAST_LOADED, &config->runtime_flags);
+		else
+			clear_bit(NBD_RT_LEAST_LOADED, &config->runtime_flags);
 	}
 
 	if (info->attrs[NBD_ATTR_SOCKETS]) {
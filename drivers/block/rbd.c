@@ -346,6 +346,7 @@ struct rbd_img_request {
 	struct pending_result	pending;
 	struct work_struct	work;
 	int			work_result;
+	u64			cache_gen;	/* for reads, see rbd_cache_fill() */
 };
 
 #define for_each_obj_request(ireq, oreq) \
@@ -375,6 +376,32 @@ struct rbd_mapping {
 	u64                     size;
 };
 
+/*
+ * Optional cache of small reads (read_cache_pages=<n> map option).  It is
+ * only enabled while no other client can write to the image: for snapshot
+ * mappings, and for the head while we own the exclusive lock.  Pages are
+ * indexed by image offset and protected by the xarray lock, which also
+ * covers the LRU and the generation count.  The generation is bumped by
+ * every invalidation, so that a read that raced with a write doesn't fill
+ * the cache with stale data.
+ */
+#define RBD_CACHE_MAX_PAGES	4
+
+struct rbd_cache_page {
+	struct list_head	lru;
+	pgoff_t			index;
+	struct page		*page;
+};
+
+struct rbd_read_cache {
+	struct xarray		pages;
+	struct list_head	lru;
+	unsigned int		nr;
+	unsigned int		max;
+	bool			enabled;
+	u64			gen;
+};
+
 /*
  * a single device
  */
@@ -429,6 +456,8 @@ struct rbd_device {
 	u64			object_map_size;	/* in objects */
 	u64			object_map_flags;
 
+	struct rbd_read_cache	read_cache;
+
 	struct workqueue_struct	*task_wq;
 
 	struct rbd_spec		*parent_spec;
@@ -781,6 +810,7 @@ enum {
 	Opt_queue_depth,
 	Opt_alloc_size,
 	Opt_lock_timeout,
+	Opt_read_cache_pages,
 	/* int args above */
 	Opt_pool_ns,
 	Opt_compression_hint,
@@ -815,6 +845,7 @@ static const struct fs_parameter_spec rbd_parameters[] = {
 	fsparam_flag	("notrim",			Opt_notrim),
 	fsparam_string	("_pool_ns",			Opt_pool_ns),
 	fsparam_u32	("queue_depth",			Opt_queue_depth),
+	fsparam_u32	("read_cache_pages",		Opt_read_cache_pages),
 	fsparam_flag	("read_only",			Opt_read_only),
 	fsparam_flag	("read_write",			Opt_read_write),
 	fsparam_flag	("ro",				Opt_read_only),
@@ -826,6 +857,7 @@ struct rbd_options {
 	int	queue_depth;
 	int	alloc_size;
 	unsigned long	lock_timeout;
+	unsigned int	read_cache_pages;
 	bool	read_only;
 	bool	lock_on_read;
 	bool	exclusive;
@@ -1637,6 +1669,190 @@ static void rbd_img_request_destroy(struct rbd_img_request *img_request)
 		kmem_cache_free(rbd_img_request_cache, img_request);
 }
 
+static void rbd_cache_init(struct rbd_read_cache *cache, unsigned int max)
+{
+	xa_init(&cache->pages);
+	INIT_LIST_HEAD(&cache->lru);
+	cache->max = max;
+}
+
+static void __rbd_cache_remove(struct rbd_read_cache *cache,
+			       struct rbd_cache_page *cp)
+{
+	__xa_erase(&cache->pages, cp->index);
+	list_del(&cp->lru);
+	cache->nr--;
+	__free_page(cp->page);
+	kfree(cp);
+}
+
+/*
+ * Drop the cached pages covering [off, off + len), or everything if @len
+ * is 0.
+ */
+static void rbd_cache_invalidate(struct rbd_read_cache *cache, u64 off,
+				 u64 len)
+{
+	struct rbd_cache_page *cp;
+	unsigned long index;
+	pgoff_t first = off >> PAGE_SHIFT;
+	pgoff_t last = len ? (off + len - 1) >> PAGE_SHIFT : ULONG_MAX;
+
+	if (!cache->max)
+		return;
+
+	xa_lock(&cache->pages);
+	cache->gen++;
+	xa_for_each_range(&cache->pages, index, cp, first, last)
+		__rbd_cache_remove(cache, cp);
+	xa_unlock(&cache->pages);
+}
+
+static void rbd_cache_set_enabled(struct rbd_read_cache *cache, bool enabled)
+{
+	if (!cache->max)
+		return;
+
+	rbd_cache_invalidate(cache, 0, 0);
+	WRITE_ONCE(cache->enabled, enabled);
+}
+
+static bool rbd_cache_cacheable(struct rbd_read_cache *cache, u64 off,
+				u64 len)
+{
+	return READ_ONCE(cache->enabled) && PAGE_ALIGNED(off) &&
+	       PAGE_ALIGNED(len) && len <= RBD_CACHE_MAX_PAGES * PAGE_SIZE;
+}
+
+/*
+ * Copy between the request's data and the linear buffer described by
+ * @pages, which covers the request from offset 0.
+ */
+static void rbd_cache_copy(struct request *rq, struct page **pages,
+			   bool to_rq)
+{
+	struct req_iterator iter;
+	struct bio_vec bv;
+	size_t pos = 0;
+
+	rq_for_each_segment(bv, rq, iter) {
+		size_t done = 0;
+
+		while (done < bv.bv_len) {
+			struct page *page = pages[pos >> PAGE_SHIFT];
+			size_t poff = offset_in_page(pos);
+			size_t n = min_t(size_t, bv.bv_len - done,
+					 PAGE_SIZE - poff);
+
+			if (to_rq)
+				memcpy_to_page(bv.bv_page, bv.bv_offset + done,
+					       page_address(page) + poff, n);
+			else
+				memcpy_from_page(page_address(page) + poff,
+						 bv.bv_page,
+						 bv.bv_offset + done, n);
+			done += n;
+			pos += n;
+		}
+	}
+}
+
+/*
+ * Try to serve a read entirely from the cache.  On a miss, the current
+ * generation is recorded in @img_req for rbd_cache_fill().
+ */
+static bool rbd_cache_read(struct rbd_img_request *img_req, u64 off, u64 len)
+{
+	struct rbd_read_cache *cache = &img_req->rbd_dev->read_cache;
+	struct request *rq = blk_mq_rq_from_pdu(img_req);
+	struct rbd_cache_page *cps[RBD_CACHE_MAX_PAGES];
+	struct page *pages[RBD_CACHE_MAX_PAGES];
+	pgoff_t first = off >> PAGE_SHIFT;
+	int i, nr = len >> PAGE_SHIFT;
+
+	if (!rbd_cache_cacheable(cache, off, len))
+		return false;
+
+	xa_lock(&cache->pages);
+	img_req->cache_gen = cache->gen;
+	for (i = 0; i < nr; i++) {
+		cps[i] = xa_load(&cache->pages, first + i);
+		if (!cps[i]) {
+			xa_unlock(&cache->pages);
+			return false;
+		}
+		pages[i] = cps[i]->page;
+	}
+	for (i = 0; i < nr; i++)
+		list_move(&cps[i]->lru, &cache->lru);
+	rbd_cache_copy(rq, pages, true);
+	xa_unlock(&cache->pages);
+
+	return true;
+}
+
+static void rbd_cache_fill(struct rbd_img_request *img_req, u64 off, u64 len)
+{
+	struct rbd_read_cache *cache = &img_req->rbd_dev->read_cache;
+	struct request *rq = blk_mq_rq_from_pdu(img_req);
+	struct rbd_cache_page *cps[RBD_CACHE_MAX_PAGES] = { };
+	struct page *pages[RBD_CACHE_MAX_PAGES];
+	pgoff_t first = off >> PAGE_SHIFT;
+	int i, nr = len >> PAGE_SHIFT;
+
+	if (!rbd_cache_cacheable(cache, off, len) ||
+	    READ_ONCE(cache->gen) != img_req->cache_gen)
+		return;
+
+	for (i = 0; i < nr; i++) {
+		cps[i] = kmalloc(sizeof(*cps[i]), GFP_NOIO | __GFP_NOWARN);
+		if (!cps[i])
+			goto out_free;
+		cps[i]->page = alloc_page(GFP_NOIO | __GFP_NOWARN);
+		if (!cps[i]->page) {
+			kfree(cps[i]);
+			cps[i] = NULL;
+			goto out_free;
+		}
+		cps[i]->index = first + i;
+		pages[i] = cps[i]->page;
+	}
+	rbd_cache_copy(rq, pages, false);
+
+	xa_lock(&cache->pages);
+	if (!cache->enabled || cache->gen != img_req->cache_gen) {
+		xa_unlock(&cache->pages);
+		goto out_free;
+	}
+	for (i = 0; i < nr; i++) {
+		if (xa_load(&cache->pages, cps[i]->index) ||
+		    __xa_store(&cache->pages, cps[i]->index, cps[i],
+			       GFP_NOWAIT))
+			continue;
+		list_add(&cps[i]->lru, &cache->lru);
+		cache->nr++;
+		cps[i] = NULL;
+	}
+	while (cache->nr > cache->max)
+		__rbd_cache_remove(cache, list_last_entry(&cache->lru,
+						struct rbd_cache_page, lru));
+	xa_unlock(&cache->pages);
+
+out_free:
+	for (i = 0; i < nr; i++) {
+		if (cps[i]) {
+			__free_page(cps[i]->page);
+			kfree(cps[i]);
+		}
+	}
+}
+
+static void rbd_cache_destroy(struct rbd_read_cache *cache)
+{
+	rbd_cache_invalidate(cache, 0, 0);
+	xa_destroy(&cache->pages);
+}
+
 #define BITS_PER_OBJ	2
 #define OBJS_PER_BYTE	(BITS_PER_BYTE / BITS_PER_OBJ)
 #define OBJ_MASK	((1 << BITS_PER_OBJ) - 1)
@@ -3605,6 +3821,13 @@ static void rbd_img_handle_request(struct rbd_img_request *img_req, int result)
 		}
 	} else {
 		struct request *rq = blk_mq_rq_from_pdu(img_req);
+		struct rbd_read_cache *cache = &img_req->rbd_dev->read_cache;
+		u64 off = (u64)blk_rq_pos(rq) << SECTOR_SHIFT;
+
+		if (rbd_img_is_write(img_req))
+			rbd_cache_invalidate(cache, off, blk_rq_bytes(rq));
+		else if (!result)
+			rbd_cache_fill(img_req, off, blk_rq_bytes(rq));
 
 		rbd_img_request_destroy(img_req);
 		blk_mq_end_request(rq, errno_to_blk_status(result));
@@ -3656,6 +3879,8 @@ static void __rbd_lock(struct rbd_device *rbd_dev, const char *cookie)
 	rbd_dev->lock_state = RBD_LOCK_STATE_LOCKED;
 	strcpy(rbd_dev->lock_cookie, cookie);
 	rbd_set_owner_cid(rbd_dev, &cid);
+	/* whatever the previous owner wrote isn't in the cache */
+	rbd_cache_set_enabled(&rbd_dev->read_cache, true);
 	queue_work(rbd_dev->task_wq, &rbd_dev->acquired_lock_work);
 }
 
@@ -3699,6 +3924,7 @@ static void rbd_unlock(struct rbd_device *rbd_dev)
 		rbd_warn(rbd_dev, "failed to unlock header: %d", ret);
 
 	/* treat errors as the image is unlocked */
+	rbd_cache_set_enabled(&rbd_dev->read_cache, false);
 	rbd_dev->lock_state = RBD_LOCK_STATE_UNLOCKED;
 	rbd_dev->lock_cookie[0] = '\0';
 	rbd_set_owner_cid(rbd_dev, &rbd_empty_cid);
@@ -4752,6 +4978,15 @@ static void rbd_queue_workfn(struct work_struct *work)
 	dout("%s rbd_dev %p img_req %p %s %llu~%llu\n", __func__, rbd_dev,
 	     img_request, obj_op_name(op_type), offset, length);
 
+	if (op_type == OBJ_OP_READ) {
+		if (rbd_cache_read(img_request, offset, length)) {
+			result = 0;
+			goto err_img_request;
+		}
+	} else {
+		rbd_cache_invalidate(&rbd_dev->read_cache, offset, length);
+	}
+
 	if (op_type == OBJ_OP_DISCARD || op_type == OBJ_OP_ZEROOUT)
 		result = rbd_img_fill_nodata(img_request, offset, length);
 	else
@@ -5308,6 +5543,7 @@ static void rbd_dev_free(struct rbd_device *rbd_dev)
 	WARN_ON(rbd_dev->watch_state != RBD_WATCH_STATE_UNREGISTERED);
 	WARN_ON(rbd_dev->lock_state != RBD_LOCK_STATE_UNLOCKED);
 
+	rbd_cache_destroy(&rbd_dev->read_cache);
 	ceph_oid_destroy(&rbd_dev->header_oid);
 	ceph_oloc_destroy(&rbd_dev->header_oloc);
 	kfree(rbd_dev->config_info);
@@ -5378,6 +5614,7 @@ static struct rbd_device *__rbd_dev_create(struct rbd_spec *spec)
 	init_completion(&rbd_dev->quiescing_wait);
 
 	spin_lock_init(&rbd_dev->object_map_lock);
+	rbd_cache_init(&rbd_dev->read_cache, 0);
 
 	rbd_dev->dev.bus = &rbd_bus_type;
 	rbd_dev->dev.type = &rbd_device_type;
@@ -5419,6 +5656,7 @@ static struct rbd_device *rbd_dev_create(struct rbd_client *rbdc,
 	rbd_dev->rbd_client = rbdc;
 	rbd_dev->spec = spec;
 	rbd_dev->opts = opts;
+	rbd_dev->read_cache.max = opts->read_cache_pages;
 
 	dout("%s rbd_dev %p dev_id %d\n", __func__, rbd_dev, rbd_dev->dev_id);
 	return rbd_dev;
@@ -6287,6 +6525,9 @@ static int rbd_parse_param(struct fs_parameter *param,
 			goto out_of_range;
 		opt->lock_timeout = msecs_to_jiffies(result.uint_32 * 1000);
 		break;
+	case Opt_read_cache_pages:
+		opt->read_cache_pages = result.uint_32;
+		break;
 	case Opt_pool_ns:
 		kfree(pctx->spec->pool_ns);
 		pctx->spec->pool_ns = param->string;
@@ -6806,6 +7047,10 @@ static int rbd_dev_device_setup(struct rbd_device *rbd_dev)
 	set_capacity(rbd_dev->disk, rbd_dev->mapping.size / SECTOR_SIZE);
 	set_disk_ro(rbd_dev->disk, rbd_is_ro(rbd_dev));
 
+	/* snapshots are immutable, the head needs the exclusive lock */
+	if (rbd_is_snap(rbd_dev))
+		rbd_cache_set_enabled(&rbd_dev->read_cache, true);
+
 	ret = dev_set_name(&rbd_dev->dev, "%d", rbd_dev->dev_id);
 	if (ret)
 		goto err_out_disk;
@@ -7069,6 +7314,9 @@ static int rbd_dev_refresh(struct rbd_device *rbd_dev)
 		rbd_dev_update_parent(rbd_dev, &pii);
 	up_write(&rbd_dev->header_rwsem);
 
+	/* the image may have been resized, rolled back or flattened */
+	rbd_cache_invalidate(&rbd_dev->read_cache, 0, 0);
+
 out:
 	rbd_parent_info_cleanup(&pii);
 	rbd_image_header_cleanup(&header);
@@ -1431,6 +1431,15 @@ static inline bool ublk_belong_to_same_batch(const struct ublk_io *io,
 		(io->task == io2->task);
 }
 
+/*
+ * Requests are handed to the ublk server in batches: all requests of
+ * @rqlist that belong to the same io_uring context and server task are
+ * dispatched from a single task work run, and their FETCH commands are
+ * completed back to back from it, so io_uring can flush the CQEs
+ * together.  Together with the server submitting its COMMIT_AND_FETCH
+ * commands in one io_uring_enter(), a batch of N requests costs one
+ * kernel/user round trip rather than N.
+ */
 static void ublk_queue_rqs(struct rq_list *rqlist)
 {
 	struct rq_list requeue_list = { };
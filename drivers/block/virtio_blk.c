@@ -41,6 +41,11 @@ static unsigned int poll_queues;
 module_param(poll_queues, uint, 0644);
 MODULE_PARM_DESC(poll_queues, "The number of dedicated virtqueues for polling I/O");
 
+static bool irq_coalesce;
+module_param(irq_coalesce, bool, 0644);
+MODULE_PARM_DESC(irq_coalesce,
+		 "Delay the next completion interrupt while a virtqueue is busy");
+
 static int major;
 static DEFINE_IDA(vd_index_ida);
 
@@ -347,31 +352,69 @@ static inline void virtblk_request_done(struct request *req)
 	blk_mq_end_request(req, status);
 }
 
+static void virtblk_complete_batch(struct io_comp_batch *iob)
+{
+	struct request *req;
+
+	rq_list_for_each(&iob->req_list, req) {
+		virtblk_unmap_data(req, blk_mq_rq_to_pdu(req));
+		virtblk_cleanup_cmd(req);
+	}
+	blk_mq_end_request_batch(iob);
+}
+
+/*
+ * With irq_coalesce, an interrupt that completed at least this many
+ * requests re-arms the callback with virtqueue_enable_cb_delayed(), so the
+ * device only interrupts again once most of the outstanding requests are
+ * done.  Lightly loaded queues keep the immediate notification.
+ */
+#define VIRTBLK_COALESCE_BATCH	8
+
 static void virtblk_done(struct virtqueue *vq)
 {
 	struct virtio_blk *vblk = vq->vdev->priv;
-	bool req_done = false;
+	DEFINE_IO_COMP_BATCH(iob);
+	unsigned int found = 0;
 	int qid = vq->index;
 	struct virtblk_req *vbr;
 	unsigned long flags;
 	unsigned int len;
+	bool rearmed;
 
 	spin_lock_irqsave(&vblk->vqs[qid].lock, flags);
 	do {
+		unsigned int batch = 0;
+
 		virtqueue_disable_cb(vq);
 		while ((vbr = virtqueue_get_buf(vblk->vqs[qid].vq, &len)) != NULL) {
 			struct request *req = blk_mq_rq_from_pdu(vbr);
-
-			if (likely(!blk_should_fake_timeout(req->q)))
-				blk_mq_complete_request(req);
-			req_done = true;
+			u8 status = virtblk_vbr_status(vbr);
+
+			batch++;
+			if (unlikely(blk_should_fake_timeout(req->q)))
+				continue;
+			if (!blk_mq_complete_request_remote(req) &&
+			    !blk_mq_add_to_batch(req, &iob,
+						 status != VIRTIO_BLK_S_OK,
+						 virtblk_complete_batch))
+				virtblk_request_done(req);
 		}
-	} while (!virtqueue_enable_cb(vq));
+		found += batch;
+
+		if (irq_coalesce && batch >= VIRTBLK_COALESCE_BATCH)
+			rearmed = virtqueue_enable_cb_delayed(vq);
+		else
+			rearmed = virtqueue_enable_cb(vq);
+	} while (!rearmed);
 
 	/* In case queue is stopped waiting for more buffers. */
-	if (req_done)
+	if (found)
 		blk_mq_start_stopped_hw_queues(vblk->disk->queue, true);
 	spin_unlock_irqrestore(&vblk->vqs[qid].lock, flags);
+
+	if (!rq_list_empty(&iob.req_list))
+		iob.complete(&iob);
 }
 
 static void virtio_commit_rqs(struct blk_mq_hw_ctx *hctx)
@@ -1183,17 +1226,6 @@ static void virtblk_map_queues(struct blk_mq_tag_set *set)
 	}
 }
 
-static void virtblk_complete_batch(struct io_comp_batch *iob)
-{
-	struct request *req;
-
-	rq_list_for_each(&iob->req_list, req) {
-		virtblk_unmap_data(req, blk_mq_rq_to_pdu(req));
-		virtblk_cleanup_cmd(req);
-	}
-	blk_mq_end_request_batch(iob);
-}
-
 static int virtblk_poll(struct blk_mq_hw_ctx *hctx, struct io_comp_batch *iob)
 {
 	struct virtio_blk *vblk = hctx->queue->queuedata;
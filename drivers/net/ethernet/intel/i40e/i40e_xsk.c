@@ -634,6 +634,7 @@ bool i40e_clean_xdp_tx_irq(struct i40e_vsi *vsi, struct i40e_ring *tx_ring)
 	u32 head_idx = i40e_get_head(tx_ring);
 	struct i40e_tx_buffer *tx_bi;
 	unsigned int ntc;
+	bool done;
 
 	if (head_idx < tx_ring->next_to_clean)
 		head_idx += tx_ring->count;
@@ -674,8 +675,23 @@ bool i40e_clean_xdp_tx_irq(struct i40e_vsi *vsi, struct i40e_ring *tx_ring)
 	i40e_arm_wb(tx_ring, vsi, completed_frames);
 
 out_xmit:
-	if (xsk_uses_need_wakeup(tx_ring->xsk_pool))
-		xsk_set_tx_need_wakeup(tx_ring->xsk_pool);
+	done = i40e_xmit_zc(tx_ring, I40E_DESC_UNUSED(tx_ring));
+	if (!xsk_uses_need_wakeup(bp))
+		return done;
+
+	/* While frames are in flight, their completion interrupt brings us
+	 * back here to pick up new descriptors, so user space does not need
+	 * to kick us. Only ask for a wakeup once the HW ring has drained,
+	 * and look at the Tx ring once more after publishing the flag so
+	 * that descriptors queued in between are not left behind.
+	 */
+	if (tx_ring->next_to_clean != tx_ring->next_to_use) {
+		xsk_clear_tx_need_wakeup(bp);
+		return done;
+	}
+
+	xsk_set_tx_need_wakeup(bp);
+	smp_mb(); /* flag store before re-reading the producer */
 
 	return i40e_xmit_zc(tx_ring, I40E_DESC_UNUSED(tx_ring));
 }
@@ -260,13 +260,22 @@ static unsigned int mc_hash(const struct macvlan_dev *vlan,
 	return hash_32(val, MACVLAN_MC_FILTER_BITS);
 }
 
+/* Clones queued to the backlog with BH off before it is let run again */
+#define MACVLAN_BC_RX_BATCH	64
+
+/*
+ * If @bh_batch is set, the caller runs in process context with BH
+ * disabled, so netif_rx() only queues the clones.  Let the backlog drain
+ * every MACVLAN_BC_RX_BATCH clones so a large fan-out can't overflow it.
+ */
 static void macvlan_broadcast(struct sk_buff *skb,
 			      const struct macvlan_port *port,
 			      struct net_device *src,
-			      enum macvlan_mode mode)
+			      enum macvlan_mode mode, bool bh_batch)
 {
 	const struct ethhdr *eth = eth_hdr(skb);
 	const struct macvlan_dev *vlan;
+	unsigned int queued = 0;
 	struct sk_buff *nskb;
 	unsigned int i;
 	int err;
@@ -291,12 +300,18 @@ static void macvlan_broadcast(struct sk_buff *skb,
 			      netif_rx(nskb);
 		macvlan_count_rx(vlan, skb->len + ETH_HLEN,
 				 err == NET_RX_SUCCESS, true);
+
+		if (bh_batch && ++queued == MACVLAN_BC_RX_BATCH) {
+			local_bh_enable();
+			local_bh_disable();
+			queued = 0;
+		}
 	}
 }
 
 static void macvlan_multicast_rx(const struct macvlan_port *port,
 				 const struct macvlan_dev *src,
-				 struct sk_buff *skb)
+				 struct sk_buff *skb, bool bh_batch)
 {
 	if (!src)
 		/* frame comes from an external address */
@@ -304,19 +319,19 @@ static void macvlan_multicast_rx(const struct macvlan_port *port,
 				  MACVLAN_MODE_PRIVATE |
 				  MACVLAN_MODE_VEPA    |
 				  MACVLAN_MODE_PASSTHRU|
-				  MACVLAN_MODE_BRIDGE);
+				  MACVLAN_MODE_BRIDGE, bh_batch);
 	else if (src->mode == MACVLAN_MODE_VEPA)
 		/* flood to everyone except source */
 		macvlan_broadcast(skb, port, src->dev,
 				  MACVLAN_MODE_VEPA |
-				  MACVLAN_MODE_BRIDGE);
+				  MACVLAN_MODE_BRIDGE, bh_batch);
 	else
 		/*
 		 * flood only to VEPA ports, bridge ports
 		 * already saw the frame on the way out.
 		 */
 		macvlan_broadcast(skb, port, src->dev,
-				  MACVLAN_MODE_VEPA);
+				  MACVLAN_MODE_VEPA, bh_batch);
 }
 
 static void macvlan_process_broadcast(struct work_struct *w)
@@ -335,8 +350,15 @@ static void macvlan_process_broadcast(struct work_struct *w)
 	while ((skb = __skb_dequeue(&list))) {
 		const struct macvlan_dev *src = MACVLAN_SKB_CB(skb)->src;
 
+		/* With BH off, netif_rx() only queues each clone to the
+		 * backlog (or to the RPS target CPU of each macvlan), and
+		 * the fan-out is processed in batches of softirq runs
+		 * instead of one run per port.
+		 */
 		rcu_read_lock();
-		macvlan_multicast_rx(port, src, skb);
+		local_bh_disable();
+		macvlan_multicast_rx(port, src, skb, true);
+		local_bh_enable();
 		rcu_read_unlock();
 
 		if (src)
@@ -487,7 +509,7 @@ static rx_handler_result_t macvlan_handle_frame(struct sk_buff **pskb)
 		if (test_bit(hash, port->bc_filter))
 			macvlan_broadcast_enqueue(port, src, skb);
 		else if (test_bit(hash, port->mc_filter))
-			macvlan_multicast_rx(port, src, skb);
+			macvlan_multicast_rx(port, src, skb, false);
 
 		return RX_HANDLER_PASS;
 	}
@@ -540,7 +562,8 @@ static int macvlan_queue_xmit(struct sk_buff *skb, struct net_device *dev)
 		/* send to other bridge ports directly */
 		if (is_multicast_ether_addr(eth->h_dest)) {
 			skb_reset_mac_header(skb);
-			macvlan_broadcast(skb, port, dev, MACVLAN_MODE_BRIDGE);
+			macvlan_broadcast(skb, port, dev, MACVLAN_MODE_BRIDGE,
+					  false);
 			goto xmit_world;
 		}
 
@@ -503,7 +503,7 @@ static int veth_xdp_xmit(struct net_device *dev, int n,
 			 u32 flags, bool ndo_xmit)
 {
 	struct veth_priv *rcv_priv, *priv = netdev_priv(dev);
-	int i, ret = -ENXIO, nxmit = 0;
+	int i, n_ok, ret = -ENXIO, nxmit = 0;
 	struct net_device *rcv;
 	unsigned int max_len;
 	struct veth_rq *rq;
@@ -526,13 +526,21 @@ static int veth_xdp_xmit(struct net_device *dev, int n,
 
 	max_len = rcv->mtu + rcv->hard_header_len + VLAN_HLEN;
 
-	spin_lock(&rq->xdp_ring.producer_lock);
+	/* Check the frames before taking the producer lock, so that the
+	 * cache misses on their headers are not taken with other senders
+	 * to this ring spinning behind us.
+	 */
 	for (i = 0; i < n; i++) {
-		struct xdp_frame *frame = frames[i];
-		void *ptr = veth_xdp_to_ptr(frame);
+		if (unlikely(xdp_get_frame_len(frames[i]) > max_len))
+			break;
+	}
+	n_ok = i;
+
+	spin_lock(&rq->xdp_ring.producer_lock);
+	for (i = 0; i < n_ok; i++) {
+		void *ptr = veth_xdp_to_ptr(frames[i]);
 
-		if (unlikely(xdp_get_frame_len(frame) > max_len ||
-			     __ptr_ring_produce(&rq->xdp_ring, ptr)))
+		if (unlikely(__ptr_ring_produce(&rq->xdp_ring, ptr)))
 			break;
 		nxmit++;
 	}
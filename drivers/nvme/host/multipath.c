@@ -69,6 +69,7 @@ static const char *nvme_iopolicy_names[] = {
 	[NVME_IOPOLICY_NUMA]	= "numa",
 	[NVME_IOPOLICY_RR]	= "round-robin",
 	[NVME_IOPOLICY_QD]      = "queue-depth",
+	[NVME_IOPOLICY_LAT]	= "latency",
 };
 
 static int iopolicy = NVME_IOPOLICY_NUMA;
@@ -83,6 +84,8 @@ static int nvme_set_iopolicy(const char *val, const struct kernel_param *kp)
 		iopolicy = NVME_IOPOLICY_RR;
 	else if (!strncmp(val, "queue-depth", 11))
 		iopolicy = NVME_IOPOLICY_QD;
+	else if (!strncmp(val, "latency", 7))
+		iopolicy = NVME_IOPOLICY_LAT;
 	else
 		return -EINVAL;
 
@@ -97,7 +100,7 @@ static int nvme_get_iopolicy(char *buf, const struct kernel_param *kp)
 module_param_call(iopolicy, nvme_set_iopolicy, nvme_get_iopolicy,
 	&iopolicy, 0644);
 MODULE_PARM_DESC(iopolicy,
-	"Default multipath I/O policy; 'numa' (default), 'round-robin' or 'queue-depth'");
+	"Default multipath I/O policy; 'numa' (default), 'round-robin', 'queue-depth' or 'latency'");
 
 void nvme_mpath_default_iopolicy(struct nvme_subsystem *subsys)
 {
@@ -181,12 +184,18 @@ void nvme_mpath_start_request(struct request *rq)
 {
 	struct nvme_ns *ns = rq->q->queuedata;
 	struct gendisk *disk = ns->head->disk;
+	int policy = READ_ONCE(ns->head->subsys->iopolicy);
 
-	if (READ_ONCE(ns->head->subsys->iopolicy) == NVME_IOPOLICY_QD) {
+	if (policy == NVME_IOPOLICY_QD || policy == NVME_IOPOLICY_LAT) {
 		atomic_inc(&ns->ctrl->nr_active);
 		nvme_req(rq)->flags |= NVME_MPATH_CNT_ACTIVE;
 	}
 
+	if (policy == NVME_IOPOLICY_LAT && !blk_rq_is_passthrough(rq)) {
+		nvme_req(rq)->lat_start_ns = ktime_get_ns();
+		nvme_req(rq)->flags |= NVME_MPATH_CNT_LATENCY;
+	}
+
 	if (!blk_queue_io_stat(disk->queue) || blk_rq_is_passthrough(rq))
 		return;
 
@@ -196,6 +205,26 @@ void nvme_mpath_start_request(struct request *rq)
 }
 EXPORT_SYMBOL_GPL(nvme_mpath_start_request);
 
+/* weight of a new sample in the latency EWMA is 1 / (1 << shift) */
+#define NVME_LAT_EWMA_SHIFT	3
+
+/*
+ * Fold a completion latency into the per-controller EWMA used by the latency
+ * iopolicy.  Concurrent completions may race and drop a sample, which is fine
+ * for a selection heuristic.
+ */
+static void nvme_mpath_update_latency(struct nvme_ctrl *ctrl, u64 lat)
+{
+	u64 ewma = atomic64_read(&ctrl->lat_ewma_ns);
+
+	if (!ewma)
+		ewma = lat;
+	else
+		ewma = ewma - (ewma >> NVME_LAT_EWMA_SHIFT) +
+			(lat >> NVME_LAT_EWMA_SHIFT);
+	atomic64_set(&ctrl->lat_ewma_ns, ewma);
+}
+
 void nvme_mpath_end_request(struct request *rq)
 {
 	struct nvme_ns *ns = rq->q->queuedata;
@@ -203,6 +232,10 @@ void nvme_mpath_end_request(struct request *rq)
 	if (nvme_req(rq)->flags & NVME_MPATH_CNT_ACTIVE)
 		atomic_dec_if_positive(&ns->ctrl->nr_active);
 
+	if (nvme_req(rq)->flags & NVME_MPATH_CNT_LATENCY)
+		nvme_mpath_update_latency(ns->ctrl,
+				ktime_get_ns() - nvme_req(rq)->lat_start_ns);
+
 	if (!(nvme_req(rq)->flags & NVME_MPATH_IO_STATS))
 		return;
 	bdev_end_io_acct(ns->head->disk->part0, req_op(rq),
@@ -442,6 +475,47 @@ static struct nvme_ns *nvme_queue_depth_path(struct nvme_ns_head *head)
 	return best_opt ? best_opt : best_nonopt;
 }
 
+/*
+ * Pick the path with the lowest expected completion time, estimated as the
+ * latency EWMA of the controller scaled by the requests it already has in
+ * flight.  Paths without samples yet score as the cheapest so that they get
+ * probed.  Optimized paths are always preferred over non-optimized ones.
+ */
+static struct nvme_ns *nvme_latency_path(struct nvme_ns_head *head)
+{
+	struct nvme_ns *best_opt = NULL, *best_nonopt = NULL, *ns;
+	u64 min_cost_opt = U64_MAX, min_cost_nonopt = U64_MAX;
+	u64 cost;
+
+	list_for_each_entry_srcu(ns, &head->list, siblings,
+				 srcu_read_lock_held(&head->srcu)) {
+		if (nvme_path_is_disabled(ns))
+			continue;
+
+		cost = (atomic64_read(&ns->ctrl->lat_ewma_ns) + 1) *
+			((u64)atomic_read(&ns->ctrl->nr_active) + 1);
+
+		switch (ns->ana_state) {
+		case NVME_ANA_OPTIMIZED:
+			if (cost < min_cost_opt) {
+				min_cost_opt = cost;
+				best_opt = ns;
+			}
+			break;
+		case NVME_ANA_NONOPTIMIZED:
+			if (cost < min_cost_nonopt) {
+				min_cost_nonopt = cost;
+				best_nonopt = ns;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return best_opt ? best_opt : best_nonopt;
+}
+
 static inline bool nvme_path_is_optimized(struct nvme_ns *ns)
 {
 	return nvme_ctrl_state(ns->ctrl) == NVME_CTRL_LIVE &&
@@ -466,6 +540,8 @@ inline struct nvme_ns *nvme_find_path(struct nvme_ns_head *head)
 	switch (READ_ONCE(head->subsys->iopolicy)) {
 	case NVME_IOPOLICY_QD:
 		return nvme_queue_depth_path(head);
+	case NVME_IOPOLICY_LAT:
+		return nvme_latency_path(head);
 	case NVME_IOPOLICY_RR:
 		return nvme_round_robin_path(head);
 	default:
@@ -1089,13 +1165,27 @@ static ssize_t queue_depth_show(struct device *dev,
 {
 	struct nvme_ns *ns = nvme_get_ns_from_dev(dev);
 
-	if (ns->head->subsys->iopolicy != NVME_IOPOLICY_QD)
+	if (ns->head->subsys->iopolicy != NVME_IOPOLICY_QD &&
+	    ns->head->subsys->iopolicy != NVME_IOPOLICY_LAT)
 		return 0;
 
 	return sysfs_emit(buf, "%d\n", atomic_read(&ns->ctrl->nr_active));
 }
 DEVICE_ATTR_RO(queue_depth);
 
+static ssize_t latency_ewma_ns_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct nvme_ns *ns = nvme_get_ns_from_dev(dev);
+
+	if (ns->head->subsys->iopolicy != NVME_IOPOLICY_LAT)
+		return 0;
+
+	return sysfs_emit(buf, "%llu\n",
+			  atomic64_read(&ns->ctrl->lat_ewma_ns));
+}
+DEVICE_ATTR_RO(latency_ewma_ns);
+
 static ssize_t numa_nodes_show(struct device *dev, struct device_attribute *attr,
 		char *buf)
 {
@@ -1358,6 +1448,7 @@ int nvme_mpath_init_identify(struct nvme_ctrl *ctrl, struct nvme_id_ctrl *id)
 
 	/* initialize this in the identify path to cover controller resets */
 	atomic_set(&ctrl->nr_active, 0);
+	atomic64_set(&ctrl->lat_ewma_ns, 0);
 
 	if (!ctrl->max_namespaces ||
 	    ctrl->max_namespaces > le32_to_cpu(id->nn)) {
@@ -193,6 +193,7 @@ struct nvme_request {
 	u16			status;
 #ifdef CONFIG_NVME_MULTIPATH
 	unsigned long		start_time;
+	u64			lat_start_ns;
 #endif
 	struct nvme_ctrl	*ctrl;
 };
@@ -207,6 +208,7 @@ enum {
 	NVME_REQ_USERCMD		= (1 << 1),
 	NVME_MPATH_IO_STATS		= (1 << 2),
 	NVME_MPATH_CNT_ACTIVE		= (1 << 3),
+	NVME_MPATH_CNT_LATENCY		= (1 << 4),
 };
 
 static inline struct nvme_request *nvme_req(struct request *req)
@@ -372,6 +374,7 @@ struct nvme_ctrl {
 	struct timer_list anatt_timer;
 	struct work_struct ana_work;
 	atomic_t nr_active;
+	atomic64_t lat_ewma_ns;
 #endif
 
 #ifdef CONFIG_NVME_HOST_AUTH
@@ -421,6 +424,7 @@ enum nvme_iopolicy {
 	NVME_IOPOLICY_NUMA,
 	NVME_IOPOLICY_RR,
 	NVME_IOPOLICY_QD,
+	NVME_IOPOLICY_LAT,
 };
 
 struct nvme_subsystem {
@@ -991,6 +995,7 @@ extern bool multipath;
 extern struct device_attribute dev_attr_ana_grpid;
 extern struct device_attribute dev_attr_ana_state;
 extern struct device_attribute dev_attr_queue_depth;
+extern struct device_attribute dev_attr_latency_ewma_ns;
 extern struct device_attribute dev_attr_numa_nodes;
 extern struct device_attribute dev_attr_delayed_removal_secs;
 extern struct device_attribute subsys_attr_iopolicy;
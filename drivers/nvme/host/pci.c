@@ -117,6 +117,22 @@ static unsigned int poll_queues;
 module_param_cb(poll_queues, &io_queue_count_ops, &poll_queues, 0644);
 MODULE_PARM_DESC(poll_queues, "Number of queues to use for polled IO.");
 
+static unsigned int sq_db_delay_us;
+module_param(sq_db_delay_us, uint, 0644);
+MODULE_PARM_DESC(sq_db_delay_us,
+	"Defer I/O SQ doorbell writes by up to this many microseconds to "
+	"batch them (0 = ring immediately, the default)");
+
+static unsigned int sq_db_batch = 16;
+module_param(sq_db_batch, uint, 0644);
+MODULE_PARM_DESC(sq_db_batch,
+	"Ring a deferred SQ doorbell once this many commands are pending");
+
+static bool descriptor_rings = true;
+module_param(descriptor_rings, bool, 0444);
+MODULE_PARM_DESC(descriptor_rings,
+	"preallocate a small PRP/SGL descriptor per tag for each I/O queue");
+
 static bool noacpi;
 module_param(noacpi, bool, 0444);
 MODULE_PARM_DESC(noacpi, "disable acpi bios quirks");
@@ -233,11 +249,18 @@ struct nvme_queue {
 #define NVMEQ_SQ_CMB		1
 #define NVMEQ_DELETE_ERROR	2
 #define NVMEQ_POLLED		3
+#define NVMEQ_SQ_DB_DEFERRED	4
 	__le32 *dbbuf_sq_db;
 	__le32 *dbbuf_cq_db;
 	__le32 *dbbuf_sq_ei;
 	__le32 *dbbuf_cq_ei;
 	struct completion delete_done;
+	/* one small descriptor per tag, indexed by req->tag: */
+	void *desc_ring;
+	dma_addr_t desc_ring_dma;
+	u32 desc_ring_stride;
+	struct hrtimer sq_db_timer;
+	struct work_struct sq_db_work;
 };
 
 /* bits for iod->flags */
@@ -247,6 +270,9 @@ enum nvme_iod_flags {
 
 	/* uses the small descriptor pool */
 	IOD_SMALL_DESCRIPTOR		= 1U << 1,
+
+	/* uses the per-tag descriptor from the queue's descriptor ring */
+	IOD_RING_DESCRIPTOR		= 1U << 2,
 };
 
 /*
@@ -539,8 +565,47 @@ static void nvme_pci_map_queues(struct blk_mq_tag_set *set)
 	}
 }
 
+static inline void nvme_ring_sq_db(struct nvme_queue *nvmeq)
+{
+	writel(nvmeq->sq_tail, nvmeq->q_db);
+	if (test_bit(NVMEQ_SQ_DB_DEFERRED, &nvmeq->flags))
+		clear_bit(NVMEQ_SQ_DB_DEFERRED, &nvmeq->flags);
+}
+
+/*
+ * Decide whether an MMIO doorbell write for an I/O queue can be pushed out
+ * by up to sq_db_delay_us so that it covers commands submitted shortly after.
+ * This is opt-in as it trades submission latency for fewer MMIO writes, which
+ * mostly pays off on emulated controllers where every doorbell write traps.
+ * Polled queues are never deferred as the submitter is about to spin on the
+ * CQ.  Must be called with sq_lock held.
+ */
+static bool nvme_sq_db_defer(struct nvme_queue *nvmeq)
+{
+	unsigned int delay = READ_ONCE(sq_db_delay_us);
+	unsigned int pending;
+
+	if (!delay || !nvmeq->qid || test_bit(NVMEQ_POLLED, &nvmeq->flags))
+		return false;
+
+	pending = nvmeq->sq_tail - nvmeq->last_sq_tail;
+	if (nvmeq->sq_tail < nvmeq->last_sq_tail)
+		pending += nvmeq->q_depth;
+	if (pending >= READ_ONCE(sq_db_batch))
+		return false;
+
+	if (!test_and_set_bit(NVMEQ_SQ_DB_DEFERRED, &nvmeq->flags))
+		hrtimer_start(&nvmeq->sq_db_timer, us_to_ktime(delay),
+			      HRTIMER_MODE_REL);
+	return true;
+}
+
 /*
  * Write sq tail if we are asked to, or if the next command would wrap.
+ *
+ * With shadow doorbells the tail is always published to the shadow buffer
+ * right away; only the MMIO write the event index asks for may be deferred.
+ * A doorbell forced by an imminent wrap is never deferred.
  */
 static inline void nvme_write_sq_db(struct nvme_queue *nvmeq, bool write_sq)
 {
@@ -554,11 +619,43 @@ static inline void nvme_write_sq_db(struct nvme_queue *nvmeq, bool write_sq)
 	}
 
 	if (nvme_dbbuf_update_and_check_event(nvmeq->sq_tail,
-			nvmeq->dbbuf_sq_db, nvmeq->dbbuf_sq_ei))
-		writel(nvmeq->sq_tail, nvmeq->q_db);
+			nvmeq->dbbuf_sq_db, nvmeq->dbbuf_sq_ei) ||
+	    test_bit(NVMEQ_SQ_DB_DEFERRED, &nvmeq->flags)) {
+		if (write_sq && nvme_sq_db_defer(nvmeq))
+			return;
+		nvme_ring_sq_db(nvmeq);
+	}
 	nvmeq->last_sq_tail = nvmeq->sq_tail;
 }
 
+static void nvme_sq_db_work(struct work_struct *work)
+{
+	struct nvme_queue *nvmeq =
+		container_of(work, struct nvme_queue, sq_db_work);
+
+	spin_lock(&nvmeq->sq_lock);
+	if (test_bit(NVMEQ_SQ_DB_DEFERRED, &nvmeq->flags)) {
+		nvme_dbbuf_update_and_check_event(nvmeq->sq_tail,
+				nvmeq->dbbuf_sq_db, nvmeq->dbbuf_sq_ei);
+		nvme_ring_sq_db(nvmeq);
+		nvmeq->last_sq_tail = nvmeq->sq_tail;
+	}
+	spin_unlock(&nvmeq->sq_lock);
+}
+
+/*
+ * sq_lock is only ever taken from process context, so punt the actual
+ * doorbell write to a work item instead of taking it from hardirq context.
+ */
+static enum hrtimer_restart nvme_sq_db_timer_fn(struct hrtimer *timer)
+{
+	struct nvme_queue *nvmeq =
+		container_of(timer, struct nvme_queue, sq_db_timer);
+
+	kblockd_schedule_work(&nvmeq->sq_db_work);
+	return HRTIMER_NORESTART;
+}
+
 static inline void nvme_sq_copy_cmd(struct nvme_queue *nvmeq,
 				    struct nvme_command *cmd)
 {
@@ -614,6 +711,27 @@ static inline struct dma_pool *nvme_dma_pool(struct nvme_queue *nvmeq,
 	return nvmeq->descriptor_pools.large;
 }
 
+/*
+ * Allocate the first descriptor for a request.  Small descriptors come from
+ * the queue's per-tag ring when there is one, which needs no locking as the
+ * tag is owned by the request, so the common 8k-128k I/O sizes never touch
+ * the dma_pool shared by all queues of a node.
+ */
+static void *nvme_alloc_first_descriptor(struct nvme_queue *nvmeq,
+		struct request *req, dma_addr_t *dma)
+{
+	struct nvme_iod *iod = blk_mq_rq_to_pdu(req);
+
+	if ((iod->flags & IOD_SMALL_DESCRIPTOR) && nvmeq->desc_ring) {
+		unsigned int offset = req->tag * nvmeq->desc_ring_stride;
+
+		iod->flags |= IOD_RING_DESCRIPTOR;
+		*dma = nvmeq->desc_ring_dma + offset;
+		return nvmeq->desc_ring + offset;
+	}
+	return dma_pool_alloc(nvme_dma_pool(nvmeq, iod), GFP_ATOMIC, dma);
+}
+
 static void nvme_free_descriptors(struct nvme_queue *nvmeq, struct request *req)
 {
 	const int last_prp = NVME_CTRL_PAGE_SIZE / sizeof(__le64) - 1;
@@ -621,6 +739,9 @@ static void nvme_free_descriptors(struct nvme_queue *nvmeq, struct request *req)
 	dma_addr_t dma_addr = iod->first_dma;
 	int i;
 
+	if (iod->flags & IOD_RING_DESCRIPTOR)
+		return;
+
 	if (iod->nr_descriptors == 1) {
 		dma_pool_free(nvme_dma_pool(nvmeq, iod), iod->descriptors[0],
 				dma_addr);
@@ -706,8 +827,7 @@ static blk_status_t nvme_pci_setup_prps(struct nvme_queue *nvmeq,
 	    NVME_SMALL_POOL_SIZE / sizeof(__le64))
 		iod->flags |= IOD_SMALL_DESCRIPTOR;
 
-	prp_list = dma_pool_alloc(nvme_dma_pool(nvmeq, iod), GFP_ATOMIC,
-			&prp_dma);
+	prp_list = nvme_alloc_first_descriptor(nvmeq, req, &prp_dma);
 	if (!prp_list)
 		return BLK_STS_RESOURCE;
 	iod->descriptors[iod->nr_descriptors++] = prp_list;
@@ -791,8 +911,7 @@ static blk_status_t nvme_pci_setup_sgls(struct nvme_queue *nvmeq,
 	if (entries <= NVME_SMALL_POOL_SIZE / sizeof(*sg_list))
 		iod->flags |= IOD_SMALL_DESCRIPTOR;
 
-	sg_list = dma_pool_alloc(nvme_dma_pool(nvmeq, iod), GFP_ATOMIC,
-			&sgl_dma);
+	sg_list = nvme_alloc_first_descriptor(nvmeq, req, &sgl_dma);
 	if (!sg_list)
 		return BLK_STS_RESOURCE;
 	iod->descriptors[iod->nr_descriptors++] = sg_list;
@@ -1617,10 +1736,34 @@ static enum blk_eh_timer_return nvme_timeout(struct request *req)
 	return BLK_EH_DONE;
 }
 
+static void nvme_alloc_desc_ring(struct nvme_dev *dev,
+		struct nvme_queue *nvmeq)
+{
+	nvmeq->desc_ring_stride = NVME_SMALL_POOL_SIZE;
+	if (dev->ctrl.quirks & NVME_QUIRK_DMAPOOL_ALIGN_512)
+		nvmeq->desc_ring_stride = 512;
+
+	/* not having a ring just means falling back to the dma_pool */
+	nvmeq->desc_ring = dma_alloc_coherent(dev->dev,
+			nvmeq->q_depth * nvmeq->desc_ring_stride,
+			&nvmeq->desc_ring_dma, GFP_KERNEL | __GFP_NOWARN);
+}
+
+static void nvme_free_desc_ring(struct nvme_queue *nvmeq)
+{
+	if (!nvmeq->desc_ring)
+		return;
+	dma_free_coherent(nvmeq->dev->dev,
+			nvmeq->q_depth * nvmeq->desc_ring_stride,
+			nvmeq->desc_ring, nvmeq->desc_ring_dma);
+	nvmeq->desc_ring = NULL;
+}
+
 static void nvme_free_queue(struct nvme_queue *nvmeq)
 {
 	dma_free_coherent(nvmeq->dev->dev, CQ_SIZE(nvmeq),
 				(void *)nvmeq->cqes, nvmeq->cq_dma_addr);
+	nvme_free_desc_ring(nvmeq);
 	if (!nvmeq->sq_cmds)
 		return;
 
@@ -1654,6 +1797,11 @@ static void nvme_suspend_queue(struct nvme_dev *dev, unsigned int qid)
 	mb();
 
 	nvmeq->dev->online_queues--;
+	if (nvmeq->qid) {
+		hrtimer_cancel(&nvmeq->sq_db_timer);
+		cancel_work_sync(&nvmeq->sq_db_work);
+		clear_bit(NVMEQ_SQ_DB_DEFERRED, &nvmeq->flags);
+	}
 	if (!nvmeq->qid && nvmeq->dev->ctrl.admin_q)
 		nvme_quiesce_admin_queue(&nvmeq->dev->ctrl);
 	if (!test_and_clear_bit(NVMEQ_POLLED, &nvmeq->flags))
@@ -1754,8 +1902,13 @@ static int nvme_alloc_queue(struct nvme_dev *dev, int qid, int depth)
 		goto free_cqdma;
 
 	nvmeq->dev = dev;
+	if (qid && descriptor_rings)
+		nvme_alloc_desc_ring(dev, nvmeq);
 	spin_lock_init(&nvmeq->sq_lock);
 	spin_lock_init(&nvmeq->cq_poll_lock);
+	hrtimer_setup(&nvmeq->sq_db_timer, nvme_sq_db_timer_fn, CLOCK_MONOTONIC,
+		      HRTIMER_MODE_REL);
+	INIT_WORK(&nvmeq->sq_db_work, nvme_sq_db_work);
 	nvmeq->cq_head = 0;
 	nvmeq->cq_phase = 1;
 	nvmeq->q_db = &dev->dbs[qid * 2 * dev->db_stride];
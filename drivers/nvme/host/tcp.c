@@ -17,6 +17,7 @@
 #include <net/tls_prot.h>
 #include <net/handshake.h>
 #include <linux/blk-mq.h>
+#include <linux/kthread.h>
 #include <net/busy_poll.h>
 #include <trace/events/sock.h>
 
@@ -43,6 +44,15 @@ static bool wq_unbound;
 module_param(wq_unbound, bool, 0644);
 MODULE_PARM_DESC(wq_unbound, "Use unbound workqueue for nvme-tcp IO context (default false)");
 
+/*
+ * Run the I/O context of each queue in a dedicated kthread affine to the
+ * queue's io_cpu instead of in nvme_tcp_wq, which avoids the scheduling
+ * jitter of sharing kworkers with everything else.
+ */
+static bool io_threads;
+module_param(io_threads, bool, 0644);
+MODULE_PARM_DESC(io_threads, "Use a dedicated kthread per queue for nvme-tcp IO context (default false)");
+
 /*
  * TLS handshake timeout
  */
@@ -129,6 +139,7 @@ enum nvme_tcp_queue_flags {
 	NVME_TCP_Q_LIVE		= 1,
 	NVME_TCP_Q_POLLING	= 2,
 	NVME_TCP_Q_IO_CPU_SET	= 3,
+	NVME_TCP_Q_IO_KICK	= 4,
 };
 
 enum nvme_tcp_recv_state {
@@ -141,6 +152,7 @@ struct nvme_tcp_ctrl;
 struct nvme_tcp_queue {
 	struct socket		*sock;
 	struct work_struct	io_work;
+	struct task_struct __rcu *io_thread;
 	int			io_cpu;
 
 	struct mutex		queue_lock;
@@ -216,6 +228,25 @@ static inline int nvme_tcp_queue_id(struct nvme_tcp_queue *queue)
 	return queue - queue->ctrl->queues;
 }
 
+/*
+ * Schedule the I/O context of a queue.  The io_thread is only freed after an
+ * RCU grace period once cleared, see nvme_tcp_stop_io_thread().
+ */
+static void nvme_tcp_kick_io(struct nvme_tcp_queue *queue)
+{
+	struct task_struct *thread;
+
+	rcu_read_lock();
+	thread = rcu_dereference(queue->io_thread);
+	if (thread) {
+		set_bit(NVME_TCP_Q_IO_KICK, &queue->flags);
+		wake_up_process(thread);
+	} else {
+		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+	}
+	rcu_read_unlock();
+}
+
 static inline bool nvme_tcp_recv_pdu_supported(enum nvme_tcp_pdu_type type)
 {
 	switch (type) {
@@ -423,7 +454,7 @@ static inline void nvme_tcp_queue_request(struct nvme_tcp_request *req,
 	}
 
 	if (last && nvme_tcp_queue_has_pending(queue))
-		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+		nvme_tcp_kick_io(queue);
 }
 
 static void nvme_tcp_process_req_list(struct nvme_tcp_queue *queue)
@@ -788,7 +819,7 @@ static int nvme_tcp_handle_r2t(struct nvme_tcp_queue *queue,
 	nvme_tcp_setup_h2c_data_pdu(req);
 
 	llist_add(&req->lentry, &queue->req_list);
-	queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+	nvme_tcp_kick_io(queue);
 
 	return 0;
 }
@@ -1069,7 +1100,7 @@ static void nvme_tcp_data_ready(struct sock *sk)
 	queue = sk->sk_user_data;
 	if (likely(queue && queue->rd_enabled) &&
 	    !test_bit(NVME_TCP_Q_POLLING, &queue->flags))
-		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+		nvme_tcp_kick_io(queue);
 	read_unlock_bh(&sk->sk_callback_lock);
 }
 
@@ -1081,7 +1112,7 @@ static void nvme_tcp_write_space(struct sock *sk)
 	queue = sk->sk_user_data;
 	if (likely(queue && sk_stream_is_writeable(sk))) {
 		clear_bit(SOCK_NOSPACE, &sk->sk_socket->flags);
-		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+		nvme_tcp_kick_io(queue);
 	}
 	read_unlock_bh(&sk->sk_callback_lock);
 }
@@ -1369,10 +1400,12 @@ static int nvme_tcp_try_recv(struct nvme_tcp_queue *queue)
 	return consumed == -EAGAIN ? 0 : consumed;
 }
 
-static void nvme_tcp_io_work(struct work_struct *w)
+/*
+ * Send and receive until there is nothing left to do or the 1ms quota is
+ * exhausted.  Returns true if the queue still has work pending.
+ */
+static bool nvme_tcp_do_io(struct nvme_tcp_queue *queue)
 {
-	struct nvme_tcp_queue *queue =
-		container_of(w, struct nvme_tcp_queue, io_work);
 	unsigned long deadline = jiffies + msecs_to_jiffies(1);
 
 	do {
@@ -1392,7 +1425,7 @@ static void nvme_tcp_io_work(struct work_struct *w)
 		if (result > 0)
 			pending = true;
 		else if (unlikely(result < 0))
-			return;
+			return false;
 
 		/* did we get some space after spending time in recv? */
 		if (nvme_tcp_queue_has_pending(queue) &&
@@ -1400,11 +1433,92 @@ static void nvme_tcp_io_work(struct work_struct *w)
 			pending = true;
 
 		if (!pending || !queue->rd_enabled)
-			return;
+			return false;
 
 	} while (!time_after(jiffies, deadline)); /* quota is exhausted */
 
-	queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+	return true;
+}
+
+static void nvme_tcp_io_work(struct work_struct *w)
+{
+	struct nvme_tcp_queue *queue =
+		container_of(w, struct nvme_tcp_queue, io_work);
+
+	if (nvme_tcp_do_io(queue))
+		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+}
+
+static int nvme_tcp_io_thread(void *data)
+{
+	struct nvme_tcp_queue *queue = data;
+	struct sock *sk = queue->sock->sk;
+
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!test_and_clear_bit(NVME_TCP_Q_IO_KICK, &queue->flags) &&
+		    !kthread_should_stop())
+			schedule();
+		__set_current_state(TASK_RUNNING);
+
+		if (nvme_tcp_do_io(queue)) {
+			set_bit(NVME_TCP_Q_IO_KICK, &queue->flags);
+			cond_resched();
+			continue;
+		}
+
+		/*
+		 * Busy poll once before going back to sleep so that a C2H PDU
+		 * arriving right behind the last one is handled here rather
+		 * than after another wakeup.
+		 */
+		if (queue->rd_enabled && sk_can_busy_loop(sk) &&
+		    skb_queue_empty_lockless(&sk->sk_receive_queue)) {
+			sk_busy_loop(sk, true);
+			if (!skb_queue_empty_lockless(&sk->sk_receive_queue))
+				set_bit(NVME_TCP_Q_IO_KICK, &queue->flags);
+		}
+	}
+	return 0;
+}
+
+static void nvme_tcp_start_io_thread(struct nvme_tcp_queue *queue)
+{
+	struct nvme_tcp_ctrl *ctrl = queue->ctrl;
+	int qid = nvme_tcp_queue_id(queue);
+	struct task_struct *thread;
+
+	thread = kthread_create_on_node(nvme_tcp_io_thread, queue,
+			queue->io_cpu == WORK_CPU_UNBOUND ?
+				NUMA_NO_NODE : cpu_to_node(queue->io_cpu),
+			"nvme_tcp/%d-%d", ctrl->ctrl.instance, qid);
+	if (IS_ERR(thread)) {
+		dev_warn(ctrl->ctrl.device,
+			"queue %d: failed to create io thread, using workqueue\n",
+			qid);
+		return;
+	}
+	if (queue->io_cpu != WORK_CPU_UNBOUND)
+		set_cpus_allowed_ptr(thread, cpumask_of(queue->io_cpu));
+	get_task_struct(thread);
+	rcu_assign_pointer(queue->io_thread, thread);
+	wake_up_process(thread);
+}
+
+static void nvme_tcp_stop_io_thread(struct nvme_tcp_queue *queue)
+{
+	struct task_struct *thread = rcu_dereference_protected(queue->io_thread,
+			!test_bit(NVME_TCP_Q_LIVE, &queue->flags));
+
+	if (!thread)
+		return;
+
+	RCU_INIT_POINTER(queue->io_thread, NULL);
+	/* wait for nvme_tcp_kick_io() callers still using the thread */
+	synchronize_rcu();
+	kthread_stop(thread);
+	put_task_struct(thread);
+	clear_bit(NVME_TCP_Q_IO_KICK, &queue->flags);
 }
 
 static void nvme_tcp_free_async_req(struct nvme_tcp_ctrl *ctrl)
@@ -1917,6 +2031,7 @@ static void __nvme_tcp_stop_queue(struct nvme_tcp_queue *queue)
 {
 	kernel_sock_shutdown(queue->sock, SHUT_RDWR);
 	nvme_tcp_restore_sock_ops(queue);
+	nvme_tcp_stop_io_thread(queue);
 	cancel_work_sync(&queue->io_work);
 }
 
@@ -1992,6 +2107,8 @@ static int nvme_tcp_start_queue(struct nvme_ctrl *nctrl, int idx)
 
 	if (idx) {
 		nvme_tcp_set_queue_io_cpu(queue);
+		if (io_threads)
+			nvme_tcp_start_io_thread(queue);
 		ret = nvmf_connect_io_queue(nctrl, idx);
 	} else
 		ret = nvmf_connect_admin_queue(nctrl);
@@ -2743,7 +2860,7 @@ static void nvme_tcp_commit_rqs(struct blk_mq_hw_ctx *hctx)
 	struct nvme_tcp_queue *queue = hctx->driver_data;
 
 	if (!llist_empty(&queue->req_list))
-		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+		nvme_tcp_kick_io(queue);
 }
 
 static blk_status_t nvme_tcp_queue_rq(struct blk_mq_hw_ctx *hctx,
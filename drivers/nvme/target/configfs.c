@@ -771,6 +771,48 @@ static ssize_t nvmet_ns_revalidate_size_store(struct config_item *item,
 
 CONFIGFS_ATTR_WO(nvmet_ns_, revalidate_size);
 
+static ssize_t nvmet_ns_qos_iops_limit_show(struct config_item *item,
+		char *page)
+{
+	return sysfs_emit(page, "%llu\n",
+			  READ_ONCE(to_nvmet_ns(item)->qos_iops_limit));
+}
+
+static ssize_t nvmet_ns_qos_iops_limit_store(struct config_item *item,
+		const char *page, size_t count)
+{
+	u64 val;
+
+	if (kstrtou64(page, 0, &val))
+		return -EINVAL;
+
+	WRITE_ONCE(to_nvmet_ns(item)->qos_iops_limit, val);
+	return count;
+}
+
+CONFIGFS_ATTR(nvmet_ns_, qos_iops_limit);
+
+static ssize_t nvmet_ns_qos_bps_limit_show(struct config_item *item,
+		char *page)
+{
+	return sysfs_emit(page, "%llu\n",
+			  READ_ONCE(to_nvmet_ns(item)->qos_bps_limit));
+}
+
+static ssize_t nvmet_ns_qos_bps_limit_store(struct config_item *item,
+		const char *page, size_t count)
+{
+	u64 val;
+
+	if (kstrtou64(page, 0, &val))
+		return -EINVAL;
+
+	WRITE_ONCE(to_nvmet_ns(item)->qos_bps_limit, val);
+	return count;
+}
+
+CONFIGFS_ATTR(nvmet_ns_, qos_bps_limit);
+
 static ssize_t nvmet_ns_resv_enable_show(struct config_item *item, char *page)
 {
 	return sysfs_emit(page, "%d\n", to_nvmet_ns(item)->pr.enable);
@@ -805,6 +847,8 @@ static struct configfs_attribute *nvmet_ns_attrs[] = {
 	&nvmet_ns_attr_enable,
 	&nvmet_ns_attr_buffered_io,
 	&nvmet_ns_attr_revalidate_size,
+	&nvmet_ns_attr_qos_iops_limit,
+	&nvmet_ns_attr_qos_bps_limit,
 	&nvmet_ns_attr_resv_enable,
 #ifdef CONFIG_PCI_P2PDMA
 	&nvmet_ns_attr_p2pmem,
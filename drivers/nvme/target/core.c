@@ -655,6 +655,7 @@ void nvmet_ns_disable(struct nvmet_ns *ns)
 
 	if (ns->pr.enable)
 		nvmet_pr_exit_ns(ns);
+	nvmet_qos_exit_ns(ns);
 
 	mutex_lock(&subsys->lock);
 	nvmet_ns_changed(subsys, ns->nsid);
@@ -700,6 +701,7 @@ struct nvmet_ns *nvmet_ns_alloc(struct nvmet_subsys *subsys, u32 nsid)
 		goto out_unlock;
 
 	init_completion(&ns->disable_done);
+	nvmet_qos_init_ns(ns);
 
 	ns->nsid = nsid;
 	ns->subsys = subsys;
@@ -1145,8 +1147,12 @@ static u16 nvmet_parse_io_cmd(struct nvmet_req *req)
 			return ret;
 
 		ret = nvmet_pr_get_ns_pc_ref(req);
+		if (ret)
+			return ret;
 	}
-	return ret;
+
+	nvmet_qos_setup_req(req);
+	return 0;
 }
 
 bool nvmet_req_init(struct nvmet_req *req, struct nvmet_sq *sq,
@@ -9,6 +9,7 @@
 #include <linux/falloc.h>
 #include <linux/file.h>
 #include <linux/fs.h>
+#include <linux/pagemap.h>
 #include "nvmet.h"
 
 #define NVMET_MIN_MPOOL_OBJ		16
@@ -215,6 +216,117 @@ static void nvmet_file_submit_buffered_io(struct nvmet_req *req)
 	queue_work(buffered_io_wq, &req->f.work);
 }
 
+static void nvmet_file_async_read(struct nvmet_req *req);
+
+static void nvmet_file_async_read_work(struct work_struct *w)
+{
+	struct nvmet_req *req = container_of(w, struct nvmet_req, f.work);
+
+	nvmet_file_async_read(req);
+}
+
+/*
+ * Called when the folio we queued on for IOCB_WAITQ is unlocked, possibly
+ * from the I/O completion path, so just kick off the retry.
+ */
+static int nvmet_file_async_buf_func(struct wait_queue_entry *wait,
+		unsigned mode, int sync, void *arg)
+{
+	struct wait_page_queue *wpq =
+		container_of(wait, struct wait_page_queue, wait);
+	struct nvmet_req *req = wait->private;
+
+	if (!wake_page_match(wpq, arg))
+		return 0;
+
+	list_del_init(&wait->entry);
+	INIT_WORK(&req->f.work, nvmet_file_async_read_work);
+	queue_work(nvmet_wq, &req->f.work);
+	return 1;
+}
+
+/*
+ * Buffered read that never blocks a worker on the page cache: try with
+ * IOCB_NOWAIT first, and if that would block, retry with IOCB_WAITQ so that
+ * the read either makes progress or queues a callback for the folio it needs.
+ * The callback then resumes the read from where it left off.  Only if the
+ * file system punts even that do we fall back to the buffered_io_wq worker.
+ */
+static void nvmet_file_async_read(struct nvmet_req *req)
+{
+	struct kiocb *iocb = &req->f.iocb;
+	struct file *file = req->ns->file;
+	int ki_flags = IOCB_NOWAIT;
+	struct iov_iter iter;
+	loff_t pos;
+	ssize_t ret = 0;
+
+	pos = le64_to_cpu(req->cmd->rw.slba) << req->ns->blksize_shift;
+	iov_iter_bvec(&iter, ITER_DEST, req->f.bvec, req->sg_cnt,
+		      req->transfer_len);
+	iov_iter_advance(&iter, req->f.done);
+
+	while (req->f.done < req->transfer_len) {
+		iocb->ki_pos = pos + req->f.done;
+		iocb->ki_filp = file;
+		iocb->ki_flags = ki_flags | file->f_iocb_flags;
+
+		ret = file->f_op->read_iter(iocb, &iter);
+		if (ret == -EIOCBQUEUED)
+			return;
+		if (ret == -EAGAIN && ki_flags == IOCB_NOWAIT) {
+			req->f.wpq.wait.func = nvmet_file_async_buf_func;
+			req->f.wpq.wait.private = req;
+			req->f.wpq.wait.flags = 0;
+			INIT_LIST_HEAD(&req->f.wpq.wait.entry);
+			iocb->ki_waitq = &req->f.wpq;
+			ki_flags = IOCB_WAITQ;
+			continue;
+		}
+		if (ret == -EAGAIN || ret == -EOPNOTSUPP) {
+			/* restart from scratch in a context that may block */
+			nvmet_file_submit_buffered_io(req);
+			return;
+		}
+		if (ret <= 0)
+			break;
+		req->f.done += ret;
+		ki_flags = IOCB_NOWAIT;
+	}
+
+	nvmet_file_io_done(iocb, ret < 0 ? ret : req->f.done);
+}
+
+static bool nvmet_file_can_async_read(struct nvmet_req *req)
+{
+	struct file *file = req->ns->file;
+
+	return req->cmd->rw.opcode == nvme_cmd_read &&
+		!req->f.mpool_alloc &&
+		(file->f_mode & FMODE_NOWAIT) &&
+		(file->f_op->fop_flags & FOP_BUFFER_RASYNC);
+}
+
+static void nvmet_file_start_async_read(struct nvmet_req *req)
+{
+	struct scatterlist *sg;
+	loff_t pos;
+	int i;
+
+	pos = le64_to_cpu(req->cmd->rw.slba) << req->ns->blksize_shift;
+	if (unlikely(pos + req->transfer_len > req->ns->size)) {
+		nvmet_req_complete(req, errno_to_nvme_status(req, -ENOSPC));
+		return;
+	}
+
+	memset(&req->f.iocb, 0, sizeof(struct kiocb));
+	for_each_sg(req->sg, sg, req->sg_cnt, i)
+		bvec_set_page(&req->f.bvec[i], sg_page(sg), sg->length,
+			      sg->offset);
+	req->f.done = 0;
+	nvmet_file_async_read(req);
+}
+
 static void nvmet_file_execute_rw(struct nvmet_req *req)
 {
 	ssize_t nr_bvec = req->sg_cnt;
@@ -241,6 +353,10 @@ static void nvmet_file_execute_rw(struct nvmet_req *req)
 		req->f.mpool_alloc = false;
 
 	if (req->ns->buffered_io) {
+		if (nvmet_file_can_async_read(req)) {
+			nvmet_file_start_async_read(req);
+			return;
+		}
 		if (likely(!req->f.mpool_alloc) &&
 		    (req->ns->file->f_mode & FMODE_NOWAIT) &&
 		    nvmet_file_execute_io(req, IOCB_NOWAIT))
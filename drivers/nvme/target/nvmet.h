@@ -128,6 +128,11 @@ struct nvmet_ns {
 	u8			csi;
 	struct nvmet_pr		pr;
 	struct xarray		pr_per_ctrl_refs;
+
+	/* per-host shaping limits, 0 means unlimited */
+	u64			qos_iops_limit;
+	u64			qos_bps_limit;
+	struct xarray		qos_buckets;
 };
 
 static inline struct nvmet_ns *to_nvmet_ns(struct config_item *item)
@@ -461,6 +466,9 @@ struct nvmet_req {
 			struct kiocb            iocb;
 			struct bio_vec          *bvec;
 			struct work_struct      work;
+			/* async buffered read state */
+			struct wait_page_queue	wpq;
+			size_t			done;
 		} f;
 		struct {
 			struct bio		inline_bio;
@@ -489,6 +497,10 @@ struct nvmet_req {
 	void (*execute)(struct nvmet_req *req);
 	const struct nvmet_fabrics_ops *ops;
 
+	/* the real execute handler while the command is being shaped */
+	void (*qos_execute)(struct nvmet_req *req);
+	struct list_head	qos_entry;
+
 	struct pci_dev		*p2p_dev;
 	struct device		*p2p_client;
 	u16			error_loc;
@@ -938,6 +950,10 @@ static inline const char *nvmet_dhchap_dhgroup_name(u8 dhgid) { return NULL; }
 static inline void nvmet_auth_insert_psk(struct nvmet_sq *sq) {};
 #endif
 
+void nvmet_qos_init_ns(struct nvmet_ns *ns);
+void nvmet_qos_exit_ns(struct nvmet_ns *ns);
+void nvmet_qos_setup_req(struct nvmet_req *req);
+
 int nvmet_pr_init_ns(struct nvmet_ns *ns);
 u16 nvmet_parse_pr_cmd(struct nvmet_req *req);
 u16 nvmet_pr_check_cmd_access(struct nvmet_req *req);
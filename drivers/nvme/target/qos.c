@@ -0,0 +1,215 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * NVMe over Fabrics target per-host namespace I/O shaping.
+ *
+ * Each namespace can be given an IOPS and a bandwidth limit.  The limits are
+ * enforced separately for every host controller accessing the namespace with
+ * a simple token bucket, so that one busy host can't starve the others
+ * sharing the same backend.  Commands that exceed the budget are parked on
+ * the bucket and executed from a delayed work once enough tokens have been
+ * refilled.
+ */
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+#include <linux/math64.h>
+#include "nvmet.h"
+
+/* allow bursts of up to this fraction of a second worth of tokens */
+#define NVMET_QOS_BURST_DIV	10
+
+struct nvmet_qos_bucket {
+	spinlock_t		lock;
+	struct nvmet_ns		*ns;
+	u64			last_refill;
+	s64			io_tokens;
+	s64			byte_tokens;
+	struct list_head	queued;
+	struct delayed_work	dispatch_work;
+};
+
+static void nvmet_qos_refill_one(s64 *tokens, u64 limit, u64 elapsed)
+{
+	s64 burst = max_t(u64, limit / NVMET_QOS_BURST_DIV, 1);
+
+	if (!limit)
+		return;
+	*tokens += mul_u64_u64_div_u64(elapsed, limit, NSEC_PER_SEC);
+	if (*tokens > burst)
+		*tokens = burst;
+}
+
+static void nvmet_qos_refill(struct nvmet_qos_bucket *b)
+{
+	u64 now = ktime_get_ns();
+	u64 elapsed = min_t(u64, now - b->last_refill, NSEC_PER_SEC);
+
+	b->last_refill = now;
+	nvmet_qos_refill_one(&b->io_tokens,
+			READ_ONCE(b->ns->qos_iops_limit), elapsed);
+	nvmet_qos_refill_one(&b->byte_tokens,
+			READ_ONCE(b->ns->qos_bps_limit), elapsed);
+}
+
+static u32 nvmet_qos_req_bytes(struct nvmet_req *req)
+{
+	switch (req->cmd->common.opcode) {
+	case nvme_cmd_read:
+	case nvme_cmd_write:
+		return nvmet_rw_data_len(req);
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Try to charge @req to the bucket.  A command is allowed to overdraw the
+ * bucket as long as there are tokens left at all, so that commands larger
+ * than the burst size can make progress.
+ */
+static bool nvmet_qos_charge(struct nvmet_qos_bucket *b, struct nvmet_req *req)
+{
+	u64 iops_limit = READ_ONCE(b->ns->qos_iops_limit);
+	u64 bps_limit = READ_ONCE(b->ns->qos_bps_limit);
+
+	if ((iops_limit && b->io_tokens <= 0) ||
+	    (bps_limit && b->byte_tokens <= 0))
+		return false;
+
+	if (iops_limit)
+		b->io_tokens--;
+	if (bps_limit)
+		b->byte_tokens -= nvmet_qos_req_bytes(req);
+	return true;
+}
+
+/* time until the bucket has tokens for another command again */
+static unsigned long nvmet_qos_delay(struct nvmet_qos_bucket *b)
+{
+	u64 iops_limit = READ_ONCE(b->ns->qos_iops_limit);
+	u64 bps_limit = READ_ONCE(b->ns->qos_bps_limit);
+	u64 wait_ns = 0;
+
+	if (iops_limit && b->io_tokens <= 0)
+		wait_ns = max(wait_ns, div64_u64((1 - b->io_tokens) *
+				NSEC_PER_SEC, iops_limit));
+	if (bps_limit && b->byte_tokens <= 0)
+		wait_ns = max(wait_ns, mul_u64_u64_div_u64(1 - b->byte_tokens,
+				NSEC_PER_SEC, bps_limit));
+	return max_t(unsigned long, nsecs_to_jiffies(wait_ns), 1);
+}
+
+static void nvmet_qos_dispatch_work(struct work_struct *w)
+{
+	struct nvmet_qos_bucket *b = container_of(to_delayed_work(w),
+			struct nvmet_qos_bucket, dispatch_work);
+	struct nvmet_req *req, *tmp;
+	unsigned long flags;
+	LIST_HEAD(dispatch);
+
+	spin_lock_irqsave(&b->lock, flags);
+	nvmet_qos_refill(b);
+	list_for_each_entry_safe(req, tmp, &b->queued, qos_entry) {
+		if (!nvmet_qos_charge(b, req))
+			break;
+		list_move_tail(&req->qos_entry, &dispatch);
+	}
+	if (!list_empty(&b->queued))
+		queue_delayed_work(nvmet_wq, &b->dispatch_work,
+				   nvmet_qos_delay(b));
+	spin_unlock_irqrestore(&b->lock, flags);
+
+	list_for_each_entry_safe(req, tmp, &dispatch, qos_entry) {
+		list_del_init(&req->qos_entry);
+		req->qos_execute(req);
+	}
+}
+
+static struct nvmet_qos_bucket *nvmet_qos_get_bucket(struct nvmet_req *req)
+{
+	struct nvmet_ns *ns = req->ns;
+	unsigned long id = req->sq->ctrl->cntlid;
+	struct nvmet_qos_bucket *b, *old;
+
+	b = xa_load(&ns->qos_buckets, id);
+	if (likely(b))
+		return b;
+
+	b = kzalloc(sizeof(*b), GFP_ATOMIC);
+	if (!b)
+		return NULL;
+	spin_lock_init(&b->lock);
+	b->ns = ns;
+	b->last_refill = ktime_get_ns();
+	b->io_tokens = 1;
+	b->byte_tokens = 1;
+	INIT_LIST_HEAD(&b->queued);
+	INIT_DELAYED_WORK(&b->dispatch_work, nvmet_qos_dispatch_work);
+
+	/* controller IDs are reused, so a bucket outlives its controller */
+	old = xa_cmpxchg(&ns->qos_buckets, id, NULL, b, GFP_ATOMIC);
+	if (old) {
+		kfree(b);
+		return xa_is_err(old) ? NULL : old;
+	}
+	return b;
+}
+
+static void nvmet_qos_execute(struct nvmet_req *req)
+{
+	struct nvmet_qos_bucket *b = nvmet_qos_get_bucket(req);
+	unsigned long flags;
+
+	/* if we can't track this host, don't shape it rather than fail I/O */
+	if (unlikely(!b)) {
+		req->qos_execute(req);
+		return;
+	}
+
+	spin_lock_irqsave(&b->lock, flags);
+	nvmet_qos_refill(b);
+	if (list_empty(&b->queued) && nvmet_qos_charge(b, req)) {
+		spin_unlock_irqrestore(&b->lock, flags);
+		req->qos_execute(req);
+		return;
+	}
+	if (list_empty(&b->queued))
+		queue_delayed_work(nvmet_wq, &b->dispatch_work,
+				   nvmet_qos_delay(b));
+	list_add_tail(&req->qos_entry, &b->queued);
+	spin_unlock_irqrestore(&b->lock, flags);
+}
+
+/*
+ * Called once an I/O command has been parsed.  Interpose the shaping on the
+ * execute handler so that it applies to every transport.
+ */
+void nvmet_qos_setup_req(struct nvmet_req *req)
+{
+	struct nvmet_ns *ns = req->ns;
+
+	if (likely(!READ_ONCE(ns->qos_iops_limit) &&
+		   !READ_ONCE(ns->qos_bps_limit)))
+		return;
+
+	req->qos_execute = req->execute;
+	req->execute = nvmet_qos_execute;
+}
+
+void nvmet_qos_init_ns(struct nvmet_ns *ns)
+{
+	xa_init(&ns->qos_buckets);
+}
+
+/* Called once all references to the namespace are gone. */
+void nvmet_qos_exit_ns(struct nvmet_ns *ns)
+{
+	struct nvmet_qos_bucket *b;
+	unsigned long idx;
+
+	xa_for_each(&ns->qos_buckets, idx, b) {
+		cancel_delayed_work_sync(&b->dispatch_work);
+		WARN_ON_ONCE(!list_empty(&b->queued));
+		xa_erase(&ns->qos_buckets, idx);
+		kfree(b);
+	}
+	xa_destroy(&ns->qos_buckets);
+}
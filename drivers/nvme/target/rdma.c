@@ -124,10 +124,19 @@ struct nvmet_rdma_port {
 	struct delayed_work	repair_work;
 };
 
+/*
+ * Receive buffers for an SRQ are allocated and posted in up to this many
+ * chunks, so that an adaptive SRQ only pins as many as its load needs.
+ */
+#define NVMET_RDMA_SRQ_CHUNKS	8
+
 struct nvmet_rdma_srq {
 	struct ib_srq            *srq;
-	struct nvmet_rdma_cmd    *cmds;
+	struct nvmet_rdma_cmd    *chunks[NVMET_RDMA_SRQ_CHUNKS];
+	int			 nr_chunks;
+	int			 chunk_size;
 	struct nvmet_rdma_device *ndev;
+	struct work_struct	 grow_work;
 };
 
 struct nvmet_rdma_device {
@@ -156,6 +165,11 @@ static int nvmet_rdma_srq_size = 1024;
 module_param_cb(srq_size, &srq_size_ops, &nvmet_rdma_srq_size, 0644);
 MODULE_PARM_DESC(srq_size, "set Shared Receive Queue (SRQ) size, should >= 256 (default: 1024)");
 
+static bool nvmet_rdma_srq_adaptive;
+module_param_named(srq_adaptive, nvmet_rdma_srq_adaptive, bool, 0444);
+MODULE_PARM_DESC(srq_adaptive,
+	"Start SRQs with a fraction of srq_size receive buffers and grow them on demand (default: false)");
+
 static DEFINE_IDA(nvmet_rdma_queue_ida);
 static LIST_HEAD(nvmet_rdma_queue_list);
 static DEFINE_MUTEX(nvmet_rdma_queue_mutex);
@@ -1065,11 +1079,98 @@ static void nvmet_rdma_recv_done(struct ib_cq *cq, struct ib_wc *wc)
 	nvmet_rdma_handle_command(queue, rsp);
 }
 
+static int nvmet_rdma_srq_chunk_cmds(struct nvmet_rdma_srq *nsrq, int chunk)
+{
+	return min_t(int, nsrq->chunk_size,
+		     nsrq->ndev->srq_size - chunk * nsrq->chunk_size);
+}
+
+static void nvmet_rdma_srq_free_chunks(struct nvmet_rdma_srq *nsrq)
+{
+	int i;
+
+	for (i = 0; i < nsrq->nr_chunks; i++)
+		nvmet_rdma_free_cmds(nsrq->ndev, nsrq->chunks[i],
+				     nvmet_rdma_srq_chunk_cmds(nsrq, i), false);
+	nsrq->nr_chunks = 0;
+}
+
+static int nvmet_rdma_srq_add_chunk(struct nvmet_rdma_srq *nsrq)
+{
+	int chunk = nsrq->nr_chunks, nr_cmds, i, ret;
+	struct nvmet_rdma_cmd *cmds;
+
+	nr_cmds = nvmet_rdma_srq_chunk_cmds(nsrq, chunk);
+	cmds = nvmet_rdma_alloc_cmds(nsrq->ndev, nr_cmds, false);
+	if (IS_ERR(cmds))
+		return PTR_ERR(cmds);
+
+	nsrq->chunks[chunk] = cmds;
+	nsrq->nr_chunks++;
+
+	for (i = 0; i < nr_cmds; i++) {
+		cmds[i].nsrq = nsrq;
+		ret = nvmet_rdma_post_recv(nsrq->ndev, &cmds[i]);
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+
+/*
+ * Ask for an SRQ limit event once three quarters of the posted receive
+ * buffers are consumed by inflight commands.  The event is one-shot, so this
+ * needs to be redone after every growth step.
+ */
+static void nvmet_rdma_srq_arm_limit(struct nvmet_rdma_srq *nsrq)
+{
+	struct ib_srq_attr attr = { };
+	int posted = 0, i;
+
+	for (i = 0; i < nsrq->nr_chunks; i++)
+		posted += nvmet_rdma_srq_chunk_cmds(nsrq, i);
+	attr.srq_limit = max(posted / 4, 1);
+	if (ib_modify_srq(nsrq->srq, &attr, IB_SRQ_LIMIT))
+		schedule_work(&nsrq->grow_work);
+}
+
+static void nvmet_rdma_srq_grow_work(struct work_struct *w)
+{
+	struct nvmet_rdma_srq *nsrq =
+		container_of(w, struct nvmet_rdma_srq, grow_work);
+
+	if (nsrq->nr_chunks >= NVMET_RDMA_SRQ_CHUNKS ||
+	    nsrq->nr_chunks * nsrq->chunk_size >= nsrq->ndev->srq_size)
+		return;
+
+	if (nvmet_rdma_srq_add_chunk(nsrq)) {
+		pr_warn("failed to grow SRQ to %d chunks\n", nsrq->nr_chunks);
+		return;
+	}
+	pr_debug("grew SRQ %p to %d chunks\n", nsrq->srq, nsrq->nr_chunks);
+
+	if (nsrq->nr_chunks < NVMET_RDMA_SRQ_CHUNKS &&
+	    nsrq->nr_chunks * nsrq->chunk_size < nsrq->ndev->srq_size)
+		nvmet_rdma_srq_arm_limit(nsrq);
+}
+
+static void nvmet_rdma_srq_event(struct ib_event *event, void *priv)
+{
+	struct nvmet_rdma_srq *nsrq = priv;
+
+	if (event->event == IB_EVENT_SRQ_LIMIT_REACHED)
+		schedule_work(&nsrq->grow_work);
+	else
+		pr_err("received IB SRQ event: %s (%d)\n",
+		       ib_event_msg(event->event), event->event);
+}
+
 static void nvmet_rdma_destroy_srq(struct nvmet_rdma_srq *nsrq)
 {
-	nvmet_rdma_free_cmds(nsrq->ndev, nsrq->cmds, nsrq->ndev->srq_size,
-			     false);
+	/* no more limit events after this, so the grow work can be flushed */
 	ib_destroy_srq(nsrq->srq);
+	cancel_work_sync(&nsrq->grow_work);
+	nvmet_rdma_srq_free_chunks(nsrq);
 
 	kfree(nsrq);
 }
@@ -1094,12 +1195,18 @@ nvmet_rdma_init_srq(struct nvmet_rdma_device *ndev)
 	size_t srq_size = ndev->srq_size;
 	struct nvmet_rdma_srq *nsrq;
 	struct ib_srq *srq;
-	int ret, i;
+	int ret, nr_chunks;
 
 	nsrq = kzalloc(sizeof(*nsrq), GFP_KERNEL);
 	if (!nsrq)
 		return ERR_PTR(-ENOMEM);
 
+	nsrq->ndev = ndev;
+	nsrq->chunk_size = DIV_ROUND_UP(srq_size, NVMET_RDMA_SRQ_CHUNKS);
+	INIT_WORK(&nsrq->grow_work, nvmet_rdma_srq_grow_work);
+
+	srq_attr.event_handler = nvmet_rdma_srq_event;
+	srq_attr.srq_context = nsrq;
 	srq_attr.attr.max_wr = srq_size;
 	srq_attr.attr.max_sge = 1 + ndev->inline_page_count;
 	srq_attr.attr.srq_limit = 0;
@@ -1110,28 +1217,24 @@ nvmet_rdma_init_srq(struct nvmet_rdma_device *ndev)
 		goto out_free;
 	}
 
-	nsrq->cmds = nvmet_rdma_alloc_cmds(ndev, srq_size, false);
-	if (IS_ERR(nsrq->cmds)) {
-		ret = PTR_ERR(nsrq->cmds);
-		goto out_destroy_srq;
-	}
-
 	nsrq->srq = srq;
-	nsrq->ndev = ndev;
 
-	for (i = 0; i < srq_size; i++) {
-		nsrq->cmds[i].nsrq = nsrq;
-		ret = nvmet_rdma_post_recv(ndev, &nsrq->cmds[i]);
+	nr_chunks = nvmet_rdma_srq_adaptive ? 1 :
+		DIV_ROUND_UP(srq_size, nsrq->chunk_size);
+	while (nsrq->nr_chunks < nr_chunks) {
+		ret = nvmet_rdma_srq_add_chunk(nsrq);
 		if (ret)
-			goto out_free_cmds;
+			goto out_destroy_srq;
 	}
 
+	if (nsrq->nr_chunks * nsrq->chunk_size < srq_size)
+		nvmet_rdma_srq_arm_limit(nsrq);
+
 	return nsrq;
 
-out_free_cmds:
-	nvmet_rdma_free_cmds(ndev, nsrq->cmds, srq_size, false);
 out_destroy_srq:
 	ib_destroy_srq(srq);
+	nvmet_rdma_srq_free_chunks(nsrq);
 out_free:
 	kfree(nsrq);
 	return ERR_PTR(ret);
@@ -82,6 +82,17 @@ MODULE_PARM_DESC(tls_handshake_timeout,
 		 "nvme TLS handshake timeout in seconds (default 10)");
 #endif
 
+/*
+ * Hand I/O command execution off to an unbound workqueue instead of running
+ * it inline from the queue's io_work.  This spreads the backend submission
+ * cost of a single hot queue over several CPUs, at the price of a work item
+ * per command.
+ */
+static bool exec_offload;
+module_param(exec_offload, bool, 0644);
+MODULE_PARM_DESC(exec_offload,
+		"nvmet tcp execute I/O commands from an unbound workqueue: Default false");
+
 #define NVMET_TCP_RECV_BUDGET		8
 #define NVMET_TCP_SEND_BUDGET		8
 #define NVMET_TCP_IO_WORK_BUDGET	64
@@ -127,6 +138,7 @@ struct nvmet_tcp_cmd {
 
 	struct list_head		entry;
 	struct llist_node		lentry;
+	struct work_struct		exec_work;
 
 	/* send state */
 	u32				offset;
@@ -211,6 +223,7 @@ static LIST_HEAD(nvmet_tcp_queue_list);
 static DEFINE_MUTEX(nvmet_tcp_queue_mutex);
 
 static struct workqueue_struct *nvmet_tcp_wq;
+static struct workqueue_struct *nvmet_tcp_exec_wq;
 static const struct nvmet_fabrics_ops nvmet_tcp_ops;
 static void nvmet_tcp_free_cmd(struct nvmet_tcp_cmd *c);
 static void nvmet_tcp_free_cmd_buffers(struct nvmet_tcp_cmd *cmd);
@@ -601,12 +614,32 @@ static void nvmet_tcp_queue_response(struct nvmet_req *req)
 	queue_work_on(queue_cpu(queue), nvmet_tcp_wq, &cmd->queue->io_work);
 }
 
+static void nvmet_tcp_exec_work(struct work_struct *w)
+{
+	struct nvmet_tcp_cmd *cmd =
+		container_of(w, struct nvmet_tcp_cmd, exec_work);
+
+	cmd->req.execute(&cmd->req);
+}
+
+static void nvmet_tcp_submit_request(struct nvmet_tcp_cmd *cmd)
+{
+	/*
+	 * The request holds a reference on the sq from nvmet_req_init(), so
+	 * queue teardown waits for offloaded commands to complete.
+	 */
+	if (READ_ONCE(exec_offload) && cmd->queue->idx)
+		queue_work(nvmet_tcp_exec_wq, &cmd->exec_work);
+	else
+		cmd->req.execute(&cmd->req);
+}
+
 static void nvmet_tcp_execute_request(struct nvmet_tcp_cmd *cmd)
 {
 	if (unlikely(cmd->flags & NVMET_TCP_F_INIT_FAILED))
 		nvmet_tcp_queue_response(&cmd->req);
 	else
-		cmd->req.execute(&cmd->req);
+		nvmet_tcp_submit_request(cmd);
 }
 
 static int nvmet_try_send_data_pdu(struct nvmet_tcp_cmd *cmd)
@@ -1072,7 +1105,7 @@ static int nvmet_tcp_done_recv_pdu(struct nvmet_tcp_queue *queue)
 		goto out;
 	}
 
-	queue->cmd->req.execute(&queue->cmd->req);
+	nvmet_tcp_submit_request(queue->cmd);
 out:
 	nvmet_prepare_receive_pdu(queue);
 	return ret;
@@ -1430,6 +1463,7 @@ static int nvmet_tcp_alloc_cmd(struct nvmet_tcp_queue *queue,
 
 	c->queue = queue;
 	c->req.port = queue->port->nport;
+	INIT_WORK(&c->exec_work, nvmet_tcp_exec_work);
 
 	c->cmd_pdu = page_frag_alloc(&queue->pf_cache,
 			sizeof(*c->cmd_pdu) + hdgst, GFP_KERNEL | __GFP_ZERO);
@@ -2202,11 +2236,20 @@ static int __init nvmet_tcp_init(void)
 	if (!nvmet_tcp_wq)
 		return -ENOMEM;
 
+	nvmet_tcp_exec_wq = alloc_workqueue("nvmet_tcp_exec_wq",
+				WQ_MEM_RECLAIM | WQ_HIGHPRI | WQ_UNBOUND, 0);
+	if (!nvmet_tcp_exec_wq) {
+		ret = -ENOMEM;
+		goto err;
+	}
+
 	ret = nvmet_register_transport(&nvmet_tcp_ops);
 	if (ret)
-		goto err;
+		goto err_exec_wq;
 
 	return 0;
+err_exec_wq:
+	destroy_workqueue(nvmet_tcp_exec_wq);
 err:
 	destroy_workqueue(nvmet_tcp_wq);
 	return ret;
@@ -2225,6 +2268,7 @@ static void __exit nvmet_tcp_exit(void)
 	mutex_unlock(&nvmet_tcp_queue_mutex);
 	flush_workqueue(nvmet_wq);
 
+	destroy_workqueue(nvmet_tcp_exec_wq);
 	destroy_workqueue(nvmet_tcp_wq);
 	ida_destroy(&nvmet_tcp_queue_ida);
 }
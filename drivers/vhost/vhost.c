@@ -334,6 +334,7 @@ static void __vhost_vq_meta_reset(struct vhost_virtqueue *vq)
 
 	for (j = 0; j < VHOST_NUM_ADDRS; j++)
 		vq->meta_iotlb[j] = NULL;
+	vq->desc_iotlb = NULL;
 }
 
 static void vhost_vq_meta_reset(struct vhost_dev *d)
@@ -2423,6 +2424,30 @@ int vhost_vq_init_access(struct vhost_virtqueue *vq)
 }
 EXPORT_SYMBOL_GPL(vhost_vq_init_access);
 
+/*
+ * Descriptors of a packet usually land in the same IOTLB mapping, so try
+ * the last map that was hit before walking the interval tree.  The cache
+ * is only used for the device IOTLB and is dropped, under the vq mutex,
+ * whenever that IOTLB changes.
+ */
+static const struct vhost_iotlb_map *
+vhost_desc_iotlb_find(struct vhost_virtqueue *vq, struct vhost_iotlb *umem,
+		      u64 addr, u64 last)
+{
+	const struct vhost_iotlb_map *map = vq->desc_iotlb;
+
+	if (umem != vq->dev->iotlb)
+		return vhost_iotlb_itree_first(umem, addr, last);
+
+	if (map && map->start <= addr && addr <= map->last)
+		return map;
+
+	map = vhost_iotlb_itree_first(umem, addr, last);
+	if (map)
+		vq->desc_iotlb = map;
+	return map;
+}
+
 static int translate_desc(struct vhost_virtqueue *vq, u64 addr, u32 len,
 			  struct iovec iov[], int iov_size, int access)
 {
@@ -2440,7 +2465,7 @@ static int translate_desc(struct vhost_virtqueue *vq, u64 addr, u32 len,
 			break;
 		}
 
-		map = vhost_iotlb_itree_first(umem, addr, last);
+		map = vhost_desc_iotlb_find(vq, umem, addr, last);
 		if (map == NULL || map->start > addr) {
 			if (umem != dev->iotlb) {
 				ret = -EFAULT;
@@ -89,6 +89,8 @@ struct vhost_virtqueue {
 	vring_avail_t __user *avail;
 	vring_used_t __user *used;
 	const struct vhost_iotlb_map *meta_iotlb[VHOST_NUM_ADDRS];
+	/* Last device IOTLB map hit by translate_desc(). */
+	const struct vhost_iotlb_map *desc_iotlb;
 	struct file *kick;
 	struct vhost_vring_call call_ctx;
 	struct eventfd_ctx *error_ctx;
@@ -53,6 +53,23 @@
 #define AIO_RING_MAGIC			0xa10a10a1
 #define AIO_RING_COMPAT_FEATURES	1
 #define AIO_RING_INCOMPAT_FEATURES	0
+
+/*
+ * The ring is mapped into userspace at the address returned by
+ * io_setup() and completions may be reaped from there without calling
+ * io_getevents(), provided the ring checks out: magic is AIO_RING_MAGIC
+ * and incompat_features is AIO_RING_INCOMPAT_FEATURES.
+ *
+ * The kernel is the only writer of tail and of io_events[]; it stores
+ * the event, issues smp_wmb() and then publishes tail.  A userspace
+ * reaper must load tail (with acquire semantics, or a load followed by
+ * a read barrier), consume io_events[head..tail) modulo nr, and then
+ * store the new head with release semantics.  aio_complete() only reads
+ * head to return request slots, but aio_read_events_ring() advances it
+ * under ctx->ring_lock, which userspace cannot take, so reaping from
+ * userspace must not be mixed with io_getevents() on the same context
+ * unless userspace serializes the two itself.
+ */
 struct aio_ring {
 	unsigned	id;	/* kernel internal index number */
 	unsigned	nr;	/* number of io_events */
@@ -226,8 +226,11 @@ struct eventpoll {
 	refcount_t refcount;
 
 #ifdef CONFIG_NET_RX_BUSY_POLL
-	/* used to track busy poll napi_id */
-	unsigned int napi_id;
+	/* used to track busy poll napi_ids of ready sockets */
+	unsigned int napi_ids[NAPI_BUSY_GROUP_MAX];
+	unsigned int nr_napi_ids;
+	/* evicted from napi_ids with its IRQs possibly suspended */
+	unsigned int napi_id_evicted;
 	/* busy poll timeout */
 	u32 busy_poll_usecs;
 	/* busy poll packet budget */
@@ -432,6 +435,18 @@ static bool ep_busy_loop_end(void *p, unsigned long start_time)
 	return ep_events_available(ep) || busy_loop_ep_timeout(start_time, ep);
 }
 
+/*
+ * An ID evicted from the group under ep->lock can't have its IRQs resumed
+ * there. Do it on the next busy poll or when the IRQs are resumed anyway.
+ */
+static void ep_resume_evicted_napi(struct eventpoll *ep)
+{
+	unsigned int napi_id = xchg(&ep->napi_id_evicted, 0);
+
+	if (napi_id_valid(napi_id))
+		napi_resume_irqs(napi_id);
+}
+
 /*
  * Busy poll if globally on and supporting sockets found && no events,
  * busy loop will return if need_resched or ep_events_available.
@@ -440,28 +455,41 @@ static bool ep_busy_loop_end(void *p, unsigned long start_time)
  */
 static bool ep_busy_loop(struct eventpoll *ep)
 {
-	unsigned int napi_id = READ_ONCE(ep->napi_id);
+	unsigned int nr = min(READ_ONCE(ep->nr_napi_ids), NAPI_BUSY_GROUP_MAX);
 	u16 budget = READ_ONCE(ep->busy_poll_budget);
 	bool prefer_busy_poll = READ_ONCE(ep->prefer_busy_poll);
+	unsigned int napi_ids[NAPI_BUSY_GROUP_MAX];
+	unsigned int i;
 
 	if (!budget)
 		budget = BUSY_POLL_BUDGET;
 
-	if (napi_id_valid(napi_id) && ep_busy_loop_on(ep)) {
-		napi_busy_loop(napi_id, ep_busy_loop_end,
-			       ep, prefer_busy_poll, budget);
-		if (ep_events_available(ep))
-			return true;
-		/*
-		 * Busy poll timed out.  Drop NAPI ID for now, we can add
-		 * it back in when we have moved a socket with a valid NAPI
-		 * ID onto the ready list.
-		 */
-		if (prefer_busy_poll)
-			napi_resume_irqs(napi_id);
-		ep->napi_id = 0;
+	ep_resume_evicted_napi(ep);
+
+	if (!nr || !ep_busy_loop_on(ep))
 		return false;
-	}
+
+	for (i = 0; i < nr; i++)
+		napi_ids[i] = READ_ONCE(ep->napi_ids[i]);
+
+	/* Sockets spread over several RX queues are polled round-robin */
+	if (nr == 1)
+		napi_busy_loop(napi_ids[0], ep_busy_loop_end,
+			       ep, prefer_busy_poll, budget);
+	else
+		napi_busy_loop_group(napi_ids, nr, ep_busy_loop_end,
+				     ep, prefer_busy_poll, budget);
+	if (ep_events_available(ep))
+		return true;
+	/*
+	 * Busy poll timed out.  Drop NAPI IDs for now, we can add
+	 * them back in when we have moved a socket with a valid NAPI
+	 * ID onto the ready list.
+	 */
+	if (prefer_busy_poll)
+		for (i = 0; i < nr; i++)
+			napi_resume_irqs(napi_ids[i]);
+	WRITE_ONCE(ep->nr_napi_ids, 0);
 	return false;
 }
 
@@ -471,7 +499,7 @@ static bool ep_busy_loop(struct eventpoll *ep)
 static inline void ep_set_busy_poll_napi_id(struct epitem *epi)
 {
 	struct eventpoll *ep = epi->ep;
-	unsigned int napi_id;
+	unsigned int napi_id, nr, i;
 	struct socket *sock;
 	struct sock *sk;
 
@@ -488,15 +516,33 @@ static inline void ep_set_busy_poll_napi_id(struct epitem *epi)
 
 	napi_id = READ_ONCE(sk->sk_napi_id);
 
-	/* Non-NAPI IDs can be rejected
-	 *	or
-	 * Nothing to do if we already have this ID
+	/* Non-NAPI IDs can be rejected */
+	if (!napi_id_valid(napi_id))
+		return;
+
+	/* Nothing to do if we already have this ID */
+	nr = min(READ_ONCE(ep->nr_napi_ids), NAPI_BUSY_GROUP_MAX);
+	for (i = 0; i < nr; i++)
+		if (READ_ONCE(ep->napi_ids[i]) == napi_id)
+			return;
+
+	/* record NAPI ID for use in next busy poll, once the group is full
+	 * the most recent ID replaces the last slot
 	 */
-	if (!napi_id_valid(napi_id) || napi_id == ep->napi_id)
+	if (nr < NAPI_BUSY_GROUP_MAX) {
+		WRITE_ONCE(ep->napi_ids[nr], napi_id);
+		WRITE_ONCE(ep->nr_napi_ids, nr + 1);
 		return;
+	}
 
-	/* record NAPI ID for use in next busy poll */
-	ep->napi_id = napi_id;
+	/* The evicted ID may have its IRQs suspended, hand it to
+	 * ep_resume_evicted_napi(). Keep the group as is while an
+	 * earlier eviction is still pending.
+	 */
+	if (READ_ONCE(ep->prefer_busy_poll) &&
+	    cmpxchg(&ep->napi_id_evicted, 0, READ_ONCE(ep->napi_ids[nr - 1])))
+		return;
+	WRITE_ONCE(ep->napi_ids[nr - 1], napi_id);
 }
 
 static long ep_eventpoll_bp_ioctl(struct file *file, unsigned int cmd,
@@ -544,18 +590,28 @@ static long ep_eventpoll_bp_ioctl(struct file *file, unsigned int cmd,
 
 static void ep_suspend_napi_irqs(struct eventpoll *ep)
 {
-	unsigned int napi_id = READ_ONCE(ep->napi_id);
+	unsigned int nr = min(READ_ONCE(ep->nr_napi_ids), NAPI_BUSY_GROUP_MAX);
+	unsigned int i;
+
+	if (!READ_ONCE(ep->prefer_busy_poll))
+		return;
 
-	if (napi_id_valid(napi_id) && READ_ONCE(ep->prefer_busy_poll))
-		napi_suspend_irqs(napi_id);
+	for (i = 0; i < nr; i++)
+		napi_suspend_irqs(READ_ONCE(ep->napi_ids[i]));
 }
 
 static void ep_resume_napi_irqs(struct eventpoll *ep)
 {
-	unsigned int napi_id = READ_ONCE(ep->napi_id);
+	unsigned int nr = min(READ_ONCE(ep->nr_napi_ids), NAPI_BUSY_GROUP_MAX);
+	unsigned int i;
 
-	if (napi_id_valid(napi_id) && READ_ONCE(ep->prefer_busy_poll))
-		napi_resume_irqs(napi_id);
+	ep_resume_evicted_napi(ep);
+
+	if (!READ_ONCE(ep->prefer_busy_poll))
+		return;
+
+	for (i = 0; i < nr; i++)
+		napi_resume_irqs(READ_ONCE(ep->napi_ids[i]));
 }
 
 #else
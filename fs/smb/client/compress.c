@@ -237,7 +237,7 @@ static bool is_compressible(const struct iov_iter *data)
 	if (len - read_size > max)
 		len = max;
 
-	sample = kvzalloc(len, GFP_KERNEL);
+	sample = kvmalloc(len, GFP_KERNEL);
 	if (!sample) {
 		WARN_ON_ONCE(1);
 
@@ -329,7 +329,7 @@ int smb_compress(struct TCP_Server_Info *server, struct smb_rqst *rq, compress_s
 		return -EINVAL;
 
 	slen = iov_iter_count(&rq->rq_iter);
-	src = kvzalloc(slen, GFP_KERNEL);
+	src = kvmalloc(slen, GFP_KERNEL);
 	if (!src) {
 		ret = -ENOMEM;
 		goto err_free;
@@ -750,6 +750,8 @@ struct request *blk_mq_alloc_request_hctx(struct request_queue *q,
 /*
  * Tag address space map.
  */
+struct blk_mq_tag_cache;
+
 struct blk_mq_tags {
 	unsigned int nr_tags;
 	unsigned int nr_reserved_tags;
@@ -758,6 +760,9 @@ struct blk_mq_tags {
 	struct sbitmap_queue bitmap_tags;
 	struct sbitmap_queue breserved_tags;
 
+	/* per-cpu cache of free bitmap_tags, NULL if not used */
+	struct blk_mq_tag_cache __percpu *pcpu_cache;
+
 	struct request **rqs;
 	struct request **static_rqs;
 	struct list_head page_list;
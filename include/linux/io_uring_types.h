@@ -232,6 +232,11 @@ struct io_alloc_cache {
 	unsigned int		max_cached;
 	unsigned int		elem_size;
 	unsigned int		init_clear;
+	unsigned long		nr_hits;
+	unsigned long		nr_misses;
+	/* entries returned without ->uring_lock held, e.g. from io-wq */
+	struct llist_head	remote;
+	atomic_t		nr_remote;
 };
 
 struct io_ring_ctx {
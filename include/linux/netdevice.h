@@ -352,6 +352,10 @@ struct gro_list {
  * @rx_list: list of pending ``GRO_NORMAL`` skbs
  * @rx_count: cached current length of @rx_list
  * @cached_napi_id: napi_struct::napi_id cached for hotpath, 0 for standalone
+ * @held: number of skbs held in all of @hash
+ * @flush_evict: held skbs flushed early to make room for a new flow
+ * @flush_proto: held skbs flushed because a protocol refused a merge
+ * @flush_poll: held skbs flushed at the end of a poll or by the flush timer
  */
 struct gro_node {
 	unsigned long		bitmask;
@@ -359,6 +363,10 @@ struct gro_node {
 	struct list_head	rx_list;
 	u32			rx_count;
 	u32			cached_napi_id;
+	u32			held;
+	u64			flush_evict;
+	u64			flush_proto;
+	u64			flush_poll;
 };
 
 /*
@@ -3467,6 +3475,8 @@ struct softnet_data {
 #endif
 
 	unsigned int		received_rps;
+	unsigned int		rps_steered;
+	unsigned int		rps_steered_remote_node;
 	bool			in_net_rx_action;
 	bool			in_napi_threaded_poll;
 
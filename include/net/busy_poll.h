@@ -57,6 +57,13 @@ void napi_busy_loop_rcu(unsigned int napi_id,
 			bool (*loop_end)(void *, unsigned long),
 			void *loop_end_arg, bool prefer_busy_poll, u16 budget);
 
+#define NAPI_BUSY_GROUP_MAX	4
+
+void napi_busy_loop_group(const unsigned int *napi_ids, unsigned int n,
+			  bool (*loop_end)(void *, unsigned long),
+			  void *loop_end_arg, bool prefer_busy_poll,
+			  u16 budget);
+
 void napi_suspend_irqs(unsigned int napi_id);
 void napi_resume_irqs(unsigned int napi_id);
 
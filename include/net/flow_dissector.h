@@ -395,6 +395,8 @@ struct flow_dissector {
 	unsigned long long  used_keys;
 		/* each bit represents presence of one key id */
 	unsigned short int offset[FLOW_DISSECTOR_KEY_MAX];
+	bool l4_fast;
+		/* only keys handled by the IPv4/IPv6 TCP/UDP fast path */
 };
 
 struct flow_keys_basic {
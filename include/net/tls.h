@@ -250,6 +250,11 @@ struct tls_context {
 			       */
 	unsigned long flags;
 
+	/* Rx zero-copy accounting, updated under the socket lock */
+	u64 rx_zc;
+	u64 rx_zc_no_pad;
+	u64 rx_zc_short_buf;
+
 	/* cache cold stuff */
 	struct proto *sk_proto;
 	struct sock *sk;
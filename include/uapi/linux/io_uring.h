@@ -225,6 +225,29 @@ enum io_uring_sqe_flags_bit {
 /* Use hybrid poll in iopoll process */
 #define IORING_SETUP_HYBRID_IOPOLL	(1U << 17)
 
+/*
+ * Let the SQPOLL thread pick between spinning, short sleeps and parking
+ * based on the observed SQE arrival rate, rather than always spinning for
+ * the full sq_thread_idle period. Only valid with IORING_SETUP_SQPOLL.
+ */
+#define IORING_SETUP_SQPOLL_ADAPTIVE	(1U << 18)
+
+/*
+ * Share an SQPOLL thread with other rings of the same process that set this
+ * flag, without having to pass a wq_fd. Threads are kept per NUMA node, and
+ * a new one is spawned once the existing ones serve enough rings. Only valid
+ * with IORING_SETUP_SQPOLL, and not with IORING_SETUP_ATTACH_WQ or
+ * IORING_SETUP_SQ_AFF.
+ */
+#define IORING_SETUP_SQPOLL_SHARED	(1U << 19)
+
+/*
+ * With IORING_SETUP_IOPOLL, only poll for read/write requests that set
+ * RWF_HIPRI in rw_flags. Others are issued to interrupt driven queues, and
+ * get reaped once their completion has been signalled.
+ */
+#define IORING_SETUP_IOPOLL_MIXED	(1U << 20)
+
 enum io_uring_op {
 	IORING_OP_NOP,
 	IORING_OP_READV,
@@ -375,7 +398,8 @@ enum io_uring_op {
  *				CQEs on behalf of the same SQE.
  *
  * IORING_RECVSEND_FIXED_BUF	Use registered buffers, the index is stored in
- *				the buf_index field.
+ *				the buf_index field. For recv, only valid
+ *				without buffer selection, multishot or bundles.
  *
  * IORING_SEND_ZC_REPORT_USAGE
  *				If set, SEND[MSG]_ZC should report
@@ -392,12 +416,21 @@ enum io_uring_op {
  *				the starting buffer ID in cqe->flags as per
  *				usual for provided buffer usage. The buffers
  *				will be	contiguous from the starting buffer ID.
+ *
+ * IORING_RECV_BUNDLE_COALESCE	Used with IORING_RECVSEND_BUNDLE for recv. If
+ *				more data is pending after a full bundle
+ *				transfer, keep appending further bundles to
+ *				the same completion rather than just one,
+ *				posting one CQE per burst of buffer ring
+ *				fills. As for a plain bundle, all but the
+ *				last buffer are filled completely.
  */
 #define IORING_RECVSEND_POLL_FIRST	(1U << 0)
 #define IORING_RECV_MULTISHOT		(1U << 1)
 #define IORING_RECVSEND_FIXED_BUF	(1U << 2)
 #define IORING_SEND_ZC_REPORT_USAGE	(1U << 3)
 #define IORING_RECVSEND_BUNDLE		(1U << 4)
+#define IORING_RECV_BUNDLE_COALESCE	(1U << 5)
 
 /*
  * cqe.res for IORING_CQE_F_NOTIF if
@@ -1007,6 +1040,15 @@ struct io_uring_zcrx_area_reg {
 	__u64	__resv2[2];
 };
 
+enum io_uring_zcrx_ifq_reg_flags {
+	/*
+	 * Don't bind a hardware rx queue, but place all received data into
+	 * the area by copying. For NICs that can't do header split, if_idx
+	 * and if_rxq are ignored.
+	 */
+	IORING_ZCRX_REG_COPY		= 1,
+};
+
 /*
  * Argument for IORING_REGISTER_ZCRX_IFQ
  */
@@ -68,6 +68,9 @@ enum {
 #define NBD_CFLAG_DISCONNECT_ON_CLOSE (1 << 1) /* disconnect the nbd device on
 						*  close by last opener.
 						*/
+#define NBD_CFLAG_LEAST_LOADED	(1 << 2) /* send each request on the
+					    connection with the fewest
+					    bytes in flight. */
 
 /* userspace doesn't need the nbd_device structure */
 
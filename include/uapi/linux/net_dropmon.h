@@ -120,6 +120,10 @@ enum {
 
 enum {
 	NET_DM_ATTR_STATS_DROPPED,		/* u64 */
+	NET_DM_ATTR_STATS_REASONS,		/* nested */
+	NET_DM_ATTR_STATS_REASON,		/* nested */
+	NET_DM_ATTR_STATS_REASON_NAME,		/* string */
+	NET_DM_ATTR_STATS_REASON_COUNT,		/* u64 */
 
 	__NET_DM_ATTR_STATS_MAX,
 	NET_DM_ATTR_STATS_MAX = __NET_DM_ATTR_STATS_MAX - 1
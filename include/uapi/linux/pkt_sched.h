@@ -495,6 +495,7 @@ enum {
 	TCA_NETEM_SLOT,
 	TCA_NETEM_SLOT_DIST,
 	TCA_NETEM_PRNG_SEED,
+	TCA_NETEM_DELAY_REPLAY,	/* flag: step through DELAY_DIST in order */
 	__TCA_NETEM_MAX,
 };
 
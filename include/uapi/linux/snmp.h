@@ -368,6 +368,9 @@ enum
 	LINUX_MIB_TLSTXREKEYOK,			/* TlsTxRekeyOk */
 	LINUX_MIB_TLSTXREKEYERROR,		/* TlsTxRekeyError */
 	LINUX_MIB_TLSRXREKEYRECEIVED,		/* TlsRxRekeyReceived */
+	LINUX_MIB_TLSRXZC,			/* TlsRxZeroCopy */
+	LINUX_MIB_TLSRXZCNOPAD,			/* TlsRxZcNoPadOff */
+	LINUX_MIB_TLSRXZCSHORTBUF,		/* TlsRxZcShortBuf */
 	__LINUX_MIB_TLSMAX
 };
 
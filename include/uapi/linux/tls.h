@@ -194,6 +194,9 @@ enum {
 	TLS_INFO_RXCONF,
 	TLS_INFO_ZC_RO_TX,
 	TLS_INFO_RX_NO_PAD,
+	TLS_INFO_RX_ZC,
+	TLS_INFO_RX_ZC_NO_PAD,
+	TLS_INFO_RX_ZC_SHORT_BUF,
 	__TLS_INFO_MAX,
 };
 #define TLS_INFO_MAX (__TLS_INFO_MAX - 1)
@@ -155,6 +155,11 @@
  * The ublk request is completed when its buffer is unregistered from all
  * io_uring instances and the ublk server issues UBLK_U_IO_COMMIT_AND_FETCH_REQ.
  *
+ * For network backed targets, the buffer of a WRITE request can be sent
+ * with IORING_OP_SEND_ZC and the buffer of a READ request can be filled
+ * with IORING_OP_RECV, both with IORING_RECVSEND_FIXED_BUF. The buffer is
+ * only registered for the request's data direction.
+ *
  * Not available for UBLK_F_UNPRIVILEGED_DEV, as a ublk server can leak
  * uninitialized kernel memory by not reading into the full request buffer.
  */
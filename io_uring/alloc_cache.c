@@ -5,6 +5,7 @@
 void io_alloc_cache_free(struct io_alloc_cache *cache,
 			 void (*free)(const void *))
 {
+	struct llist_node *node, *next;
 	void *entry;
 
 	if (!cache->entries)
@@ -12,6 +13,10 @@ void io_alloc_cache_free(struct io_alloc_cache *cache,
 
 	while ((entry = io_alloc_cache_get(cache)) != NULL)
 		free(entry);
+	llist_for_each_safe(node, next, llist_del_all(&cache->remote)) {
+		memset(node, 0, sizeof(*node));
+		free(node);
+	}
 
 	kvfree(cache->entries);
 	cache->entries = NULL;
@@ -30,13 +35,49 @@ bool io_alloc_cache_init(struct io_alloc_cache *cache,
 	cache->max_cached = max_nr;
 	cache->elem_size = size;
 	cache->init_clear = init_bytes;
+	cache->nr_hits = 0;
+	cache->nr_misses = 0;
+	init_llist_head(&cache->remote);
+	atomic_set(&cache->nr_remote, 0);
 	return false;
 }
 
+/*
+ * Return an entry to the cache from a context that doesn't hold the lock
+ * protecting it. The first bytes of the entry are used to link it, and get
+ * zeroed again when it's moved back into the cache. Callers must only use
+ * this for entries where that's a valid recycled state.
+ */
+bool io_alloc_cache_put_remote(struct io_alloc_cache *cache, void *entry)
+{
+	if (atomic_inc_return(&cache->nr_remote) > cache->max_cached) {
+		atomic_dec(&cache->nr_remote);
+		return false;
+	}
+	llist_add(entry, &cache->remote);
+	return true;
+}
+
+/* move remotely returned entries into the cache, called with the lock held */
+void io_alloc_cache_refill(struct io_alloc_cache *cache)
+{
+	struct llist_node *node, *next;
+	int nr = 0;
+
+	llist_for_each_safe(node, next, llist_del_all(&cache->remote)) {
+		memset(node, 0, sizeof(*node));
+		if (!io_alloc_cache_put(cache, node))
+			kfree(node);
+		nr++;
+	}
+	atomic_sub(nr, &cache->nr_remote);
+}
+
 void *io_cache_alloc_new(struct io_alloc_cache *cache, gfp_t gfp)
 {
 	void *obj;
 
+	cache->nr_misses++;
 	obj = kmalloc(cache->elem_size, gfp);
 	if (obj && cache->init_clear)
 		memset(obj, 0, cache->init_clear);
@@ -15,6 +15,8 @@ bool io_alloc_cache_init(struct io_alloc_cache *cache,
 			 unsigned int init_bytes);
 
 void *io_cache_alloc_new(struct io_alloc_cache *cache, gfp_t gfp);
+bool io_alloc_cache_put_remote(struct io_alloc_cache *cache, void *entry);
+void io_alloc_cache_refill(struct io_alloc_cache *cache);
 
 static inline bool io_alloc_cache_put(struct io_alloc_cache *cache,
 				      void *entry)
@@ -43,6 +45,7 @@ static inline void *io_alloc_cache_get(struct io_alloc_cache *cache)
 		if (cache->init_clear)
 			memset(entry, 0, cache->init_clear);
 #endif
+		cache->nr_hits++;
 		return entry;
 	}
 
@@ -56,6 +59,12 @@ static inline void *io_cache_alloc(struct io_alloc_cache *cache, gfp_t gfp)
 	obj = io_alloc_cache_get(cache);
 	if (obj)
 		return obj;
+	if (!llist_empty(&cache->remote)) {
+		io_alloc_cache_refill(cache);
+		obj = io_alloc_cache_get(cache);
+		if (obj)
+			return obj;
+	}
 	return io_cache_alloc_new(cache, gfp);
 }
 
@@ -55,6 +55,14 @@ static inline void napi_show_fdinfo(struct io_ring_ctx *ctx,
 }
 #endif
 
+static void io_alloc_cache_show_fdinfo(struct seq_file *m, const char *name,
+				       struct io_alloc_cache *cache)
+{
+	seq_printf(m, "%s:\tcached=%u hits=%lu misses=%lu remote=%d\n", name,
+		   cache->nr_cached, cache->nr_hits, cache->nr_misses,
+		   atomic_read(&cache->nr_remote));
+}
+
 static void __io_uring_show_fdinfo(struct io_ring_ctx *ctx, struct seq_file *m)
 {
 	struct io_overflow_cqe *ocqe;
@@ -70,6 +78,8 @@ static void __io_uring_show_fdinfo(struct io_ring_ctx *ctx, struct seq_file *m)
 	unsigned int sq_entries, cq_entries;
 	int sq_pid = -1, sq_cpu = -1;
 	u64 sq_total_time = 0, sq_work_time = 0;
+	u64 sq_spins = 0, sq_naps = 0, sq_parks = 0, sq_gap = 0;
+	int sq_adapt_state = -1;
 	unsigned int i;
 
 	if (ctx->flags & IORING_SETUP_CQE32)
@@ -159,6 +169,13 @@ static void __io_uring_show_fdinfo(struct io_ring_ctx *ctx, struct seq_file *m)
 			sq_total_time = (sq_usage.ru_stime.tv_sec * 1000000
 					 + sq_usage.ru_stime.tv_usec);
 			sq_work_time = sq->work_time;
+			sq_parks = data_race(sq->adapt_parks);
+			if (data_race(sq->adaptive)) {
+				sq_adapt_state = data_race(sq->adapt_state);
+				sq_gap = data_race(sq->adapt_gap_ns);
+				sq_spins = data_race(sq->adapt_spins);
+				sq_naps = data_race(sq->adapt_naps);
+			}
 		} else {
 			rcu_read_unlock();
 		}
@@ -168,6 +185,19 @@ static void __io_uring_show_fdinfo(struct io_ring_ctx *ctx, struct seq_file *m)
 	seq_printf(m, "SqThreadCpu:\t%d\n", sq_cpu);
 	seq_printf(m, "SqTotalTime:\t%llu\n", sq_total_time);
 	seq_printf(m, "SqWorkTime:\t%llu\n", sq_work_time);
+	seq_printf(m, "SqParks:\t%llu\n", sq_parks);
+	if (sq_adapt_state >= 0) {
+		static const char * const states[] = {
+			[IO_SQ_ADAPT_SPIN]	= "spin",
+			[IO_SQ_ADAPT_NAP]	= "nap",
+			[IO_SQ_ADAPT_PARK]	= "park",
+		};
+
+		seq_printf(m, "SqAdaptiveState:\t%s\n", states[sq_adapt_state]);
+		seq_printf(m, "SqArrivalGapNs:\t%llu\n", sq_gap);
+		seq_printf(m, "SqSpins:\t%llu\n", sq_spins);
+		seq_printf(m, "SqNaps:\t%llu\n", sq_naps);
+	}
 	seq_printf(m, "UserFiles:\t%u\n", ctx->file_table.data.nr);
 	for (i = 0; i < ctx->file_table.data.nr; i++) {
 		struct file *f = NULL;
@@ -212,6 +242,10 @@ static void __io_uring_show_fdinfo(struct io_ring_ctx *ctx, struct seq_file *m)
 
 	}
 	spin_unlock(&ctx->completion_lock);
+
+	io_alloc_cache_show_fdinfo(m, "RwCache", &ctx->rw_cache);
+	io_alloc_cache_show_fdinfo(m, "NetmsgCache", &ctx->netmsg_cache);
+	io_alloc_cache_show_fdinfo(m, "CmdCache", &ctx->cmd_cache);
 	napi_show_fdinfo(ctx, m);
 }
 
@@ -621,7 +621,8 @@ static void io_worker_handle_work(struct io_wq_acct *acct,
 		if (!work)
 			break;
 
-		__io_worker_busy(acct, worker);
+		/* @acct may not be ours if this work was stolen */
+		__io_worker_busy(io_wq_get_acct(worker), worker);
 
 		io_assign_current_work(worker, work);
 		__set_current_state(TASK_RUNNING);
@@ -669,6 +670,50 @@ static void io_worker_handle_work(struct io_wq_acct *acct,
 	} while (1);
 }
 
+/*
+ * An idle unbound worker may run bounded work if no bounded worker is free,
+ * rather than leaving it queued until a new bounded worker is up. The
+ * stolen work takes one of the bounded slots for as long as it runs, so
+ * the IORING_REGISTER_IOWQ_MAX_WORKERS limit on bounded concurrency still
+ * holds. Bounded work can't block indefinitely, so this won't tie the
+ * unbound worker up for long, and hashed ordering is still enforced by
+ * io_get_next_work().
+ */
+static bool io_wq_steal_bound_work(struct io_worker *worker)
+{
+	struct io_wq_acct *bound = io_get_acct(worker->wq, true);
+	bool ran = false;
+
+	if (io_wq_get_acct(worker) == bound)
+		return false;
+	if (!hlist_nulls_empty(&bound->free_list) ||
+	    !__io_acct_run_queue(bound))
+		return false;
+
+	raw_spin_lock(&bound->workers_lock);
+	if (bound->nr_workers >= bound->max_workers) {
+		raw_spin_unlock(&bound->workers_lock);
+		return false;
+	}
+	bound->nr_workers++;
+	raw_spin_unlock(&bound->workers_lock);
+
+	if (io_acct_run_queue(bound)) {
+		io_worker_handle_work(bound, worker);
+		ran = true;
+	}
+
+	raw_spin_lock(&bound->workers_lock);
+	bound->nr_workers--;
+	raw_spin_unlock(&bound->workers_lock);
+
+	/*
+	 * Work queued while we held the slot didn't get a worker created
+	 * for it, have the caller look again.
+	 */
+	return ran || __io_acct_run_queue(bound);
+}
+
 static int io_wq_worker(void *data)
 {
 	struct io_worker *worker = data;
@@ -694,6 +739,8 @@ static int io_wq_worker(void *data)
 		 */
 		while (io_acct_run_queue(acct))
 			io_worker_handle_work(acct, worker);
+		if (io_wq_steal_bound_work(worker))
+			continue;
 
 		raw_spin_lock(&acct->workers_lock);
 		/*
@@ -3580,14 +3580,28 @@ static int io_uring_sanitise_params(struct io_uring_params *p)
 			return -EINVAL;
 	}
 
+	/* SQPOLL_ADAPTIVE only valid with SQPOLL */
+	if ((flags & IORING_SETUP_SQPOLL_ADAPTIVE) &&
+	    !(flags & IORING_SETUP_SQPOLL))
+		return -EINVAL;
+
+	/* SQPOLL_SHARED picks its own thread, no explicit attach or affinity */
+	if (flags & IORING_SETUP_SQPOLL_SHARED) {
+		if (!(flags & IORING_SETUP_SQPOLL))
+			return -EINVAL;
+		if (flags & (IORING_SETUP_ATTACH_WQ | IORING_SETUP_SQ_AFF))
+			return -EINVAL;
+	}
+
 	if (flags & IORING_SETUP_TASKRUN_FLAG) {
 		if (!(flags & (IORING_SETUP_COOP_TASKRUN |
 			       IORING_SETUP_DEFER_TASKRUN)))
 			return -EINVAL;
 	}
 
-	/* HYBRID_IOPOLL only valid with IOPOLL */
-	if ((flags & IORING_SETUP_HYBRID_IOPOLL) && !(flags & IORING_SETUP_IOPOLL))
+	/* HYBRID_IOPOLL and IOPOLL_MIXED only valid with IOPOLL */
+	if ((flags & (IORING_SETUP_HYBRID_IOPOLL | IORING_SETUP_IOPOLL_MIXED)) &&
+	    !(flags & IORING_SETUP_IOPOLL))
 		return -EINVAL;
 
 	/*
@@ -3824,7 +3838,9 @@ static long io_uring_setup(u32 entries, struct io_uring_params __user *params)
 			IORING_SETUP_SQE128 | IORING_SETUP_CQE32 |
 			IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN |
 			IORING_SETUP_NO_MMAP | IORING_SETUP_REGISTERED_FD_ONLY |
-			IORING_SETUP_NO_SQARRAY | IORING_SETUP_HYBRID_IOPOLL))
+			IORING_SETUP_NO_SQARRAY | IORING_SETUP_HYBRID_IOPOLL |
+			IORING_SETUP_SQPOLL_ADAPTIVE | IORING_SETUP_SQPOLL_SHARED |
+			IORING_SETUP_IOPOLL_MIXED))
 		return -EINVAL;
 
 	return io_uring_create(entries, &p, params);
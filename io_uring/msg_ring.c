@@ -117,6 +117,14 @@ static struct io_kiocb *io_msg_get_kiocb(struct io_ring_ctx *ctx)
 	return kmem_cache_alloc(req_cachep, GFP_KERNEL | __GFP_NOWARN | __GFP_ZERO);
 }
 
+/*
+ * Cross-thread data messages to a DEFER_TASKRUN ring. This isn't a real
+ * task_work round-trip: io_req_task_work_add_remote() pushes the request
+ * onto the target's lock-free ->work_llist and lazily wakes the owner,
+ * which posts the CQE when it next runs local work from io_cqring_wait()
+ * or submit. That list already is a per-ring MPSC lane, so there's no
+ * separate one. The request comes from the target's ->msg_cache.
+ */
 static int io_msg_data_remote(struct io_ring_ctx *target_ctx,
 			      struct io_msg *msg)
 {
@@ -147,12 +155,26 @@ static int __io_msg_ring_data(struct io_ring_ctx *target_ctx,
 	if (target_ctx->flags & IORING_SETUP_R_DISABLED)
 		return -EBADFD;
 
-	if (io_msg_need_remote(target_ctx))
-		return io_msg_data_remote(target_ctx, msg);
-
 	if (msg->flags & IORING_MSG_RING_FLAGS_PASS)
 		flags = msg->cqe_flags;
 
+	if (io_msg_need_remote(target_ctx)) {
+		/*
+		 * Only the submitter task may fill the target CQ. If that's us,
+		 * e.g. one thread driving several rings, post directly rather
+		 * than bouncing the CQE through task_work.
+		 */
+		if (READ_ONCE(target_ctx->submitter_task) != current ||
+		    io_lock_external_ctx(target_ctx, issue_flags))
+			return io_msg_data_remote(target_ctx, msg);
+
+		ret = -EOVERFLOW;
+		if (io_post_aux_cqe(target_ctx, msg->user_data, msg->len, flags))
+			ret = 0;
+		io_double_unlock_ctx(target_ctx);
+		return ret;
+	}
+
 	ret = -EOVERFLOW;
 	if (target_ctx->flags & IORING_SETUP_IOPOLL) {
 		if (unlikely(io_lock_external_ctx(target_ctx, issue_flags)))
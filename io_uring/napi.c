@@ -8,11 +8,18 @@
 /* Timeout for cleanout of stale entries. */
 #define NAPI_TIMEOUT		(60 * SEC_CONVERSION)
 
+/*
+ * Dynamic tracking only busy polls entries that had a socket added within
+ * this window, so queues of long idle sockets aren't polled every loop.
+ */
+#define NAPI_ACTIVE_TIMEOUT	(HZ / 10)
+
 struct io_napi_entry {
 	unsigned int		napi_id;
 	struct list_head	list;
 
 	unsigned long		timeout;
+	unsigned long		last_active;
 	struct hlist_node	node;
 
 	struct rcu_head		rcu;
@@ -52,7 +59,11 @@ int __io_napi_add_id(struct io_ring_ctx *ctx, unsigned int napi_id)
 	scoped_guard(rcu) {
 		e = io_napi_hash_find(hash_list, napi_id);
 		if (e) {
-			WRITE_ONCE(e->timeout, jiffies + NAPI_TIMEOUT);
+			/* avoid dirtying the entry more than once per tick */
+			if (READ_ONCE(e->last_active) != jiffies) {
+				WRITE_ONCE(e->last_active, jiffies);
+				WRITE_ONCE(e->timeout, jiffies + NAPI_TIMEOUT);
+			}
 			return -EEXIST;
 		}
 	}
@@ -63,6 +74,7 @@ int __io_napi_add_id(struct io_ring_ctx *ctx, unsigned int napi_id)
 
 	e->napi_id = napi_id;
 	e->timeout = jiffies + NAPI_TIMEOUT;
+	e->last_active = jiffies;
 
 	/*
 	 * guard(spinlock) is not used to manually unlock it before calling
@@ -179,13 +191,26 @@ dynamic_tracking_do_busy_loop(struct io_ring_ctx *ctx,
 {
 	struct io_napi_entry *e;
 	bool is_stale = false;
+	bool polled = false;
 
 	list_for_each_entry_rcu(e, &ctx->napi_list, list) {
+		if (time_after(jiffies, READ_ONCE(e->timeout)))
+			is_stale = true;
+		if (time_after(jiffies, READ_ONCE(e->last_active) +
+					NAPI_ACTIVE_TIMEOUT))
+			continue;
+
 		napi_busy_loop_rcu(e->napi_id, loop_end, loop_end_arg,
 				   ctx->napi_prefer_busy_poll, BUSY_POLL_BUDGET);
+		polled = true;
+	}
 
-		if (time_after(jiffies, READ_ONCE(e->timeout)))
-			is_stale = true;
+	/* nothing recently active, don't turn this into a pure spin */
+	if (!polled) {
+		list_for_each_entry_rcu(e, &ctx->napi_list, list)
+			napi_busy_loop_rcu(e->napi_id, loop_end, loop_end_arg,
+					   ctx->napi_prefer_busy_poll,
+					   BUSY_POLL_BUDGET);
 	}
 
 	return is_stale;
@@ -76,6 +76,7 @@ struct io_sr_msg {
 	/* initialised and used only by !msg send variants */
 	u16				buf_group;
 	unsigned short			retry_flags;
+	unsigned short			nr_bundle_retries;
 	void __user			*msg_control;
 	/* used only for send zerocopy */
 	struct io_kiocb 		*notif;
@@ -93,6 +94,12 @@ enum sr_retry_flags {
  */
 #define MULTISHOT_MAX_RETRY	32
 
+/*
+ * Number of extra bundles that IORING_RECV_BUNDLE_COALESCE may append to a
+ * single completion. Without it, only one extra bundle is appended.
+ */
+#define BUNDLE_COALESCE_MAX_RETRY	16
+
 struct io_recvzc {
 	struct file			*file;
 	unsigned			msg_flags;
@@ -153,9 +160,16 @@ static void io_netmsg_recycle(struct io_kiocb *req, unsigned int issue_flags)
 {
 	struct io_async_msghdr *hdr = req->async_data;
 
-	/* can't recycle, ensure we free the iovec if we have one */
+	/*
+	 * Can't touch the cache without the lock. Free the iovec, which leaves
+	 * the leading vec cleared, and hand it back through the remote list.
+	 */
 	if (unlikely(issue_flags & IO_URING_F_UNLOCKED)) {
 		io_netmsg_iovec_free(hdr);
+		if (io_alloc_cache_put_remote(&req->ctx->netmsg_cache, hdr)) {
+			req->async_data = NULL;
+			req->flags &= ~(REQ_F_ASYNC_DATA|REQ_F_NEED_CLEANUP);
+		}
 		return;
 	}
 
@@ -193,6 +207,7 @@ static inline void io_mshot_prep_retry(struct io_kiocb *req,
 	req->flags &= ~REQ_F_BL_EMPTY;
 	sr->done_io = 0;
 	sr->retry_flags = 0;
+	sr->nr_bundle_retries = 0;
 	sr->len = 0; /* get from the provided buffer */
 }
 
@@ -739,6 +754,10 @@ static int io_recvmsg_prep_setup(struct io_kiocb *req)
 		kmsg->msg.msg_iocb = NULL;
 		kmsg->msg.msg_ubuf = NULL;
 
+		if (sr->flags & IORING_RECVSEND_FIXED_BUF) {
+			req->flags |= REQ_F_IMPORT_BUFFER;
+			return 0;
+		}
 		if (req->flags & REQ_F_BUFFER_SELECT)
 			return 0;
 		return import_ubuf(ITER_DEST, sr->buf, sr->len,
@@ -749,7 +768,8 @@ static int io_recvmsg_prep_setup(struct io_kiocb *req)
 }
 
 #define RECVMSG_FLAGS (IORING_RECVSEND_POLL_FIRST | IORING_RECV_MULTISHOT | \
-			IORING_RECVSEND_BUNDLE)
+			IORING_RECVSEND_BUNDLE | IORING_RECV_BUNDLE_COALESCE | \
+			IORING_RECVSEND_FIXED_BUF)
 
 int io_recvmsg_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 {
@@ -757,6 +777,7 @@ int io_recvmsg_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 
 	sr->done_io = 0;
 	sr->retry_flags = 0;
+	sr->nr_bundle_retries = 0;
 
 	if (unlikely(sqe->file_index || sqe->addr2))
 		return -EINVAL;
@@ -783,6 +804,15 @@ int io_recvmsg_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 		sr->buf_group = req->buf_index;
 		req->buf_list = NULL;
 	}
+	if (sr->flags & IORING_RECVSEND_FIXED_BUF) {
+		/* plain recv into a single registered buffer only */
+		if (req->opcode != IORING_OP_RECV ||
+		    (req->flags & REQ_F_BUFFER_SELECT) ||
+		    (sr->flags & (IORING_RECV_MULTISHOT |
+				  IORING_RECVSEND_BUNDLE)))
+			return -EINVAL;
+		req->buf_index = READ_ONCE(sqe->buf_index);
+	}
 	if (sr->flags & IORING_RECV_MULTISHOT) {
 		if (!(req->flags & REQ_F_BUFFER_SELECT))
 			return -EINVAL;
@@ -795,6 +825,8 @@ int io_recvmsg_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 	if (sr->flags & IORING_RECVSEND_BUNDLE) {
 		if (req->opcode == IORING_OP_RECVMSG)
 			return -EINVAL;
+	} else if (sr->flags & IORING_RECV_BUNDLE_COALESCE) {
+		return -EINVAL;
 	}
 
 	if (io_is_compat(req->ctx))
@@ -825,6 +857,10 @@ static inline bool io_recv_finish(struct io_kiocb *req, int *ret,
 
 	if (sr->flags & IORING_RECVSEND_BUNDLE) {
 		size_t this_ret = *ret - sr->done_io;
+		unsigned int max_retries = 1;
+
+		if (sr->flags & IORING_RECV_BUNDLE_COALESCE)
+			max_retries = BUNDLE_COALESCE_MAX_RETRY;
 
 		cflags |= io_put_kbufs(req, this_ret, io_bundle_nbufs(kmsg, this_ret),
 				      issue_flags);
@@ -837,12 +873,15 @@ static inline bool io_recv_finish(struct io_kiocb *req, int *ret,
 		 * If more is available AND it was a full transfer, retry and
 		 * append to this one
 		 */
-		if (!sr->retry_flags && kmsg->msg.msg_inq > 1 && this_ret > 0 &&
+		if (!(sr->retry_flags & IO_SR_MSG_PARTIAL_MAP) &&
+		    sr->nr_bundle_retries < max_retries &&
+		    kmsg->msg.msg_inq > 1 && this_ret > 0 &&
 		    !iov_iter_count(&kmsg->msg.msg_iter)) {
 			req->cqe.flags = cflags & ~CQE_F_MASK;
 			sr->len = kmsg->msg.msg_inq;
 			sr->done_io += this_ret;
 			sr->retry_flags |= IO_SR_MSG_RETRY;
+			sr->nr_bundle_retries++;
 			return false;
 		}
 	} else {
@@ -1136,6 +1175,15 @@ int io_recv(struct io_kiocb *req, unsigned int issue_flags)
 	if (unlikely(!sock))
 		return -ENOTSOCK;
 
+	if (req->flags & REQ_F_IMPORT_BUFFER) {
+		ret = io_import_reg_buf(req, &kmsg->msg.msg_iter,
+					(u64)(uintptr_t)sr->buf, sr->len,
+					ITER_DEST, issue_flags);
+		if (unlikely(ret))
+			return ret;
+		req->flags &= ~REQ_F_IMPORT_BUFFER;
+	}
+
 	flags = sr->msg_flags;
 	if (force_nonblock)
 		flags |= MSG_DONTWAIT;
@@ -1474,6 +1474,34 @@ static int io_kern_bvec_size(struct iovec *iov, unsigned nr_iovs,
 	return 0;
 }
 
+/*
+ * Merge iovecs that are adjacent in the registered buffer, which is common
+ * when scatter/gather entries are carved out of one large arena. Returns the
+ * new number of entries, which are moved to stay right aligned in the array.
+ */
+static unsigned io_coalesce_reg_iovs(struct iovec *iov, unsigned nr_iovs)
+{
+	unsigned i, nr = 0;
+
+	for (i = 1; i < nr_iovs; i++) {
+		struct iovec *prev = &iov[nr];
+		size_t len;
+
+		if (prev->iov_len && iov[i].iov_len &&
+		    prev->iov_base + prev->iov_len == iov[i].iov_base &&
+		    !check_add_overflow(prev->iov_len, iov[i].iov_len, &len)) {
+			prev->iov_len = len;
+			continue;
+		}
+		iov[++nr] = iov[i];
+	}
+	nr++;
+
+	if (nr != nr_iovs)
+		memmove(iov + nr_iovs - nr, iov, nr * sizeof(*iov));
+	return nr;
+}
+
 int io_import_reg_vec(int ddir, struct iov_iter *iter,
 			struct io_kiocb *req, struct iou_vec *vec,
 			unsigned nr_iovs, unsigned issue_flags)
@@ -1494,6 +1522,18 @@ int io_import_reg_vec(int ddir, struct iov_iter *iter,
 	iovec_off = vec->nr - nr_iovs;
 	iov = vec->iovec + iovec_off;
 
+	if (nr_iovs > 1) {
+		unsigned nr = io_coalesce_reg_iovs(iov, nr_iovs);
+
+		iov += nr_iovs - nr;
+		nr_iovs = nr;
+	}
+	/* a single segment can point straight into the registered bvec table */
+	if (nr_iovs == 1 && iov->iov_len)
+		return io_import_fixed(ddir, iter, imu,
+				       (u64)(uintptr_t)iov->iov_base,
+				       iov->iov_len);
+
 	if (imu->is_kbuf) {
 		int ret = io_kern_bvec_size(iov, nr_iovs, imu, &nr_segs);
 
@@ -871,7 +871,9 @@ static int io_rw_init_file(struct io_kiocb *req, fmode_t mode, int rw_type)
 		if (!(kiocb->ki_flags & IOCB_DIRECT) || !file->f_op->iopoll)
 			return -EOPNOTSUPP;
 		kiocb->private = NULL;
-		kiocb->ki_flags |= IOCB_HIPRI;
+		/* for IOPOLL_MIXED, RWF_HIPRI already set IOCB_HIPRI if wanted */
+		if (!(ctx->flags & IORING_SETUP_IOPOLL_MIXED))
+			kiocb->ki_flags |= IOCB_HIPRI;
 		req->iopoll_completed = 0;
 		if (ctx->flags & IORING_SETUP_HYBRID_IOPOLL) {
 			/* make sure every req only blocks once*/
@@ -1307,6 +1309,16 @@ static int io_uring_hybrid_poll(struct io_kiocb *req,
 	return ret;
 }
 
+static bool io_rw_should_poll(struct io_kiocb *req)
+{
+	struct io_rw *rw;
+
+	if (req->opcode == IORING_OP_URING_CMD)
+		return true;
+	rw = io_kiocb_to_cmd(req, struct io_rw);
+	return rw->kiocb.ki_flags & IOCB_HIPRI;
+}
+
 int io_do_iopoll(struct io_ring_ctx *ctx, bool force_nonspin)
 {
 	struct io_wq_work_node *pos, *start, *prev;
@@ -1333,6 +1345,11 @@ int io_do_iopoll(struct io_ring_ctx *ctx, bool force_nonspin)
 		if (READ_ONCE(req->iopoll_completed))
 			break;
 
+		/* interrupt driven, nothing to poll for */
+		if ((ctx->flags & IORING_SETUP_IOPOLL_MIXED) &&
+		    !io_rw_should_poll(req))
+			continue;
+
 		if (ctx->flags & IORING_SETUP_HYBRID_IOPOLL)
 			ret = io_uring_hybrid_poll(req, &iob, poll_flags);
 		else
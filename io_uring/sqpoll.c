@@ -11,6 +11,7 @@
 #include <linux/audit.h>
 #include <linux/security.h>
 #include <linux/cpuset.h>
+#include <linux/hrtimer.h>
 #include <linux/io_uring.h>
 
 #include <uapi/linux/io_uring.h>
@@ -23,6 +24,23 @@
 #define IORING_SQPOLL_CAP_ENTRIES_VALUE 8
 #define IORING_TW_CAP_ENTRIES_VALUE	32
 
+/*
+ * Adaptive SQPOLL: if SQEs arrive closer together than this on average, keep
+ * spinning. Otherwise nap in between checks for up to IO_SQ_ADAPT_NAP_MAX_NS,
+ * and park right away if the average gap exceeds the idle period.
+ */
+#define IO_SQ_ADAPT_SPIN_NS		(20 * NSEC_PER_USEC)
+#define IO_SQ_ADAPT_NAP_MAX_NS		(1 * NSEC_PER_MSEC)
+
+/*
+ * Max number of rings served by a single IORING_SETUP_SQPOLL_SHARED thread
+ * before a new one gets created on the same node.
+ */
+#define IO_SQD_POOL_MAX_RINGS		16
+
+static DEFINE_MUTEX(io_sqd_pool_lock);
+static LIST_HEAD(io_sqd_pool);
+
 enum {
 	IO_SQ_THREAD_SHOULD_STOP = 0,
 	IO_SQ_THREAD_SHOULD_PARK,
@@ -82,6 +100,11 @@ void io_put_sq_data(struct io_sq_data *sqd)
 	if (refcount_dec_and_test(&sqd->refs)) {
 		WARN_ON_ONCE(atomic_read(&sqd->park_pending));
 
+		if (!list_empty(&sqd->pool_list)) {
+			mutex_lock(&io_sqd_pool_lock);
+			list_del(&sqd->pool_list);
+			mutex_unlock(&io_sqd_pool_lock);
+		}
 		io_sq_thread_stop(sqd);
 		kfree(sqd);
 	}
@@ -91,10 +114,15 @@ static __cold void io_sqd_update_thread_idle(struct io_sq_data *sqd)
 {
 	struct io_ring_ctx *ctx;
 	unsigned sq_thread_idle = 0;
+	bool adaptive = false;
 
-	list_for_each_entry(ctx, &sqd->ctx_list, sqd_list)
+	list_for_each_entry(ctx, &sqd->ctx_list, sqd_list) {
 		sq_thread_idle = max(sq_thread_idle, ctx->sq_thread_idle);
+		if (ctx->flags & IORING_SETUP_SQPOLL_ADAPTIVE)
+			adaptive = true;
+	}
 	sqd->sq_thread_idle = sq_thread_idle;
+	sqd->adaptive = adaptive;
 }
 
 void io_sq_thread_finish(struct io_ring_ctx *ctx)
@@ -134,13 +162,50 @@ static struct io_sq_data *io_attach_sq_data(struct io_uring_params *p)
 	return sqd;
 }
 
+/*
+ * Find the least loaded shared SQPOLL thread of this process on the local
+ * node that can still take another ring.
+ */
+static struct io_sq_data *io_attach_pool_sq_data(int nid)
+{
+	struct io_sq_data *sqd, *best = NULL;
+	unsigned int best_refs = IO_SQD_POOL_MAX_RINGS;
+
+	mutex_lock(&io_sqd_pool_lock);
+	list_for_each_entry(sqd, &io_sqd_pool, pool_list) {
+		unsigned int refs = refcount_read(&sqd->refs);
+
+		if (sqd->task_tgid != current->tgid || sqd->pool_nid != nid)
+			continue;
+		/* dying, don't attach */
+		if (!rcu_access_pointer(sqd->thread))
+			continue;
+		if (refs && refs < best_refs) {
+			best = sqd;
+			best_refs = refs;
+		}
+	}
+	if (best && !refcount_inc_not_zero(&best->refs))
+		best = NULL;
+	mutex_unlock(&io_sqd_pool_lock);
+	return best;
+}
+
 static struct io_sq_data *io_get_sq_data(struct io_uring_params *p,
 					 bool *attached)
 {
 	struct io_sq_data *sqd;
+	int nid = NUMA_NO_NODE;
 
 	*attached = false;
-	if (p->flags & IORING_SETUP_ATTACH_WQ) {
+	if (p->flags & IORING_SETUP_SQPOLL_SHARED) {
+		nid = numa_node_id();
+		sqd = io_attach_pool_sq_data(nid);
+		if (sqd) {
+			*attached = true;
+			return sqd;
+		}
+	} else if (p->flags & IORING_SETUP_ATTACH_WQ) {
 		sqd = io_attach_sq_data(p);
 		if (!IS_ERR(sqd)) {
 			*attached = true;
@@ -157,6 +222,8 @@ static struct io_sq_data *io_get_sq_data(struct io_uring_params *p,
 
 	atomic_set(&sqd->park_pending, 0);
 	refcount_set(&sqd->refs, 1);
+	sqd->pool_nid = nid;
+	INIT_LIST_HEAD(&sqd->pool_list);
 	INIT_LIST_HEAD(&sqd->ctx_list);
 	mutex_init(&sqd->lock);
 	init_waitqueue_head(&sqd->wait);
@@ -266,6 +333,73 @@ static void io_sq_update_worktime(struct io_sq_data *sqd, struct rusage *start)
 	sqd->work_time += end.ru_stime.tv_usec + end.ru_stime.tv_sec * 1000000;
 }
 
+/*
+ * Track an EWMA of the time between loops that found work to do. The gap is
+ * clamped to the idle period so that a single long park doesn't take forever
+ * to age out once the ring gets busy again.
+ */
+static void io_sq_adapt_note_work(struct io_sq_data *sqd)
+{
+	u64 now = ktime_get_ns();
+	u64 gap = now - sqd->adapt_last_work;
+
+	gap = min_t(u64, gap, jiffies_to_nsecs(sqd->sq_thread_idle));
+	sqd->adapt_last_work = now;
+	sqd->adapt_gap_ns = (sqd->adapt_gap_ns * 7 + gap) >> 3;
+}
+
+static void io_sq_adapt_nap(struct io_sq_data *sqd)
+{
+	ktime_t expires;
+	u64 nap;
+
+	/* sleep for half the expected gap, so we're back before the next SQE */
+	nap = clamp_t(u64, sqd->adapt_gap_ns >> 1, IO_SQ_ADAPT_SPIN_NS,
+		      IO_SQ_ADAPT_NAP_MAX_NS);
+	expires = ns_to_ktime(nap);
+
+	mutex_unlock(&sqd->lock);
+	set_current_state(TASK_INTERRUPTIBLE);
+	if (!io_sqd_events_pending(sqd))
+		schedule_hrtimeout_range(&expires, nap >> 2, HRTIMER_MODE_REL);
+	__set_current_state(TASK_RUNNING);
+	mutex_lock(&sqd->lock);
+	sqd->sq_cpu = raw_smp_processor_id();
+}
+
+/*
+ * Called when no work was found in the last loop. Returns true if the thread
+ * should keep polling, false if it should go to sleep and wait for a wakeup.
+ */
+static bool io_sq_idle_poll(struct io_sq_data *sqd, unsigned long timeout)
+{
+	u64 idle_ns;
+
+	if (time_after(jiffies, timeout))
+		return false;
+	if (!sqd->adaptive)
+		return true;
+
+	if (sqd->adapt_gap_ns <= IO_SQ_ADAPT_SPIN_NS) {
+		sqd->adapt_state = IO_SQ_ADAPT_SPIN;
+		sqd->adapt_spins++;
+		return true;
+	}
+	/*
+	 * The gap is clamped to the idle period and the integer EWMA only
+	 * creeps towards it, so park once it's within 1/8 of the idle time.
+	 */
+	idle_ns = jiffies_to_nsecs(sqd->sq_thread_idle);
+	if (sqd->adapt_gap_ns < idle_ns - (idle_ns >> 3)) {
+		sqd->adapt_state = IO_SQ_ADAPT_NAP;
+		sqd->adapt_naps++;
+		io_sq_adapt_nap(sqd);
+		return true;
+	}
+	sqd->adapt_state = IO_SQ_ADAPT_PARK;
+	return false;
+}
+
 static int io_sq_thread(void *data)
 {
 	struct llist_node *retry_list = NULL;
@@ -293,6 +427,9 @@ static int io_sq_thread(void *data)
 
 	if (sqd->sq_cpu != -1) {
 		set_cpus_allowed_ptr(current, cpumask_of(sqd->sq_cpu));
+	} else if (sqd->pool_nid != NUMA_NO_NODE) {
+		set_cpus_allowed_ptr(current, cpumask_of_node(sqd->pool_nid));
+		sqd->sq_cpu = raw_smp_processor_id();
 	} else {
 		set_cpus_allowed_ptr(current, cpu_online_mask);
 		sqd->sq_cpu = raw_smp_processor_id();
@@ -326,15 +463,20 @@ static int io_sq_thread(void *data)
 		}
 		if (io_sq_tw(&retry_list, IORING_TW_CAP_ENTRIES_VALUE))
 			sqt_spin = true;
+		/* rotate the starting ring so capped submits stay fair */
+		if (cap_entries)
+			list_rotate_left(&sqd->ctx_list);
 
 		list_for_each_entry(ctx, &sqd->ctx_list, sqd_list)
 			if (io_napi(ctx))
 				io_napi_sqpoll_busy_poll(ctx);
 
-		if (sqt_spin || !time_after(jiffies, timeout)) {
+		if (sqt_spin || io_sq_idle_poll(sqd, timeout)) {
 			if (sqt_spin) {
 				io_sq_update_worktime(sqd, &start);
 				timeout = jiffies + sqd->sq_thread_idle;
+				if (sqd->adaptive)
+					io_sq_adapt_note_work(sqd);
 			}
 			if (unlikely(need_resched())) {
 				mutex_unlock(&sqd->lock);
@@ -371,6 +513,7 @@ static int io_sq_thread(void *data)
 			}
 
 			if (needs_sched) {
+				sqd->adapt_parks++;
 				mutex_unlock(&sqd->lock);
 				schedule();
 				mutex_lock(&sqd->lock);
@@ -488,7 +631,7 @@ __cold int io_sq_offload_create(struct io_ring_ctx *ctx,
 
 		sqd->task_pid = current->pid;
 		sqd->task_tgid = current->tgid;
-		tsk = create_io_thread(io_sq_thread, sqd, NUMA_NO_NODE);
+		tsk = create_io_thread(io_sq_thread, sqd, sqd->pool_nid);
 		if (IS_ERR(tsk)) {
 			ret = PTR_ERR(tsk);
 			goto err_sqpoll;
@@ -498,6 +641,12 @@ __cold int io_sq_offload_create(struct io_ring_ctx *ctx,
 		rcu_assign_pointer(sqd->thread, tsk);
 		mutex_unlock(&sqd->lock);
 
+		if (sqd->pool_nid != NUMA_NO_NODE) {
+			mutex_lock(&io_sqd_pool_lock);
+			list_add_tail(&sqd->pool_list, &io_sqd_pool);
+			mutex_unlock(&io_sqd_pool_lock);
+		}
+
 		get_task_struct(tsk);
 		ret = io_uring_alloc_task_context(tsk, ctx);
 		wake_up_new_task(tsk);
@@ -1,5 +1,11 @@
 // SPDX-License-Identifier: GPL-2.0
 
+enum io_sq_adapt_state {
+	IO_SQ_ADAPT_SPIN,
+	IO_SQ_ADAPT_NAP,
+	IO_SQ_ADAPT_PARK,
+};
+
 struct io_sq_data {
 	refcount_t		refs;
 	atomic_t		park_pending;
@@ -13,12 +19,24 @@ struct io_sq_data {
 
 	unsigned		sq_thread_idle;
 	int			sq_cpu;
+	/* node for IORING_SETUP_SQPOLL_SHARED threads, else NUMA_NO_NODE */
+	int			pool_nid;
+	struct list_head	pool_list;
 	pid_t			task_pid;
 	pid_t			task_tgid;
 
 	u64			work_time;
 	unsigned long		state;
 	struct completion	exited;
+
+	/* IORING_SETUP_SQPOLL_ADAPTIVE state, protected by ->lock */
+	bool			adaptive;
+	enum io_sq_adapt_state	adapt_state;
+	u64			adapt_last_work;
+	u64			adapt_gap_ns;
+	u64			adapt_spins;
+	u64			adapt_naps;
+	u64			adapt_parks;
 };
 
 int io_sq_offload_create(struct io_ring_ctx *ctx, struct io_uring_params *p);
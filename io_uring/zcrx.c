@@ -553,7 +553,9 @@ int io_register_zcrx_ifq(struct io_ring_ctx *ctx,
 	if (memchr_inv(&reg.__resv, 0, sizeof(reg.__resv)) ||
 	    reg.__resv2 || reg.zcrx_id)
 		return -EINVAL;
-	if (reg.if_rxq == -1 || !reg.rq_entries || reg.flags)
+	if (!reg.rq_entries || (reg.flags & ~IORING_ZCRX_REG_COPY))
+		return -EINVAL;
+	if (!(reg.flags & IORING_ZCRX_REG_COPY) && reg.if_rxq == -1)
 		return -EINVAL;
 	if (reg.rq_entries > IO_RQ_MAX_ENTRIES) {
 		if (!(ctx->flags & IORING_SETUP_CLAMP))
@@ -564,11 +566,16 @@ int io_register_zcrx_ifq(struct io_ring_ctx *ctx,
 
 	if (copy_from_user(&area, u64_to_user_ptr(reg.area_ptr), sizeof(area)))
 		return -EFAULT;
+	/* the copy fallback can't write into dmabuf areas */
+	if ((reg.flags & IORING_ZCRX_REG_COPY) &&
+	    (area.flags & IORING_ZCRX_AREA_DMABUF))
+		return -EINVAL;
 
 	ifq = io_zcrx_ifq_alloc(ctx);
 	if (!ifq)
 		return -ENOMEM;
 	ifq->rq_entries = reg.rq_entries;
+	ifq->copy_mode = reg.flags & IORING_ZCRX_REG_COPY;
 
 	scoped_guard(mutex, &ctx->mmap_lock) {
 		/* preallocate id */
@@ -581,6 +588,13 @@ int io_register_zcrx_ifq(struct io_ring_ctx *ctx,
 	if (ret)
 		goto err;
 
+	if (ifq->copy_mode) {
+		ret = io_zcrx_create_area(ifq, &ifq->area, &area);
+		if (ret)
+			goto err;
+		goto publish;
+	}
+
 	ifq->netdev = netdev_get_by_index(current->nsproxy->net_ns, reg.if_idx,
 					  &ifq->netdev_tracker, GFP_KERNEL);
 	if (!ifq->netdev) {
@@ -605,7 +619,7 @@ int io_register_zcrx_ifq(struct io_ring_ctx *ctx,
 	if (ret)
 		goto err;
 	ifq->if_rxq = reg.if_rxq;
-
+publish:
 	reg.offsets.rqes = sizeof(struct io_uring);
 	reg.offsets.head = offsetof(struct io_uring, head);
 	reg.offsets.tail = offsetof(struct io_uring, tail);
@@ -736,6 +750,25 @@ static struct io_uring_zcrx_rqe *io_zcrx_get_rqe(struct io_zcrx_ifq *ifq,
 	return &ifq->rqes[idx];
 }
 
+static struct net_iov *io_zcrx_parse_rqe(struct io_zcrx_ifq *ifq,
+					  struct io_uring_zcrx_rqe *rqe)
+{
+	struct io_zcrx_area *area;
+	unsigned niov_idx, area_idx;
+
+	area_idx = rqe->off >> IORING_ZCRX_AREA_SHIFT;
+	niov_idx = (rqe->off & ~IORING_ZCRX_AREA_MASK) >> PAGE_SHIFT;
+
+	if (unlikely(rqe->__pad || area_idx))
+		return NULL;
+	area = ifq->area;
+
+	if (unlikely(niov_idx >= area->nia.num_niovs))
+		return NULL;
+	niov_idx = array_index_nospec(niov_idx, area->nia.num_niovs);
+	return &area->nia.niovs[niov_idx];
+}
+
 static void io_zcrx_ring_refill(struct page_pool *pp,
 				struct io_zcrx_ifq *ifq)
 {
@@ -754,23 +787,10 @@ static void io_zcrx_ring_refill(struct page_pool *pp,
 
 	do {
 		struct io_uring_zcrx_rqe *rqe = io_zcrx_get_rqe(ifq, mask);
-		struct io_zcrx_area *area;
 		struct net_iov *niov;
-		unsigned niov_idx, area_idx;
-
-		area_idx = rqe->off >> IORING_ZCRX_AREA_SHIFT;
-		niov_idx = (rqe->off & ~IORING_ZCRX_AREA_MASK) >> PAGE_SHIFT;
-
-		if (unlikely(rqe->__pad || area_idx))
-			continue;
-		area = ifq->area;
 
-		if (unlikely(niov_idx >= area->nia.num_niovs))
-			continue;
-		niov_idx = array_index_nospec(niov_idx, area->nia.num_niovs);
-
-		niov = &area->nia.niovs[niov_idx];
-		if (!io_zcrx_put_niov_uref(niov))
+		niov = io_zcrx_parse_rqe(ifq, rqe);
+		if (!niov || !io_zcrx_put_niov_uref(niov))
 			continue;
 
 		netmem = net_iov_to_netmem(niov);
@@ -929,10 +949,39 @@ static bool io_zcrx_queue_cqe(struct io_kiocb *req, struct net_iov *niov,
 	return true;
 }
 
+/*
+ * With no page pool bound to the ifq, nobody else consumes the refill queue.
+ * Put returned buffers straight back onto the area freelist.
+ */
+static void io_zcrx_copy_refill(struct io_zcrx_ifq *ifq)
+{
+	unsigned int mask = ifq->rq_entries - 1;
+	unsigned int entries;
+
+	spin_lock_bh(&ifq->rq_lock);
+	entries = io_zcrx_rqring_entries(ifq);
+	while (entries--) {
+		struct io_uring_zcrx_rqe *rqe = io_zcrx_get_rqe(ifq, mask);
+		struct net_iov *niov;
+
+		niov = io_zcrx_parse_rqe(ifq, rqe);
+		if (!niov || !io_zcrx_put_niov_uref(niov))
+			continue;
+		if (page_pool_unref_netmem(net_iov_to_netmem(niov), 1) != 0)
+			continue;
+		io_zcrx_return_niov(niov);
+	}
+	smp_store_release(&ifq->rq_ring->head, ifq->cached_rq_head);
+	spin_unlock_bh(&ifq->rq_lock);
+}
+
 static struct net_iov *io_zcrx_alloc_fallback(struct io_zcrx_area *area)
 {
 	struct net_iov *niov = NULL;
 
+	if (area->ifq->copy_mode && !READ_ONCE(area->free_count))
+		io_zcrx_copy_refill(area->ifq);
+
 	spin_lock_bh(&area->freelist_lock);
 	if (area->free_count)
 		niov = __io_zcrx_get_free_niov(area);
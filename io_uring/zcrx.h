@@ -48,6 +48,8 @@ struct io_zcrx_ifq {
 	u32				rq_entries;
 
 	u32				if_rxq;
+	/* IORING_ZCRX_REG_COPY, no hw queue bound and no page pool */
+	bool				copy_mode;
 	struct device			*dev;
 	struct net_device		*netdev;
 	netdevice_tracker		netdev_tracker;
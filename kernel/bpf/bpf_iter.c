@@ -85,9 +85,41 @@ static bool bpf_iter_support_resched(struct seq_file *seq)
 /* maximum visited objects before bailing out */
 #define MAX_ITER_OBJECTS	1000000
 
+/* seq buffer size bounds; the buffer grows towards the read() size */
+#define MIN_ITER_SEQ_BUF	(PAGE_SIZE << 3)
+#define MAX_ITER_SEQ_BUF	(PAGE_SIZE << 8)
+
+/* Grow the (empty) seq buffer so that one read() can return as many objects
+ * as the caller has room for. Keep the old buffer if a larger one cannot be
+ * had; it only means more read() calls.
+ */
+static int bpf_seq_grow_buf(struct seq_file *seq, size_t size)
+{
+	size_t want;
+	void *buf;
+
+	if (size >= MAX_ITER_SEQ_BUF)
+		want = MAX_ITER_SEQ_BUF;
+	else if (size <= MIN_ITER_SEQ_BUF)
+		want = MIN_ITER_SEQ_BUF;
+	else
+		want = roundup_pow_of_two(size);
+	if (want <= seq->size)
+		return 0;
+
+	buf = kvmalloc(want, GFP_KERNEL | (seq->buf ? __GFP_NOWARN : 0));
+	if (!buf)
+		return seq->buf ? 0 : -ENOMEM;
+
+	kvfree(seq->buf);
+	seq->buf = buf;
+	seq->size = want;
+	return 0;
+}
+
 /* bpf_seq_read, a customized and simpler version for bpf iterator.
  * The following are differences from seq_read():
- *  . fixed buffer size (PAGE_SIZE)
+ *  . buffer sized from the read() size, between MIN/MAX_ITER_SEQ_BUF
  *  . assuming NULL ->llseek()
  *  . stop() may call bpf program, handling potential overflow there
  */
@@ -102,13 +134,10 @@ static ssize_t bpf_seq_read(struct file *file, char __user *buf, size_t size,
 
 	mutex_lock(&seq->lock);
 
-	if (!seq->buf) {
-		seq->size = PAGE_SIZE << 3;
-		seq->buf = kvmalloc(seq->size, GFP_KERNEL);
-		if (!seq->buf) {
-			err = -ENOMEM;
+	if (!seq->buf || (!seq->count && size > seq->size)) {
+		err = bpf_seq_grow_buf(seq, size);
+		if (err)
 			goto done;
-		}
 	}
 
 	if (seq->count) {
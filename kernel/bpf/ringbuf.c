@@ -417,6 +417,14 @@ static void *__bpf_ringbuf_reserve(struct bpf_ringbuf *rb, u64 size)
 
 	cons_pos = smp_load_acquire(&rb->consumer_pos);
 
+	/* Fail fast without the lock when the consumer is behind, so that
+	 * producers on all CPUs do not serialize only to find the ring full.
+	 * producer_pos only grows, so a stale value can let us through to
+	 * the check below but never rejects a reservation it would accept.
+	 */
+	if (READ_ONCE(rb->producer_pos) + len - cons_pos > rb->mask)
+		return NULL;
+
 	if (raw_res_spin_lock_irqsave(&rb->spinlock, flags))
 		return NULL;
 
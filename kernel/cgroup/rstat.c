@@ -420,6 +420,15 @@ __bpf_kfunc void css_rstat_flush(struct cgroup_subsys_state *css)
 	for_each_possible_cpu(cpu) {
 		struct cgroup_subsys_state *pos;
 
+		/*
+		 * Skip CPUs on which nothing in this subtree was updated
+		 * without taking the locks. This pairs with the lockless
+		 * check in css_rstat_updated(); an update racing with us is
+		 * no different from one that lands right after the flush.
+		 */
+		if (!data_race(css_rstat_cpu(css, cpu)->updated_next))
+			continue;
+
 		/* Reacquire for each CPU to avoid disabling IRQs too long */
 		__css_rstat_lock(css, cpu);
 		pos = css_rstat_updated_list(css, cpu);
@@ -5844,6 +5844,7 @@ ftrace_set_hash(struct ftrace_ops *ops, unsigned char *buf, int len,
 		unsigned long *ips, unsigned int cnt,
 		int remove, int reset, int enable, char *mod)
 {
+	int size_bits = FTRACE_HASH_DEFAULT_BITS;
 	struct ftrace_hash **orig_hash;
 	struct ftrace_hash *hash;
 	int ret;
@@ -5858,10 +5859,25 @@ ftrace_set_hash(struct ftrace_ops *ops, unsigned char *buf, int len,
 	else
 		orig_hash = &ops->func_hash->notrace_hash;
 
+	/*
+	 * Bulk address updates (fprobe, kprobe_multi) can add tens of
+	 * thousands of entries; size the working hash for them like
+	 * __move_hash() would, instead of piling them onto the default
+	 * number of buckets.
+	 */
+	if (ips) {
+		unsigned long count = cnt;
+
+		if (!reset && *orig_hash)
+			count += (*orig_hash)->count;
+		size_bits = clamp_t(int, fls(count / 2),
+				    FTRACE_HASH_DEFAULT_BITS, FTRACE_HASH_MAX_BITS);
+	}
+
 	if (reset)
-		hash = alloc_ftrace_hash(FTRACE_HASH_DEFAULT_BITS);
+		hash = alloc_ftrace_hash(size_bits);
 	else
-		hash = alloc_and_copy_ftrace_hash(FTRACE_HASH_DEFAULT_BITS, *orig_hash);
+		hash = alloc_and_copy_ftrace_hash(size_bits, *orig_hash);
 
 	if (!hash) {
 		ret = -ENOMEM;
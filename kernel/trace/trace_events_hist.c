@@ -5705,7 +5705,7 @@ static void hist_trigger_show(struct seq_file *m,
 	track_data_snapshot_print(m, hist_data);
 
 	seq_printf(m, "\nTotals:\n    Hits: %llu\n    Entries: %u\n    Dropped: %llu\n",
-		   (u64)atomic64_read(&hist_data->map->hits),
+		   (u64)tracing_map_read_hits(hist_data->map),
 		   n_entries, (u64)atomic64_read(&hist_data->map->drops));
 }
 
@@ -5724,7 +5724,7 @@ static u64 get_hist_hit_count(struct trace_event_file *event_file)
 	list_for_each_entry(data, &event_file->triggers, list) {
 		if (data->cmd_ops->trigger_type == ETT_EVENT_HIST) {
 			hist_data = data->private_data;
-			ret += atomic64_read(&hist_data->map->hits);
+			ret += tracing_map_read_hits(hist_data->map);
 		}
 	}
 	return ret;
@@ -16,6 +16,8 @@
 #include <linux/slab.h>
 #include <linux/sort.h>
 #include <linux/kmemleak.h>
+#include <linux/percpu.h>
+#include <asm/local64.h>
 
 #include "tracing_map.h"
 #include "trace.h"
@@ -535,7 +537,7 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 			if (val &&
 			    keys_match(key, val->key, map->key_size)) {
 				if (!lookup_only)
-					atomic64_inc(&map->hits);
+					local64_inc(this_cpu_ptr(map->hits));
 				return val;
 			} else if (unlikely(!val)) {
 				/*
@@ -580,7 +582,7 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 				 */
 				smp_wmb();
 				WRITE_ONCE(entry->val, elt);
-				atomic64_inc(&map->hits);
+				local64_inc(this_cpu_ptr(map->hits));
 
 				return entry->val;
 			} else {
@@ -681,9 +683,30 @@ void tracing_map_destroy(struct tracing_map *map)
 	tracing_map_free_elts(map);
 
 	tracing_map_array_free(map->map);
+	free_percpu(map->hits);
 	kfree(map);
 }
 
+/**
+ * tracing_map_read_hits - Return the number of hits on a tracing_map
+ * @map: The tracing_map
+ *
+ * Sums the per-cpu hit counters updated by tracing_map_insert() and
+ * tracing_map_lookup(). May race with concurrent inserts.
+ *
+ * Return: The total number of successful inserts and lookups.
+ */
+u64 tracing_map_read_hits(struct tracing_map *map)
+{
+	u64 hits = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		hits += local64_read(per_cpu_ptr(map->hits, cpu));
+
+	return hits;
+}
+
 /**
  * tracing_map_clear - Clear a tracing_map
  * @map: The tracing_map to clear
@@ -698,9 +721,11 @@ void tracing_map_destroy(struct tracing_map *map)
 void tracing_map_clear(struct tracing_map *map)
 {
 	unsigned int i;
+	int cpu;
 
 	atomic_set(&map->next_elt, 0);
-	atomic64_set(&map->hits, 0);
+	for_each_possible_cpu(cpu)
+		local64_set(per_cpu_ptr(map->hits, cpu), 0);
 	atomic64_set(&map->drops, 0);
 
 	tracing_map_array_clear(map->map);
@@ -795,6 +820,11 @@ struct tracing_map *tracing_map_create(unsigned int map_bits,
 	if (!map->map)
 		goto free;
 
+	/* Hits are counted on every event; keep that off a shared line. */
+	map->hits = alloc_percpu(local64_t);
+	if (!map->hits)
+		goto free;
+
 	map->key_size = key_size;
 	for (i = 0; i < TRACING_MAP_KEYS_MAX; i++)
 		map->key_idx[i] = -1;
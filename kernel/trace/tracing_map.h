@@ -196,7 +196,7 @@ struct tracing_map {
 	unsigned int			n_keys;
 	struct tracing_map_sort_key	sort_key;
 	unsigned int			n_vars;
-	atomic64_t			hits;
+	local64_t __percpu		*hits;
 	atomic64_t			drops;
 };
 
@@ -252,6 +252,7 @@ extern int tracing_map_add_key_field(struct tracing_map *map,
 
 extern void tracing_map_destroy(struct tracing_map *map);
 extern void tracing_map_clear(struct tracing_map *map);
+extern u64 tracing_map_read_hits(struct tracing_map *map);
 
 extern struct tracing_map_elt *
 tracing_map_insert(struct tracing_map *map, void *key);
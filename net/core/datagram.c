@@ -694,9 +694,11 @@ zerocopy_fill_skb_from_devmem(struct sk_buff *skb, struct iov_iter *from,
 			      int length,
 			      struct net_devmem_dmabuf_binding *binding)
 {
-	int i = skb_shinfo(skb)->nr_frags;
+	int first = skb_shinfo(skb)->nr_frags;
 	size_t virt_addr, size, off;
 	struct net_iov *niov;
+	int i = first;
+	int err = 0;
 
 	/* Devmem filling works by taking an IOVEC from the user where the
 	 * iov_addrs are interpreted as an offset in bytes into the dma-buf to
@@ -707,18 +709,21 @@ zerocopy_fill_skb_from_devmem(struct sk_buff *skb, struct iov_iter *from,
 		return -EFAULT;
 
 	while (length && iov_iter_count(from)) {
-		if (i == MAX_SKB_FRAGS)
-			return -EMSGSIZE;
+		if (i == MAX_SKB_FRAGS) {
+			err = -EMSGSIZE;
+			break;
+		}
 
 		virt_addr = (size_t)iter_iov_addr(from);
 		niov = net_devmem_get_niov_at(binding, virt_addr, &off, &size);
-		if (!niov)
-			return -EFAULT;
+		if (!niov) {
+			err = -EFAULT;
+			break;
+		}
 
 		size = min_t(size_t, size, length);
 		size = min_t(size_t, size, iter_iov_len(from));
 
-		get_netmem(net_iov_to_netmem(niov));
 		skb_add_rx_frag_netmem(skb, i, net_iov_to_netmem(niov), off,
 				       size, PAGE_SIZE);
 		iov_iter_advance(from, size);
@@ -726,7 +731,13 @@ zerocopy_fill_skb_from_devmem(struct sk_buff *skb, struct iov_iter *from,
 		i++;
 	}
 
-	return 0;
+	/* Every frag comes from @binding, so take their references, which
+	 * get_netmem() would take one by one, in a single atomic op.
+	 */
+	if (i > first)
+		net_devmem_dmabuf_binding_get_many(binding, i - first);
+
+	return err;
 }
 
 int __zerocopy_sg_from_iter(struct msghdr *msg, struct sock *sk,
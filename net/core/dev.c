@@ -5139,6 +5139,25 @@ static bool skb_flow_limit(struct sk_buff *skb, unsigned int qlen)
 	return false;
 }
 
+#ifdef CONFIG_RPS
+/* Account packets this CPU steered to another CPU's backlog, and how many of
+ * those crossed a NUMA node. Called with IRQs disabled.
+ */
+static void rps_steered_inc(int cpu)
+{
+	struct softnet_data *mysd = this_cpu_ptr(&softnet_data);
+
+	if (cpu == smp_processor_id())
+		return;
+
+	/* Pairs with READ_ONCE() in softnet_seq_show() */
+	WRITE_ONCE(mysd->rps_steered, mysd->rps_steered + 1);
+	if (cpu_to_node(cpu) != numa_node_id())
+		WRITE_ONCE(mysd->rps_steered_remote_node,
+			   mysd->rps_steered_remote_node + 1);
+}
+#endif
+
 /*
  * enqueue_to_backlog is called to queue an skb to a per CPU backlog
  * queue (may be a remote CPU queue).
@@ -5177,6 +5196,9 @@ static int enqueue_to_backlog(struct sk_buff *skb, int cpu,
 		}
 		__skb_queue_tail(&sd->input_pkt_queue, skb);
 		tail = rps_input_queue_tail_incr(sd);
+#ifdef CONFIG_RPS
+		rps_steered_inc(cpu);
+#endif
 		backlog_unlock_irq_restore(sd, &flags);
 
 		/* save the tail outside of the critical section */
@@ -5345,6 +5367,25 @@ netif_skb_check_for_xdp(struct sk_buff **pskb, const struct bpf_prog *prog)
 	return skb_linearize(skb);
 }
 
+/* Page pool backed frags that nobody else references can be handed to the
+ * program as they are, without copying the skb into fresh page pool pages
+ * first. For an XDP_REDIRECT into an AF_XDP socket this leaves a single
+ * copy, straight from the driver's pages into the umem.
+ *
+ * Only checked once the head already has XDP_PACKET_HEADROOM, so in
+ * practice this covers multi-buffer skbs from page pool drivers that
+ * always reserve XDP headroom in their rx buffers (e.g. mvneta with jumbo
+ * frames). Drivers building skbs with NET_SKB_PAD of headroom, or without
+ * page pool (no pp_recycle), still take the copy.
+ */
+static bool netif_skb_xdp_frags_ok(const struct sk_buff *skb,
+				   const struct bpf_prog *prog)
+{
+	return prog->aux->xdp_has_frags && skb->pp_recycle &&
+	       !skb_has_frag_list(skb) && !skb_has_shared_frag(skb) &&
+	       !skb_zcopy(skb) && skb_frags_readable(skb);
+}
+
 static u32 netif_receive_generic_xdp(struct sk_buff **pskb,
 				     struct xdp_buff *xdp,
 				     const struct bpf_prog *xdp_prog)
@@ -5365,8 +5406,8 @@ static u32 netif_receive_generic_xdp(struct sk_buff **pskb,
 	mac_len = skb->data - skb_mac_header(skb);
 	__skb_push(skb, mac_len);
 
-	if (skb_cloned(skb) || skb_is_nonlinear(skb) ||
-	    skb_headroom(skb) < XDP_PACKET_HEADROOM) {
+	if (skb_cloned(skb) || skb_headroom(skb) < XDP_PACKET_HEADROOM ||
+	    (skb_is_nonlinear(skb) && !netif_skb_xdp_frags_ok(skb, xdp_prog))) {
 		if (netif_skb_check_for_xdp(pskb, xdp_prog))
 			goto do_drop;
 	}
@@ -6814,6 +6855,142 @@ void napi_busy_loop(unsigned int napi_id,
 }
 EXPORT_SYMBOL(napi_busy_loop);
 
+struct napi_busy_group_ent {
+	struct napi_struct *napi;
+	void *have_poll_lock;
+	bool owned;
+};
+
+static void napi_busy_group_stop(struct napi_busy_group_ent *ent,
+				 unsigned int n, unsigned int flags,
+				 u16 budget)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		if (!ent[i].owned)
+			continue;
+		busy_poll_stop(ent[i].napi, ent[i].have_poll_lock, flags,
+			       budget);
+		ent[i].owned = false;
+	}
+}
+
+static void __napi_busy_loop_group(const unsigned int *napi_ids,
+				   unsigned int n,
+				   bool (*loop_end)(void *, unsigned long),
+				   void *loop_end_arg, unsigned int flags,
+				   u16 budget)
+{
+	struct napi_busy_group_ent ent[NAPI_BUSY_GROUP_MAX];
+	unsigned long start_time = busy_loop_current_time();
+	struct bpf_net_context __bpf_net_ctx, *bpf_net_ctx;
+	unsigned int i;
+
+	WARN_ON_ONCE(!rcu_read_lock_held());
+
+restart:
+	for (i = 0; i < n; i++) {
+		ent[i].napi = napi_by_id(napi_ids[i]);
+		ent[i].owned = false;
+	}
+
+	if (!IS_ENABLED(CONFIG_PREEMPT_RT))
+		preempt_disable();
+	for (;;) {
+		for (i = 0; i < n; i++) {
+			struct napi_struct *napi = ent[i].napi;
+			int work = 0;
+
+			if (!napi)
+				continue;
+
+			local_bh_disable();
+			bpf_net_ctx = bpf_net_ctx_set(&__bpf_net_ctx);
+			if (!ent[i].owned) {
+				unsigned long val = READ_ONCE(napi->state);
+
+				/* Same ownership rules as __napi_busy_loop(),
+				 * a NAPI busy elsewhere is simply skipped.
+				 */
+				if (val & (NAPIF_STATE_DISABLE | NAPIF_STATE_SCHED |
+					   NAPIF_STATE_IN_BUSY_POLL) ||
+				    cmpxchg(&napi->state, val,
+					    val | NAPIF_STATE_IN_BUSY_POLL |
+						  NAPIF_STATE_SCHED) != val) {
+					if (flags & NAPI_F_PREFER_BUSY_POLL)
+						set_bit(NAPI_STATE_PREFER_BUSY_POLL,
+							&napi->state);
+					goto count;
+				}
+				ent[i].have_poll_lock = netpoll_poll_lock(napi);
+				ent[i].owned = true;
+			}
+			work = napi->poll(napi, budget);
+			trace_napi_poll(napi, work, budget);
+			gro_normal_list(&napi->gro);
+count:
+			if (work > 0)
+				__NET_ADD_STATS(dev_net(napi->dev),
+						LINUX_MIB_BUSYPOLLRXPACKETS, work);
+			skb_defer_free_flush(this_cpu_ptr(&softnet_data));
+			bpf_net_ctx_clear(bpf_net_ctx);
+			local_bh_enable();
+		}
+
+		if (loop_end(loop_end_arg, start_time))
+			break;
+
+		if (unlikely(need_resched())) {
+			napi_busy_group_stop(ent, n, flags, budget);
+			if (!IS_ENABLED(CONFIG_PREEMPT_RT))
+				preempt_enable();
+			rcu_read_unlock();
+			cond_resched();
+			rcu_read_lock();
+			if (loop_end(loop_end_arg, start_time))
+				return;
+			goto restart;
+		}
+		cpu_relax();
+	}
+	napi_busy_group_stop(ent, n, flags, budget);
+	if (!IS_ENABLED(CONFIG_PREEMPT_RT))
+		preempt_enable();
+}
+
+/**
+ * napi_busy_loop_group - busy poll a small set of NAPI instances
+ * @napi_ids: array of NAPI ids to poll
+ * @n: number of entries in @napi_ids, at most %NAPI_BUSY_GROUP_MAX
+ * @loop_end: called after each round, returns true to stop polling
+ * @loop_end_arg: argument passed to @loop_end
+ * @prefer_busy_poll: set NAPI_STATE_PREFER_BUSY_POLL on polled instances
+ * @budget: budget given to each NAPI poll
+ *
+ * Like napi_busy_loop(), but polls every NAPI in @napi_ids once per round,
+ * so that a caller whose sockets are spread over several RX queues can busy
+ * poll all of them. Instances owned by someone else are skipped for the
+ * round. Ownership of the other instances is kept until the loop ends or
+ * needs to reschedule.
+ */
+void napi_busy_loop_group(const unsigned int *napi_ids, unsigned int n,
+			  bool (*loop_end)(void *, unsigned long),
+			  void *loop_end_arg, bool prefer_busy_poll,
+			  u16 budget)
+{
+	unsigned int flags = prefer_busy_poll ? NAPI_F_PREFER_BUSY_POLL : 0;
+
+	if (WARN_ON_ONCE(!n || n > NAPI_BUSY_GROUP_MAX || !loop_end))
+		return;
+
+	rcu_read_lock();
+	__napi_busy_loop_group(napi_ids, n, loop_end, loop_end_arg, flags,
+			       budget);
+	rcu_read_unlock();
+}
+EXPORT_SYMBOL(napi_busy_loop_group);
+
 void napi_suspend_irqs(unsigned int napi_id)
 {
 	struct napi_struct *napi;
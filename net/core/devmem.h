@@ -125,6 +125,16 @@ net_devmem_dmabuf_binding_get(struct net_devmem_dmabuf_binding *binding)
 	return refcount_inc_not_zero(&binding->ref);
 }
 
+/* Take @nr references at once for frags added from a binding the caller
+ * already holds a reference on.
+ */
+static inline void
+net_devmem_dmabuf_binding_get_many(struct net_devmem_dmabuf_binding *binding,
+				   unsigned int nr)
+{
+	refcount_add(nr, &binding->ref);
+}
+
 static inline void
 net_devmem_dmabuf_binding_put(struct net_devmem_dmabuf_binding *binding)
 {
@@ -152,6 +162,12 @@ net_devmem_get_niov_at(struct net_devmem_dmabuf_binding *binding, size_t addr,
 #else
 struct net_devmem_dmabuf_binding;
 
+static inline void
+net_devmem_dmabuf_binding_get_many(struct net_devmem_dmabuf_binding *binding,
+				   unsigned int nr)
+{
+}
+
 static inline void
 net_devmem_dmabuf_binding_put(struct net_devmem_dmabuf_binding *binding)
 {
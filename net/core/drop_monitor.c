@@ -93,10 +93,19 @@ struct dm_hw_stat_delta {
 	struct rcu_head rcu;
 };
 
+/* Software drops aggregated by core drop reason while monitoring is on.
+ * Subsystem specific reasons are accounted as not specified.
+ */
+struct net_dm_reason_stats {
+	u64_stats_t count[SKB_DROP_REASON_MAX];
+	struct u64_stats_sync syncp;
+};
+
 static struct genl_family net_drop_monitor_family;
 
 static DEFINE_PER_CPU(struct per_cpu_dm_data, dm_cpu_data);
 static DEFINE_PER_CPU(struct per_cpu_dm_data, dm_hw_cpu_data);
+static DEFINE_PER_CPU(struct net_dm_reason_stats, dm_reason_stats);
 
 static int dm_hit_limit = 64;
 static int dm_delay = 1;
@@ -263,11 +272,28 @@ static void trace_drop_common(struct sk_buff *skb, void *location)
 	raw_spin_unlock_irqrestore(&data->lock, flags);
 }
 
+static void net_dm_reason_count(enum skb_drop_reason reason)
+{
+	struct net_dm_reason_stats *stats;
+	unsigned long flags;
+
+	if (reason >= SKB_DROP_REASON_MAX)
+		reason = SKB_DROP_REASON_NOT_SPECIFIED;
+
+	local_irq_save(flags);
+	stats = this_cpu_ptr(&dm_reason_stats);
+	u64_stats_update_begin(&stats->syncp);
+	u64_stats_inc(&stats->count[reason]);
+	u64_stats_update_end(&stats->syncp);
+	local_irq_restore(flags);
+}
+
 static void trace_kfree_skb_hit(void *ignore, struct sk_buff *skb,
 				void *location,
 				enum skb_drop_reason reason,
 				struct sock *rx_sk)
 {
+	net_dm_reason_count(reason);
 	trace_drop_common(skb, location);
 }
 
@@ -502,6 +528,8 @@ static void net_dm_packet_trace_kfree_skb_hit(void *ignore,
 	struct sk_buff *nskb;
 	unsigned long flags;
 
+	net_dm_reason_count(reason);
+
 	if (!skb_mac_header_was_set(skb))
 		return;
 
@@ -1458,6 +1486,65 @@ static void net_dm_stats_read(struct net_dm_stats *stats)
 	}
 }
 
+static int net_dm_reason_stats_put(struct sk_buff *msg)
+{
+	const struct drop_reason_list *list;
+	struct nlattr *attr, *entry;
+	int cpu, rc = -EMSGSIZE;
+	u64 *counts;
+	u32 i;
+
+	counts = kcalloc(SKB_DROP_REASON_MAX, sizeof(*counts), GFP_KERNEL);
+	if (!counts)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		struct net_dm_reason_stats *stats = &per_cpu(dm_reason_stats, cpu);
+		unsigned int start;
+
+		for (i = 0; i < SKB_DROP_REASON_MAX; i++) {
+			u64 count;
+
+			do {
+				start = u64_stats_fetch_begin(&stats->syncp);
+				count = u64_stats_read(&stats->count[i]);
+			} while (u64_stats_fetch_retry(&stats->syncp, start));
+
+			counts[i] += count;
+		}
+	}
+
+	attr = nla_nest_start(msg, NET_DM_ATTR_STATS_REASONS);
+	if (!attr)
+		goto out;
+
+	rcu_read_lock();
+	list = rcu_dereference(drop_reasons_by_subsys[SKB_DROP_REASON_SUBSYS_CORE]);
+	for (i = 0; i < SKB_DROP_REASON_MAX; i++) {
+		if (!counts[i] || i >= list->n_reasons || !list->reasons[i])
+			continue;
+
+		entry = nla_nest_start(msg, NET_DM_ATTR_STATS_REASON);
+		if (!entry ||
+		    nla_put_string(msg, NET_DM_ATTR_STATS_REASON_NAME,
+				   list->reasons[i]) ||
+		    nla_put_u64_64bit(msg, NET_DM_ATTR_STATS_REASON_COUNT,
+				      counts[i], NET_DM_ATTR_PAD)) {
+			rcu_read_unlock();
+			nla_nest_cancel(msg, attr);
+			goto out;
+		}
+		nla_nest_end(msg, entry);
+	}
+	rcu_read_unlock();
+
+	nla_nest_end(msg, attr);
+	rc = 0;
+out:
+	kfree(counts);
+	return rc;
+}
+
 static int net_dm_stats_put(struct sk_buff *msg)
 {
 	struct net_dm_stats stats;
@@ -1473,6 +1560,9 @@ static int net_dm_stats_put(struct sk_buff *msg)
 			      u64_stats_read(&stats.dropped), NET_DM_ATTR_PAD))
 		goto nla_put_failure;
 
+	if (net_dm_reason_stats_put(msg))
+		goto nla_put_failure;
+
 	nla_nest_end(msg, attr);
 
 	return 0;
@@ -1553,12 +1643,26 @@ static int net_dm_stats_fill(struct sk_buff *msg, struct genl_info *info)
 	return -EMSGSIZE;
 }
 
+static size_t net_dm_stats_size(void)
+{
+	return NLMSG_DEFAULT_SIZE +
+	       /* NET_DM_ATTR_STATS_REASONS nest */
+	       nla_total_size(0) +
+	       SKB_DROP_REASON_MAX *
+	       (/* NET_DM_ATTR_STATS_REASON nest */
+		nla_total_size(0) +
+		/* NET_DM_ATTR_STATS_REASON_NAME */
+		nla_total_size(NET_DM_MAX_REASON_LEN + 1) +
+		/* NET_DM_ATTR_STATS_REASON_COUNT */
+		nla_total_size_64bit(sizeof(u64)));
+}
+
 static int net_dm_cmd_stats_get(struct sk_buff *skb, struct genl_info *info)
 {
 	struct sk_buff *msg;
 	int rc;
 
-	msg = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+	msg = nlmsg_new(net_dm_stats_size(), GFP_KERNEL);
 	if (!msg)
 		return -ENOMEM;
 
@@ -1692,6 +1796,7 @@ static void net_dm_cpu_data_init(int cpu)
 
 	data = &per_cpu(dm_cpu_data, cpu);
 	__net_dm_cpu_data_init(data);
+	u64_stats_init(&per_cpu(dm_reason_stats, cpu).syncp);
 }
 
 static void net_dm_cpu_data_fini(int cpu)
@@ -43,6 +43,20 @@ static void dissector_set_key(struct flow_dissector *flow_dissector,
 	flow_dissector->used_keys |= (1ULL << key_id);
 }
 
+/* Keys which are either filled in by __skb_flow_dissect_l4_fast() or never
+ * touched by the generic walker for a plain IPv4/IPv6 TCP/UDP packet.
+ */
+#define FLOW_DISSECTOR_L4_FAST_KEYS				\
+	(BIT_ULL(FLOW_DISSECTOR_KEY_CONTROL) |			\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_BASIC) |			\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_IPV4_ADDRS) |		\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_IPV6_ADDRS) |		\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_PORTS) |			\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_FLOW_LABEL) |		\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_TIPC) |			\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_VLAN) |			\
+	 BIT_ULL(FLOW_DISSECTOR_KEY_GRE_KEYID))
+
 void skb_flow_dissector_init(struct flow_dissector *flow_dissector,
 			     const struct flow_dissector_key *key,
 			     unsigned int key_count)
@@ -70,6 +84,9 @@ void skb_flow_dissector_init(struct flow_dissector *flow_dissector,
 				   FLOW_DISSECTOR_KEY_CONTROL));
 	BUG_ON(!dissector_uses_key(flow_dissector,
 				   FLOW_DISSECTOR_KEY_BASIC));
+
+	flow_dissector->l4_fast =
+		!(flow_dissector->used_keys & ~FLOW_DISSECTOR_L4_FAST_KEYS);
 }
 EXPORT_SYMBOL(skb_flow_dissector_init);
 
@@ -1035,6 +1052,108 @@ static bool is_pppoe_ses_hdr_valid(const struct pppoe_hdr *hdr)
 	return hdr->ver == 1 && hdr->type == 1 && hdr->code == 0;
 }
 
+/* Fast path for dissectors limited to FLOW_DISSECTOR_L4_FAST_KEYS: parse a
+ * plain IPv4 or IPv6 header directly followed by TCP or UDP without going
+ * through the generic walker. Returns false, with nothing written to the
+ * target container, if the packet needs the full dissector.
+ */
+static bool
+__skb_flow_dissect_l4_fast(const struct sk_buff *skb,
+			   struct flow_dissector *flow_dissector,
+			   void *target_container, const void *data,
+			   __be16 proto, int nhoff, int hlen,
+			   unsigned int flags,
+			   struct flow_dissector_key_control *key_control,
+			   struct flow_dissector_key_basic *key_basic)
+{
+	struct flow_dissector_key_addrs *key_addrs;
+	struct flow_dissector_key_tags *key_tags;
+	u8 ip_proto;
+
+	switch (proto) {
+	case htons(ETH_P_IP): {
+		const struct iphdr *iph;
+		struct iphdr _iph;
+
+		iph = __skb_header_pointer(skb, nhoff, sizeof(_iph), data, hlen, &_iph);
+		if (!iph || iph->ihl < 5 || ip_is_fragment(iph))
+			return false;
+
+		ip_proto = iph->protocol;
+		if (ip_proto != IPPROTO_TCP && ip_proto != IPPROTO_UDP)
+			return false;
+
+		nhoff += iph->ihl * 4;
+
+		if (dissector_uses_key(flow_dissector,
+				       FLOW_DISSECTOR_KEY_IPV4_ADDRS)) {
+			key_addrs = skb_flow_dissector_target(flow_dissector,
+							      FLOW_DISSECTOR_KEY_IPV4_ADDRS,
+							      target_container);
+
+			memcpy(&key_addrs->v4addrs.src, &iph->saddr,
+			       sizeof(key_addrs->v4addrs.src));
+			memcpy(&key_addrs->v4addrs.dst, &iph->daddr,
+			       sizeof(key_addrs->v4addrs.dst));
+			key_control->addr_type = FLOW_DISSECTOR_KEY_IPV4_ADDRS;
+		}
+		break;
+	}
+	case htons(ETH_P_IPV6): {
+		const struct ipv6hdr *iph;
+		struct ipv6hdr _iph;
+		__be32 flow_label;
+
+		iph = __skb_header_pointer(skb, nhoff, sizeof(_iph), data, hlen, &_iph);
+		if (!iph)
+			return false;
+
+		ip_proto = iph->nexthdr;
+		if (ip_proto != IPPROTO_TCP && ip_proto != IPPROTO_UDP)
+			return false;
+
+		flow_label = ip6_flowlabel(iph);
+		if (flow_label && (flags & FLOW_DISSECTOR_F_STOP_AT_FLOW_LABEL))
+			return false;
+
+		nhoff += sizeof(struct ipv6hdr);
+
+		if (dissector_uses_key(flow_dissector,
+				       FLOW_DISSECTOR_KEY_IPV6_ADDRS)) {
+			key_addrs = skb_flow_dissector_target(flow_dissector,
+							      FLOW_DISSECTOR_KEY_IPV6_ADDRS,
+							      target_container);
+
+			memcpy(&key_addrs->v6addrs.src, &iph->saddr,
+			       sizeof(key_addrs->v6addrs.src));
+			memcpy(&key_addrs->v6addrs.dst, &iph->daddr,
+			       sizeof(key_addrs->v6addrs.dst));
+			key_control->addr_type = FLOW_DISSECTOR_KEY_IPV6_ADDRS;
+		}
+
+		if (flow_label && dissector_uses_key(flow_dissector,
+						     FLOW_DISSECTOR_KEY_FLOW_LABEL)) {
+			key_tags = skb_flow_dissector_target(flow_dissector,
+							     FLOW_DISSECTOR_KEY_FLOW_LABEL,
+							     target_container);
+			key_tags->flow_label = ntohl(flow_label);
+		}
+		break;
+	}
+	default:
+		return false;
+	}
+
+	__skb_flow_dissect_ports(skb, flow_dissector, target_container,
+				 data, nhoff, ip_proto, hlen);
+
+	key_control->thoff = min_t(u16, nhoff, skb ? skb->len : hlen);
+	key_basic->n_proto = proto;
+	key_basic->ip_proto = ip_proto;
+
+	return true;
+}
+
 /**
  * __skb_flow_dissect - extract the flow_keys struct and return it
  * @net: associated network namespace, derived from @skb if NULL
@@ -1192,6 +1311,12 @@ bool __skb_flow_dissect(const struct net *net,
 		key_num_of_vlans->num_of_vlans = 0;
 	}
 
+	if (flow_dissector->l4_fast &&
+	    __skb_flow_dissect_l4_fast(skb, flow_dissector, target_container,
+				       data, proto, nhoff, hlen, flags,
+				       key_control, key_basic))
+		return true;
+
 proto_again:
 	fdret = FLOW_DISSECT_RET_CONTINUE;
 
@@ -7,6 +7,15 @@
 
 #define MAX_GRO_SKBS 8
 
+/*
+ * A single bucket may hold more than MAX_GRO_SKBS flows, up to this many, as
+ * long as the node as a whole stays within its GRO_HASH_BUCKETS * MAX_GRO_SKBS
+ * budget.  This keeps an uneven flow hash from evicting flows that could
+ * still be aggregated while other buckets sit empty.
+ */
+#define MAX_GRO_SKBS_BUCKET	32
+#define MAX_GRO_SKBS_NODE	(GRO_HASH_BUCKETS * MAX_GRO_SKBS)
+
 static DEFINE_SPINLOCK(offload_lock);
 
 /**
@@ -297,6 +306,8 @@ static void __gro_flush_chain(struct gro_node *gro, u32 index, bool flush_old)
 		skb_list_del_init(skb);
 		gro_complete(gro, skb);
 		gro->hash[index].count--;
+		gro->held--;
+		gro->flush_poll++;
 	}
 
 	if (!gro->hash[index].count)
@@ -455,6 +466,16 @@ static void gro_flush_oldest(struct gro_node *gro, struct list_head *head)
 	 */
 	skb_list_del_init(oldest);
 	gro_complete(gro, oldest);
+	gro->flush_evict++;
+}
+
+static bool gro_list_full(const struct gro_node *gro,
+			  const struct gro_list *gro_list)
+{
+	if (gro_list->count < MAX_GRO_SKBS)
+		return false;
+	return gro_list->count >= MAX_GRO_SKBS_BUCKET ||
+	       gro->held >= MAX_GRO_SKBS_NODE;
 }
 
 static enum gro_result dev_gro_receive(struct gro_node *gro,
@@ -528,6 +549,8 @@ static enum gro_result dev_gro_receive(struct gro_node *gro,
 		skb_list_del_init(pp);
 		gro_complete(gro, pp);
 		gro_list->count--;
+		gro->held--;
+		gro->flush_proto++;
 	}
 
 	if (same_flow)
@@ -536,10 +559,12 @@ static enum gro_result dev_gro_receive(struct gro_node *gro,
 	if (NAPI_GRO_CB(skb)->flush)
 		goto normal;
 
-	if (unlikely(gro_list->count >= MAX_GRO_SKBS))
+	if (unlikely(gro_list_full(gro, gro_list))) {
 		gro_flush_oldest(gro, &gro_list->list);
-	else
+	} else {
 		gro_list->count++;
+		gro->held++;
+	}
 
 	/* Must be called before setting NAPI_GRO_CB(skb)->{age|last} */
 	gro_try_pull_from_frag0(skb);
@@ -801,6 +826,10 @@ void gro_init(struct gro_node *gro)
 
 	gro->bitmask = 0;
 	gro->cached_napi_id = 0;
+	gro->held = 0;
+	gro->flush_evict = 0;
+	gro->flush_proto = 0;
+	gro->flush_poll = 0;
 
 	INIT_LIST_HEAD(&gro->rx_list);
 	gro->rx_count = 0;
@@ -819,6 +848,7 @@ void gro_cleanup(struct gro_node *gro)
 
 	gro->bitmask = 0;
 	gro->cached_napi_id = 0;
+	gro->held = 0;
 
 	list_for_each_entry_safe(skb, n, &gro->rx_list, list)
 		kfree_skb(skb);
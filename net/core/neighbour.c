@@ -49,6 +49,9 @@ do {						\
 
 #define PNEIGH_HASHMASK		0xF
 
+/* Upper bound on a single periodic GC batch, see neigh_periodic_work() */
+#define NEIGH_GC_BATCH_NS	(2 * NSEC_PER_MSEC)
+
 static void neigh_timer_handler(struct timer_list *t);
 static void __neigh_notify(struct neighbour *n, int type, int flags,
 			   u32 pid);
@@ -286,6 +289,21 @@ static int neigh_forced_gc(struct neigh_table *tbl)
 	return shrunk;
 }
 
+/* Trim the table back towards gc_thresh2 in time-bounded batches, dropping
+ * tbl->lock between them so that lookups and updates are not held off.
+ */
+static void neigh_forced_gc_work(struct work_struct *work)
+{
+	struct neigh_table *tbl = container_of(work, struct neigh_table,
+					       forced_gc_work);
+
+	while (atomic_read(&tbl->gc_entries) > READ_ONCE(tbl->gc_thresh2)) {
+		if (!neigh_forced_gc(tbl))
+			break;
+		cond_resched();
+	}
+}
+
 static void neigh_add_timer(struct neighbour *n, unsigned long when)
 {
 	/* Use safe distance from the jiffies - LONG_MAX point while timer
@@ -458,15 +476,17 @@ static struct neighbour *neigh_alloc(struct neigh_table *tbl,
 
 	entries = atomic_inc_return(&tbl->gc_entries) - 1;
 	gc_thresh3 = READ_ONCE(tbl->gc_thresh3);
-	if (entries >= gc_thresh3 ||
-	    (entries >= READ_ONCE(tbl->gc_thresh2) &&
-	     time_after(now, READ_ONCE(tbl->last_flush) + 5 * HZ))) {
-		if (!neigh_forced_gc(tbl) && entries >= gc_thresh3) {
+	if (entries >= gc_thresh3) {
+		if (!neigh_forced_gc(tbl)) {
 			net_info_ratelimited("%s: neighbor table overflow!\n",
 					     tbl->id);
 			NEIGH_CACHE_STAT_INC(tbl, table_fulls);
 			goto out_entries;
 		}
+	} else if (entries >= READ_ONCE(tbl->gc_thresh2) &&
+		   time_after(now, READ_ONCE(tbl->last_flush) + 5 * HZ)) {
+		/* Not full yet, leave the trimming to process context */
+		queue_work(system_power_efficient_wq, &tbl->forced_gc_work);
 	}
 
 do_alloc:
@@ -902,6 +922,8 @@ static void neigh_connect(struct neighbour *neigh)
 static void neigh_periodic_work(struct work_struct *work)
 {
 	struct neigh_table *tbl = container_of(work, struct neigh_table, gc_work.work);
+	unsigned long delay = NEIGH_VAR(&tbl->parms, BASE_REACHABLE_TIME) >> 1;
+	u64 tmax = ktime_get_ns() + NEIGH_GC_BATCH_NS;
 	struct neigh_hash_table *nht;
 	struct hlist_node *tmp;
 	struct neighbour *n;
@@ -926,10 +948,13 @@ static void neigh_periodic_work(struct work_struct *work)
 				neigh_rand_reach_time(NEIGH_VAR(p, BASE_REACHABLE_TIME));
 	}
 
-	if (atomic_read(&tbl->entries) < READ_ONCE(tbl->gc_thresh1))
+	if (atomic_read(&tbl->entries) < READ_ONCE(tbl->gc_thresh1)) {
+		tbl->gc_bucket = 0;
 		goto out;
+	}
 
-	for (i = 0 ; i < (1 << nht->hash_shift); i++) {
+	/* Resume where the previous batch stopped, see below */
+	for (i = tbl->gc_bucket; i < (1 << nht->hash_shift); i++) {
 		neigh_for_each_in_bucket_safe(n, tmp, &nht->hash_heads[i]) {
 			unsigned int state;
 
@@ -959,6 +984,16 @@ static void neigh_periodic_work(struct work_struct *work)
 			}
 			write_unlock(&n->lock);
 		}
+
+		/* Large tables are walked in time-bounded batches, the next
+		 * one comes right after instead of a full walk in one go.
+		 */
+		if (i + 1 < (1 << nht->hash_shift) &&
+		    ktime_get_ns() > tmax) {
+			tbl->gc_bucket = i + 1;
+			delay = 1;
+			goto out;
+		}
 		/*
 		 * It's fine to release lock here, even if hash table
 		 * grows while we are preempted.
@@ -969,13 +1004,13 @@ static void neigh_periodic_work(struct work_struct *work)
 		nht = rcu_dereference_protected(tbl->nht,
 						lockdep_is_held(&tbl->lock));
 	}
+	tbl->gc_bucket = 0;
 out:
 	/* Cycle through all hash buckets every BASE_REACHABLE_TIME/2 ticks.
 	 * ARP entry timeouts range from 1/2 BASE_REACHABLE_TIME to 3/2
 	 * BASE_REACHABLE_TIME.
 	 */
-	queue_delayed_work(system_power_efficient_wq, &tbl->gc_work,
-			      NEIGH_VAR(&tbl->parms, BASE_REACHABLE_TIME) >> 1);
+	queue_delayed_work(system_power_efficient_wq, &tbl->gc_work, delay);
 	write_unlock_bh(&tbl->lock);
 }
 
@@ -1758,6 +1793,7 @@ void neigh_table_init(int index, struct neigh_table *tbl)
 	rwlock_init(&tbl->lock);
 
 	INIT_DEFERRABLE_WORK(&tbl->gc_work, neigh_periodic_work);
+	INIT_WORK(&tbl->forced_gc_work, neigh_forced_gc_work);
 	queue_delayed_work(system_power_efficient_wq, &tbl->gc_work,
 			tbl->parms.reachable_time);
 	INIT_DEFERRABLE_WORK(&tbl->managed_work, neigh_managed_work);
@@ -1786,6 +1822,7 @@ int neigh_table_clear(int index, struct neigh_table *tbl)
 	/* It is not clean... Fix it to unload IPv6 module safely */
 	cancel_delayed_work_sync(&tbl->managed_work);
 	cancel_delayed_work_sync(&tbl->gc_work);
+	cancel_work_sync(&tbl->forced_gc_work);
 	timer_delete_sync(&tbl->proxy_timer);
 	pneigh_queue_purge(&tbl->proxy_queue, NULL, tbl->family);
 	neigh_ifdown(tbl, NULL);
@@ -144,14 +144,16 @@ static int softnet_seq_show(struct seq_file *seq, void *v)
 	 */
 	seq_printf(seq,
 		   "%08x %08x %08x %08x %08x %08x %08x %08x %08x %08x %08x %08x %08x "
-		   "%08x %08x\n",
+		   "%08x %08x %08x %08x\n",
 		   READ_ONCE(sd->processed), atomic_read(&sd->dropped),
 		   READ_ONCE(sd->time_squeeze), 0,
 		   0, 0, 0, 0, /* was fastroute */
 		   0,	/* was cpu_collision */
 		   READ_ONCE(sd->received_rps), flow_limit_count,
 		   input_qlen + process_qlen, (int)seq->index,
-		   input_qlen, process_qlen);
+		   input_qlen, process_qlen,
+		   READ_ONCE(sd->rps_steered),
+		   READ_ONCE(sd->rps_steered_remote_node));
 	return 0;
 }
 
@@ -205,6 +205,14 @@ netdev_nl_napi_fill_one(struct sk_buff *rsp, struct napi_struct *napi,
 			 gro_flush_timeout))
 		goto nla_put_failure;
 
+	if (nla_put_uint(rsp, NETDEV_A_NAPI_GRO_FLUSH_EVICT,
+			 READ_ONCE(napi->gro.flush_evict)) ||
+	    nla_put_uint(rsp, NETDEV_A_NAPI_GRO_FLUSH_PROTO,
+			 READ_ONCE(napi->gro.flush_proto)) ||
+	    nla_put_uint(rsp, NETDEV_A_NAPI_GRO_FLUSH_POLL,
+			 READ_ONCE(napi->gro.flush_poll)))
+		goto nla_put_failure;
+
 	genlmsg_end(rsp, hdr);
 
 	return 0;
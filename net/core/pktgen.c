@@ -152,6 +152,7 @@
 #include <linux/kthread.h>
 #include <linux/prefetch.h>
 #include <linux/mmzone.h>
+#include <linux/u64_stats_sync.h>
 #include <net/net_namespace.h>
 #include <net/checksum.h>
 #include <net/ipv6.h>
@@ -238,6 +239,7 @@ static char *pkt_flag_names[] = {
 #define PKTGEN_MAGIC 0xbe9be955
 #define PG_PROC_DIR "pktgen"
 #define PGCTRL	    "pgctrl"
+#define PGRX	    "pgrx"
 
 #define MAX_CFLOWS  65536
 
@@ -446,11 +448,32 @@ struct pktgen_hdr {
 
 static unsigned int pg_net_id __read_mostly;
 
+/* Receive side sink: latency is bucketed in log2 microseconds,
+ * bucket 0 holds sub-microsecond samples.
+ */
+#define PKTGEN_RX_HIST_BUCKETS	24
+
+struct pktgen_rx_stats {
+	u64_stats_t		packets;
+	u64_stats_t		lost;
+	u64_stats_t		reordered;
+	u64_stats_t		hist[PKTGEN_RX_HIST_BUCKETS];
+	u64			lat_max;
+	u32			next_seq;
+	bool			seq_valid;
+	struct u64_stats_sync	syncp;
+};
+
 struct pktgen_net {
 	struct net		*net;
 	struct proc_dir_entry	*proc_dir;
 	struct list_head	pktgen_threads;
 	bool			pktgen_exiting;
+
+	/* Receive sink, protected by RTNL */
+	struct packet_type	rx_pt;
+	netdevice_tracker	rx_dev_tracker;
+	struct pktgen_rx_stats __percpu *rx_stats;
 };
 
 struct pktgen_thread {
@@ -503,6 +526,243 @@ static struct notifier_block pktgen_notifier_block = {
 	.notifier_call = pktgen_device_event,
 };
 
+/*
+ * Receive side sink
+ *
+ * Packets carrying a pktgen header are accounted on the receiving CPU:
+ * one-way latency from the embedded timestamp (this needs the sender
+ * and receiver clocks to be synchronised) and loss/reorder from the
+ * sequence number.
+ *
+ * Sequence tracking is per CPU, not per flow: the lost and reordered
+ * counts are only meaningful for a single pktgen device whose packets all
+ * land on one RX CPU.  If RSS/RPS spreads the stream over several CPUs, or
+ * several senders feed the same CPU, each CPU sees gaps and going back in
+ * the sequence and reports loss and reordering that didn't happen.
+ */
+
+static void pktgen_rx_account(struct pktgen_rx_stats *st,
+			      const struct pktgen_hdr *pgh)
+{
+	u32 seq = ntohl(pgh->seq_num);
+	struct timespec64 now;
+	s64 lat = -1;
+	s32 delta;
+
+	if (pgh->tv_sec || pgh->tv_usec) {
+		ktime_get_real_ts64(&now);
+		/* tv_sec is truncated to 32 bits on the wire */
+		delta = (s32)((u32)now.tv_sec - ntohl(pgh->tv_sec));
+		lat = (s64)delta * USEC_PER_SEC +
+		      now.tv_nsec / NSEC_PER_USEC - ntohl(pgh->tv_usec);
+		/* clamp clock skew between sender and receiver */
+		if (lat < 0)
+			lat = 0;
+	}
+
+	u64_stats_update_begin(&st->syncp);
+	u64_stats_inc(&st->packets);
+	if (lat >= 0) {
+		u64_stats_inc(&st->hist[min(fls64(lat),
+					    PKTGEN_RX_HIST_BUCKETS - 1)]);
+		if (lat > st->lat_max)
+			st->lat_max = lat;
+	}
+	if (!st->seq_valid) {
+		st->seq_valid = true;
+		st->next_seq = seq + 1;
+	} else {
+		delta = (s32)(seq - st->next_seq);
+		if (delta >= 0) {
+			u64_stats_add(&st->lost, delta);
+			st->next_seq = seq + 1;
+		} else {
+			u64_stats_inc(&st->reordered);
+		}
+	}
+	u64_stats_update_end(&st->syncp);
+}
+
+static int pktgen_rx_rcv(struct sk_buff *skb, struct net_device *dev,
+			 struct packet_type *pt, struct net_device *orig_dev)
+{
+	struct pktgen_net *pn = container_of(pt, struct pktgen_net, rx_pt);
+	struct pktgen_hdr _pgh;
+	const struct pktgen_hdr *pgh;
+	unsigned int off;
+
+	/* ETH_P_ALL also sees our own transmits on this device */
+	if (skb->pkt_type == PACKET_OUTGOING)
+		goto out;
+
+	/* We may see a shared skb here, only ever read through copies */
+	switch (skb->protocol) {
+	case htons(ETH_P_IP): {
+		const struct iphdr *iph;
+		struct iphdr _iph;
+
+		iph = skb_header_pointer(skb, 0, sizeof(_iph), &_iph);
+		if (!iph || iph->ihl < 5 || iph->protocol != IPPROTO_UDP ||
+		    ip_is_fragment(iph))
+			goto out;
+		off = iph->ihl * 4;
+		break;
+	}
+	case htons(ETH_P_IPV6): {
+		const struct ipv6hdr *ip6h;
+		struct ipv6hdr _ip6h;
+
+		ip6h = skb_header_pointer(skb, 0, sizeof(_ip6h), &_ip6h);
+		if (!ip6h || ip6h->nexthdr != IPPROTO_UDP)
+			goto out;
+		off = sizeof(*ip6h);
+		break;
+	}
+	default:
+		goto out;
+	}
+
+	pgh = skb_header_pointer(skb, off + sizeof(struct udphdr),
+				 sizeof(_pgh), &_pgh);
+	if (pgh && pgh->pgh_magic == htonl(PKTGEN_MAGIC))
+		pktgen_rx_account(this_cpu_ptr(pn->rx_stats), pgh);
+out:
+	consume_skb(skb);
+	return NET_RX_SUCCESS;
+}
+
+static void pktgen_rx_stop(struct pktgen_net *pn)
+{
+	ASSERT_RTNL();
+
+	if (!pn->rx_stats)
+		return;
+
+	dev_remove_pack(&pn->rx_pt);
+	netdev_put(pn->rx_pt.dev, &pn->rx_dev_tracker);
+	pn->rx_pt.dev = NULL;
+	free_percpu(pn->rx_stats);
+	pn->rx_stats = NULL;
+}
+
+static void pktgen_rx_clear(struct pktgen_net *pn)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct pktgen_rx_stats *st = per_cpu_ptr(pn->rx_stats, cpu);
+
+		memset(st, 0, sizeof(*st));
+		u64_stats_init(&st->syncp);
+	}
+}
+
+static int pktgen_rx_start(struct pktgen_net *pn, const char *ifname)
+{
+	struct net_device *dev;
+
+	ASSERT_RTNL();
+
+	if (pn->rx_stats)
+		return -EBUSY;
+
+	dev = netdev_get_by_name(pn->net, ifname, &pn->rx_dev_tracker,
+				 GFP_KERNEL);
+	if (!dev)
+		return -ENODEV;
+
+	pn->rx_stats = alloc_percpu(struct pktgen_rx_stats);
+	if (!pn->rx_stats) {
+		netdev_put(dev, &pn->rx_dev_tracker);
+		return -ENOMEM;
+	}
+	pktgen_rx_clear(pn);
+
+	pn->rx_pt.type = htons(ETH_P_ALL);
+	pn->rx_pt.dev = dev;
+	pn->rx_pt.func = pktgen_rx_rcv;
+	dev_add_pack(&pn->rx_pt);
+	return 0;
+}
+
+static int pktgen_rx_reset(struct pktgen_net *pn)
+{
+	ASSERT_RTNL();
+
+	if (!pn->rx_stats)
+		return -ENODEV;
+
+	/* dev_remove_pack() waits for in-flight receivers */
+	dev_remove_pack(&pn->rx_pt);
+	pktgen_rx_clear(pn);
+	dev_add_pack(&pn->rx_pt);
+	return 0;
+}
+
+static int pgrx_show(struct seq_file *seq, void *v)
+{
+	struct pktgen_net *pn = seq->private;
+	u64 packets = 0, lost = 0, reordered = 0, lat_max = 0;
+	u64 hist[PKTGEN_RX_HIST_BUCKETS] = {};
+	int cpu, i;
+
+	rtnl_lock();
+	if (!pn->rx_stats) {
+		rtnl_unlock();
+		seq_puts(seq, "Receive sink: off\n");
+		return 0;
+	}
+
+	for_each_possible_cpu(cpu) {
+		const struct pktgen_rx_stats *st = per_cpu_ptr(pn->rx_stats,
+							       cpu);
+		u64 p, l, r, h[PKTGEN_RX_HIST_BUCKETS];
+		unsigned int start;
+
+		do {
+			start = u64_stats_fetch_begin(&st->syncp);
+			p = u64_stats_read(&st->packets);
+			l = u64_stats_read(&st->lost);
+			r = u64_stats_read(&st->reordered);
+			for (i = 0; i < PKTGEN_RX_HIST_BUCKETS; i++)
+				h[i] = u64_stats_read(&st->hist[i]);
+		} while (u64_stats_fetch_retry(&st->syncp, start));
+
+		packets += p;
+		lost += l;
+		reordered += r;
+		for (i = 0; i < PKTGEN_RX_HIST_BUCKETS; i++)
+			hist[i] += h[i];
+		lat_max = max(lat_max, READ_ONCE(st->lat_max));
+	}
+
+	seq_printf(seq, "Receive sink: %s\n", pn->rx_pt.dev->name);
+	rtnl_unlock();
+
+	seq_printf(seq, "     packets: %llu  lost: %llu  reordered: %llu\n",
+		   packets, lost, reordered);
+	seq_printf(seq, "     latency_max: %lluus\n", lat_max);
+	for (i = 0; i < PKTGEN_RX_HIST_BUCKETS; i++) {
+		if (!hist[i])
+			continue;
+		seq_printf(seq, "     latency < %lluus: %llu\n",
+			   1ULL << i, hist[i]);
+	}
+	return 0;
+}
+
+static int pgrx_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, pgrx_show, pde_data(inode));
+}
+
+static const struct proc_ops pktgen_rx_proc_ops = {
+	.proc_open	= pgrx_open,
+	.proc_read	= seq_read,
+	.proc_lseek	= seq_lseek,
+	.proc_release	= single_release,
+};
+
 /*
  * /proc handling functions
  *
@@ -542,7 +802,27 @@ static ssize_t pgctrl_write(struct file *file, const char __user *buf,
 		pktgen_run_all_threads(pn);
 	else if (!strcmp(data, "reset"))
 		pktgen_reset_all_threads(pn);
-	else
+	else if (!strncmp(data, "rx ", 3)) {
+		int ret;
+
+		rtnl_lock();
+		ret = pktgen_rx_start(pn, strim(data + 3));
+		rtnl_unlock();
+		if (ret)
+			return ret;
+	} else if (!strcmp(data, "rx_reset")) {
+		int ret;
+
+		rtnl_lock();
+		ret = pktgen_rx_reset(pn);
+		rtnl_unlock();
+		if (ret)
+			return ret;
+	} else if (!strcmp(data, "rx_stop")) {
+		rtnl_lock();
+		pktgen_rx_stop(pn);
+		rtnl_unlock();
+	} else
 		return -EINVAL;
 
 	return count;
@@ -2112,6 +2392,9 @@ static int pktgen_device_event(struct notifier_block *unused,
 	struct net_device *dev = netdev_notifier_info_to_dev(ptr);
 	struct pktgen_net *pn = net_generic(dev_net(dev), pg_net_id);
 
+	if (event == NETDEV_UNREGISTER && pn->rx_pt.dev == dev)
+		pktgen_rx_stop(pn);
+
 	if (pn->pktgen_exiting)
 		return NOTIFY_DONE;
 
@@ -4036,6 +4319,13 @@ static int __net_init pg_net_init(struct net *net)
 		ret = -EINVAL;
 		goto remove;
 	}
+	pe = proc_create_data(PGRX, 0444, pn->proc_dir, &pktgen_rx_proc_ops,
+			      pn);
+	if (!pe) {
+		pr_err("cannot create %s procfs entry\n", PGRX);
+		ret = -EINVAL;
+		goto remove_pgctrl;
+	}
 
 	cpus_read_lock();
 	for_each_online_cpu(cpu) {
@@ -4057,6 +4347,8 @@ static int __net_init pg_net_init(struct net *net)
 	return 0;
 
 remove_entry:
+	remove_proc_entry(PGRX, pn->proc_dir);
+remove_pgctrl:
 	remove_proc_entry(PGCTRL, pn->proc_dir);
 remove:
 	remove_proc_entry(PG_PROC_DIR, pn->net->proc_net);
@@ -4073,6 +4365,10 @@ static void __net_exit pg_net_exit(struct net *net)
 	/* Stop all interfaces & threads */
 	pn->pktgen_exiting = true;
 
+	rtnl_lock();
+	pktgen_rx_stop(pn);
+	rtnl_unlock();
+
 	mutex_lock(&pktgen_thread_lock);
 	list_splice_init(&pn->pktgen_threads, &list);
 	mutex_unlock(&pktgen_thread_lock);
@@ -4084,6 +4380,7 @@ static void __net_exit pg_net_exit(struct net *net)
 		kfree(t);
 	}
 
+	remove_proc_entry(PGRX, pn->proc_dir);
 	remove_proc_entry(PGCTRL, pn->proc_dir);
 	remove_proc_entry(PG_PROC_DIR, pn->net->proc_net);
 }
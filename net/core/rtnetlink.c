@@ -4329,6 +4329,10 @@ static noinline_for_stack u32 rtnl_calcit(struct sk_buff *skb,
 	return nlmsg_total_size(min_ifinfo_dump_size);
 }
 
+/* rtnl_dump_all() itself runs without RTNL; it is only taken around the
+ * per-family handlers that have not been converted to RCU, so that e.g.
+ * an AF_UNSPEC address dump does not serialise on RTNL for IPv6.
+ */
 static int rtnl_dump_all(struct sk_buff *skb, struct netlink_callback *cb)
 {
 	int idx;
@@ -4343,6 +4347,8 @@ static int rtnl_dump_all(struct sk_buff *skb, struct netlink_callback *cb)
 		struct rtnl_link __rcu **tab;
 		struct rtnl_link *link;
 		rtnl_dumpit_func dumpit;
+		struct module *owner;
+		bool needs_lock;
 
 		if (idx < s_idx || idx == PF_PACKET)
 			continue;
@@ -4350,26 +4356,41 @@ static int rtnl_dump_all(struct sk_buff *skb, struct netlink_callback *cb)
 		if (type < 0 || type >= RTM_NR_MSGTYPES)
 			continue;
 
-		tab = rcu_dereference_rtnl(rtnl_msg_handlers[idx]);
+		rcu_read_lock();
+		tab = rcu_dereference(rtnl_msg_handlers[idx]);
 		if (!tab)
-			continue;
+			goto next;
 
-		link = rcu_dereference_rtnl(tab[type]);
+		link = rcu_dereference(tab[type]);
 		if (!link)
-			continue;
+			goto next;
 
 		dumpit = link->dumpit;
 		if (!dumpit)
-			continue;
+			goto next;
+
+		owner = link->owner;
+		if (!try_module_get(owner))
+			goto next;
+		needs_lock = !(link->flags & RTNL_FLAG_DUMP_UNLOCKED);
+		rcu_read_unlock();
 
 		if (idx > s_idx) {
 			memset(&cb->args[0], 0, sizeof(cb->args));
 			cb->prev_seq = 0;
 			cb->seq = 0;
 		}
+		if (needs_lock)
+			rtnl_lock();
 		ret = dumpit(skb, cb);
+		if (needs_lock)
+			rtnl_unlock();
+		module_put(owner);
 		if (ret)
 			break;
+		continue;
+next:
+		rcu_read_unlock();
 	}
 	cb->family = idx;
 
@@ -7052,9 +7073,12 @@ static const struct rtnl_msg_handler rtnetlink_rtnl_msg_handlers[] __initconst =
 	 .dumpit = rtnl_dump_ifinfo, .flags = RTNL_FLAG_DUMP_SPLIT_NLM_DONE},
 	{.msgtype = RTM_SETLINK, .doit = rtnl_setlink,
 	 .flags = RTNL_FLAG_DOIT_PERNET_WIP},
-	{.msgtype = RTM_GETADDR, .dumpit = rtnl_dump_all},
-	{.msgtype = RTM_GETROUTE, .dumpit = rtnl_dump_all},
-	{.msgtype = RTM_GETNETCONF, .dumpit = rtnl_dump_all},
+	{.msgtype = RTM_GETADDR, .dumpit = rtnl_dump_all,
+	 .flags = RTNL_FLAG_DUMP_UNLOCKED},
+	{.msgtype = RTM_GETROUTE, .dumpit = rtnl_dump_all,
+	 .flags = RTNL_FLAG_DUMP_UNLOCKED},
+	{.msgtype = RTM_GETNETCONF, .dumpit = rtnl_dump_all,
+	 .flags = RTNL_FLAG_DUMP_UNLOCKED},
 	{.msgtype = RTM_GETSTATS, .doit = rtnl_stats_get,
 	 .dumpit = rtnl_stats_dump},
 	{.msgtype = RTM_SETSTATS, .doit = rtnl_stats_set},
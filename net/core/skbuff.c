@@ -4739,6 +4739,13 @@ struct sk_buff *skb_segment(struct sk_buff *head_skb,
 	sg = !!(features & NETIF_F_SG);
 	csum = !!can_checksum_protocol(features, proto);
 
+	/* Segments referencing shared frags would have to be linearized
+	 * and then checksummed in a second pass.  Copy them instead, which
+	 * checksums the payload while copying it.
+	 */
+	if (sg && !csum && skb_has_shared_frag(head_skb))
+		sg = false;
+
 	if (sg && csum && (mss != GSO_BY_FRAGS))  {
 		if (!(features & NETIF_F_GSO_PARTIAL)) {
 			struct sk_buff *iter;
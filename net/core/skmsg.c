@@ -923,6 +923,60 @@ int sk_psock_msg_verdict(struct sock *sk, struct sk_psock *psock,
 }
 EXPORT_SYMBOL_GPL(sk_psock_msg_verdict);
 
+/* Try to deliver an ingress redirect straight from the verdict context
+ * instead of bouncing it through the target's backlog work. Only done
+ * when the target's lock is free, it is not owned by user context and it
+ * has nothing queued, so ordering through the backlog is preserved. On
+ * failure the caller queues the skb to the backlog as before.
+ */
+static int sk_psock_skb_ingress_inline(struct sk_psock *psock,
+				       struct sk_buff *skb)
+{
+	struct sock *sk = psock->sk;
+	u32 off = 0, len = skb->len;
+	struct sk_msg *msg;
+	int err = -EAGAIN;
+
+	if (skb_bpf_strparser(skb)) {
+		struct strp_msg *stm = strp_msg(skb);
+
+		off = stm->offset;
+		len = stm->full_len;
+	}
+
+	/* The verdict may run under the source socket's lock, only trylock
+	 * the target to avoid lock inversion between redirecting peers.
+	 */
+	local_bh_disable();
+	if (!spin_trylock(&sk->sk_lock.slock)) {
+		local_bh_enable();
+		return -EAGAIN;
+	}
+	if (sock_owned_by_user(sk))
+		goto unlock;
+
+	if (atomic_read(&sk->sk_rmem_alloc) > sk->sk_rcvbuf ||
+	    !sk_rmem_schedule(sk, skb, skb->truesize))
+		goto unlock;
+
+	msg = alloc_sk_msg(GFP_ATOMIC);
+	if (unlikely(!msg))
+		goto unlock;
+
+	/* Once owned by @sk a later backlog retry takes the ingress_self
+	 * path, which skips the accounting done here.
+	 */
+	skb_set_owner_r(skb, sk);
+	err = sk_psock_skb_ingress_enqueue(skb, off, len, psock, sk, msg,
+					   false);
+	if (err < 0)
+		kfree(msg);
+unlock:
+	bh_unlock_sock(sk);
+	local_bh_enable();
+	return err;
+}
+
 static int sk_psock_skb_redirect(struct sk_psock *from, struct sk_buff *skb)
 {
 	struct sk_psock *psock_other;
@@ -955,6 +1009,24 @@ static int sk_psock_skb_redirect(struct sk_psock *from, struct sk_buff *skb)
 		return -EIO;
 	}
 
+	if (skb_bpf_ingress(skb) && skb_queue_empty(&psock_other->ingress_skb)) {
+		spin_unlock_bh(&psock_other->ingress_lock);
+
+		skb_bpf_redirect_clear(skb);
+		if (sk_psock_skb_ingress_inline(psock_other, skb) >= 0)
+			return 0;
+		/* Restore redir info for the backlog */
+		skb_bpf_set_redir(skb, sk_other, true);
+
+		spin_lock_bh(&psock_other->ingress_lock);
+		if (!sk_psock_test_state(psock_other, SK_PSOCK_TX_ENABLED)) {
+			spin_unlock_bh(&psock_other->ingress_lock);
+			skb_bpf_redirect_clear(skb);
+			sock_drop(from->sk, skb);
+			return -EIO;
+		}
+	}
+
 	skb_queue_tail(&psock_other->ingress_skb, skb);
 	schedule_delayed_work(&psock_other->work, 0);
 	spin_unlock_bh(&psock_other->ingress_lock);
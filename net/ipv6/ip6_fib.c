@@ -25,6 +25,7 @@
 #include <linux/init.h>
 #include <linux/list.h>
 #include <linux/slab.h>
+#include <linux/prefetch.h>
 
 #include <net/ip.h>
 #include <net/ipv6.h>
@@ -1627,6 +1628,18 @@ static struct fib6_node *fib6_node_lookup_1(struct fib6_node *root,
 	for (;;) {
 		struct fib6_node *next;
 
+		/* The backtracking loop below compares the key of every route
+		 * carrying node on this path; start fetching those keys now so
+		 * the misses overlap with the descent instead of serialising
+		 * after it.
+		 */
+		if (fn->fn_flags & RTN_RTINFO || FIB6_SUBTREE(fn)) {
+			struct fib6_info *leaf = rcu_dereference(fn->leaf);
+
+			if (leaf)
+				prefetch((u8 *)leaf + args->offset);
+		}
+
 		dir = addr_bit_set(args->addr, fn->fn_bit);
 
 		next = dir ? rcu_dereference(fn->right) :
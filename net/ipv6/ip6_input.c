@@ -79,10 +79,22 @@ int ip6_rcv_finish(struct net *net, struct sock *sk, struct sk_buff *skb)
 	return dst_input(skb);
 }
 
+static void ip6_list_input(struct list_head *head, struct net_device *dev);
+
+/* All skbs on @head share the same dst and device */
 static void ip6_sublist_rcv_finish(struct list_head *head)
 {
 	struct sk_buff *skb, *next;
 
+	if (list_empty(head))
+		return;
+
+	skb = list_first_entry(head, struct sk_buff, list);
+	if (skb_dst(skb)->input == ip6_input) {
+		ip6_list_input(head, skb->dev);
+		return;
+	}
+
 	list_for_each_entry_safe(skb, next, head, list) {
 		skb_list_del_init(skb);
 		dst_input(skb);
@@ -111,6 +123,7 @@ static void ip6_list_rcv_finish(struct net *net, struct sock *sk,
 {
 	struct sk_buff *skb, *next, *hint = NULL;
 	struct dst_entry *curr_dst = NULL;
+	struct net_device *curr_dev = NULL;
 	LIST_HEAD(sublist);
 
 	list_for_each_entry_safe(skb, next, head, list) {
@@ -129,8 +142,9 @@ static void ip6_list_rcv_finish(struct net *net, struct sock *sk,
 		else
 			ip6_rcv_finish_core(net, sk, skb);
 		dst = skb_dst(skb);
-		if (curr_dst != dst) {
-			hint = ip6_extract_route_hint(net, skb);
+		if (curr_dst != dst || curr_dev != skb->dev) {
+			if (curr_dst != dst)
+				hint = ip6_extract_route_hint(net, skb);
 
 			/* dispatch old sublist */
 			if (!list_empty(&sublist))
@@ -138,6 +152,7 @@ static void ip6_list_rcv_finish(struct net *net, struct sock *sk,
 			/* start new sublist */
 			INIT_LIST_HEAD(&sublist);
 			curr_dst = dst;
+			curr_dev = skb->dev;
 		}
 		list_add_tail(&skb->list, &sublist);
 	}
@@ -497,6 +512,25 @@ int ip6_input(struct sk_buff *skb)
 }
 EXPORT_SYMBOL_GPL(ip6_input);
 
+/* List variant of ip6_input(): one LOCAL_IN hook traversal and one RCU
+ * section for a run of packets that share their dst and device.
+ */
+static void ip6_list_input(struct list_head *head, struct net_device *dev)
+{
+	struct sk_buff *skb, *next;
+	struct net *net;
+
+	rcu_read_lock();
+	net = dev_net_rcu(dev);
+	NF_HOOK_LIST(NFPROTO_IPV6, NF_INET_LOCAL_IN, net, NULL,
+		     head, dev, NULL, ip6_input_finish);
+	list_for_each_entry_safe(skb, next, head, list) {
+		skb_list_del_init(skb);
+		ip6_input_finish(net, NULL, skb);
+	}
+	rcu_read_unlock();
+}
+
 int ip6_mc_input(struct sk_buff *skb)
 {
 	int sdif = inet6_sdif(skb);
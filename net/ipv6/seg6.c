@@ -254,6 +254,9 @@ static int seg6_genl_set_tunsrc(struct sk_buff *skb, struct genl_info *info)
 
 	mutex_unlock(&sdata->lock);
 
+	/* seg6 tunnels cache the selected source address with their dst */
+	rt_genid_bump_ipv6(net);
+
 	synchronize_net();
 	kfree(t_old);
 
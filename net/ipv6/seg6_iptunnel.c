@@ -86,8 +86,13 @@ static int nla_put_srh(struct sk_buff *skb, int attrtype,
 	return 0;
 }
 
+/* @cache_saddr is the source address stored in the tunnel's dst_cache
+ * together with the cached route, if any.  It is reused instead of
+ * running source address selection for every packet.
+ */
 static void set_tun_src(struct net *net, struct net_device *dev,
-			struct in6_addr *daddr, struct in6_addr *saddr)
+			struct in6_addr *daddr, struct in6_addr *saddr,
+			const struct in6_addr *cache_saddr)
 {
 	struct seg6_pernet_data *sdata = seg6_pernet(net);
 	struct in6_addr *tun_src;
@@ -98,6 +103,8 @@ static void set_tun_src(struct net *net, struct net_device *dev,
 
 	if (!ipv6_addr_any(tun_src)) {
 		memcpy(saddr, tun_src, sizeof(struct in6_addr));
+	} else if (cache_saddr) {
+		*saddr = *cache_saddr;
 	} else {
 		ipv6_dev_get_saddr(net, dev, daddr, IPV6_PREFER_SRC_PUBLIC,
 				   saddr);
@@ -125,7 +132,8 @@ static __be32 seg6_make_flowlabel(struct net *net, struct sk_buff *skb,
 }
 
 static int __seg6_do_srh_encap(struct sk_buff *skb, struct ipv6_sr_hdr *osrh,
-			       int proto, struct dst_entry *cache_dst)
+			       int proto, struct dst_entry *cache_dst,
+			       const struct in6_addr *cache_saddr)
 {
 	struct dst_entry *dst = skb_dst(skb);
 	struct net *net = dev_net(dst->dev);
@@ -181,7 +189,7 @@ static int __seg6_do_srh_encap(struct sk_buff *skb, struct ipv6_sr_hdr *osrh,
 	isrh->nexthdr = proto;
 
 	hdr->daddr = isrh->segments[isrh->first_segment];
-	set_tun_src(net, dst->dev, &hdr->daddr, &hdr->saddr);
+	set_tun_src(net, dst->dev, &hdr->daddr, &hdr->saddr, cache_saddr);
 
 #ifdef CONFIG_IPV6_SEG6_HMAC
 	if (sr_has_hmac(isrh)) {
@@ -201,14 +209,15 @@ static int __seg6_do_srh_encap(struct sk_buff *skb, struct ipv6_sr_hdr *osrh,
 /* encapsulate an IPv6 packet within an outer IPv6 header with a given SRH */
 int seg6_do_srh_encap(struct sk_buff *skb, struct ipv6_sr_hdr *osrh, int proto)
 {
-	return __seg6_do_srh_encap(skb, osrh, proto, NULL);
+	return __seg6_do_srh_encap(skb, osrh, proto, NULL, NULL);
 }
 EXPORT_SYMBOL_GPL(seg6_do_srh_encap);
 
 /* encapsulate an IPv6 packet within an outer IPv6 header with reduced SRH */
 static int seg6_do_srh_encap_red(struct sk_buff *skb,
 				 struct ipv6_sr_hdr *osrh, int proto,
-				 struct dst_entry *cache_dst)
+				 struct dst_entry *cache_dst,
+				 const struct in6_addr *cache_saddr)
 {
 	__u8 first_seg = osrh->first_segment;
 	struct dst_entry *dst = skb_dst(skb);
@@ -270,7 +279,7 @@ static int seg6_do_srh_encap_red(struct sk_buff *skb,
 	if (skip_srh) {
 		hdr->nexthdr = proto;
 
-		set_tun_src(net, dst->dev, &hdr->daddr, &hdr->saddr);
+		set_tun_src(net, dst->dev, &hdr->daddr, &hdr->saddr, cache_saddr);
 		goto out;
 	}
 
@@ -306,7 +315,7 @@ static int seg6_do_srh_encap_red(struct sk_buff *skb,
 
 srcaddr:
 	isrh->nexthdr = proto;
-	set_tun_src(net, dst->dev, &hdr->daddr, &hdr->saddr);
+	set_tun_src(net, dst->dev, &hdr->daddr, &hdr->saddr, cache_saddr);
 
 #ifdef CONFIG_IPV6_SEG6_HMAC
 	if (unlikely(!skip_srh && sr_has_hmac(isrh))) {
@@ -377,7 +386,8 @@ static int __seg6_do_srh_inline(struct sk_buff *skb, struct ipv6_sr_hdr *osrh,
 	return 0;
 }
 
-static int seg6_do_srh(struct sk_buff *skb, struct dst_entry *cache_dst)
+static int seg6_do_srh(struct sk_buff *skb, struct dst_entry *cache_dst,
+		       const struct in6_addr *cache_saddr)
 {
 	struct dst_entry *dst = skb_dst(skb);
 	struct seg6_iptunnel_encap *tinfo;
@@ -409,10 +419,12 @@ static int seg6_do_srh(struct sk_buff *skb, struct dst_entry *cache_dst)
 
 		if (tinfo->mode == SEG6_IPTUN_MODE_ENCAP)
 			err = __seg6_do_srh_encap(skb, tinfo->srh,
-						  proto, cache_dst);
+						  proto, cache_dst,
+						  cache_saddr);
 		else
 			err = seg6_do_srh_encap_red(skb, tinfo->srh,
-						    proto, cache_dst);
+						    proto, cache_dst,
+						    cache_saddr);
 
 		if (err)
 			return err;
@@ -435,11 +447,11 @@ static int seg6_do_srh(struct sk_buff *skb, struct dst_entry *cache_dst)
 		if (tinfo->mode == SEG6_IPTUN_MODE_L2ENCAP)
 			err = __seg6_do_srh_encap(skb, tinfo->srh,
 						  IPPROTO_ETHERNET,
-						  cache_dst);
+						  cache_dst, cache_saddr);
 		else
 			err = seg6_do_srh_encap_red(skb, tinfo->srh,
 						    IPPROTO_ETHERNET,
-						    cache_dst);
+						    cache_dst, cache_saddr);
 
 		if (err)
 			return err;
@@ -473,6 +485,7 @@ static int seg6_input_core(struct net *net, struct sock *sk,
 	struct dst_entry *orig_dst = skb_dst(skb);
 	struct dst_entry *dst = NULL;
 	struct lwtunnel_state *lwtst;
+	struct in6_addr saddr;
 	struct seg6_lwt *slwt;
 	int err;
 
@@ -486,10 +499,10 @@ static int seg6_input_core(struct net *net, struct sock *sk,
 	slwt = seg6_lwt_lwtunnel(lwtst);
 
 	local_bh_disable();
-	dst = dst_cache_get(&slwt->cache);
+	dst = dst_cache_get_ip6(&slwt->cache, &saddr);
 	local_bh_enable();
 
-	err = seg6_do_srh(skb, dst);
+	err = seg6_do_srh(skb, dst, dst ? &saddr : NULL);
 	if (unlikely(err)) {
 		dst_release(dst);
 		goto drop;
@@ -556,16 +569,17 @@ static int seg6_output_core(struct net *net, struct sock *sk,
 {
 	struct dst_entry *orig_dst = skb_dst(skb);
 	struct dst_entry *dst = NULL;
+	struct in6_addr saddr;
 	struct seg6_lwt *slwt;
 	int err;
 
 	slwt = seg6_lwt_lwtunnel(orig_dst->lwtstate);
 
 	local_bh_disable();
-	dst = dst_cache_get(&slwt->cache);
+	dst = dst_cache_get_ip6(&slwt->cache, &saddr);
 	local_bh_enable();
 
-	err = seg6_do_srh(skb, dst);
+	err = seg6_do_srh(skb, dst, dst ? &saddr : NULL);
 	if (unlikely(err))
 		goto drop;
 
@@ -157,6 +157,41 @@ static bool mptcp_ooo_try_coalesce(struct mptcp_sock *msk, struct sk_buff *to,
 	return mptcp_try_coalesce((struct sock *)msk, to, from);
 }
 
+/* Coalesce the out of order range starting right at @skb's end into
+ * @skb. With subflows of very different RTTs, the faster one keeps filling
+ * holes between ranges delivered by the slower one; merging on both sides
+ * keeps the tree, and the per-skb truesize overhead charged to rcvbuf,
+ * small.
+ */
+static void mptcp_ooo_merge_next(struct mptcp_sock *msk, struct sk_buff *skb,
+				 struct sk_buff *next)
+{
+	struct rb_node **p = &msk->out_of_order_queue.rb_node;
+	struct sock *sk = (struct sock *)msk;
+	struct rb_node *parent = NULL;
+	bool last = msk->ooo_last_skb == next;
+
+	rb_erase(&next->rbnode, &msk->out_of_order_queue);
+	if (mptcp_try_coalesce(sk, skb, next)) {
+		MPTCP_INC_STATS(sock_net(sk), MPTCP_MIB_OFOMERGE);
+		if (last)
+			msk->ooo_last_skb = skb;
+		return;
+	}
+
+	/* not mergeable, put it back where it was */
+	while (*p) {
+		parent = *p;
+		if (before64(MPTCP_SKB_CB(next)->map_seq,
+			     MPTCP_SKB_CB(rb_to_skb(parent))->map_seq))
+			p = &parent->rb_left;
+		else
+			p = &parent->rb_right;
+	}
+	rb_link_node(&next->rbnode, parent, p);
+	rb_insert_color(&next->rbnode, &msk->out_of_order_queue);
+}
+
 /* "inspired" by tcp_data_queue_ofo(), main differences:
  * - use mptcp seqs
  * - don't cope with sacks
@@ -166,7 +201,7 @@ static void mptcp_data_queue_ofo(struct mptcp_sock *msk, struct sk_buff *skb)
 	struct sock *sk = (struct sock *)msk;
 	struct rb_node **p, *parent;
 	u64 seq, end_seq, max_seq;
-	struct sk_buff *skb1;
+	struct sk_buff *skb1 = NULL;
 
 	seq = MPTCP_SKB_CB(skb)->map_seq;
 	end_seq = MPTCP_SKB_CB(skb)->end_seq;
@@ -270,6 +305,10 @@ static void mptcp_data_queue_ofo(struct mptcp_sock *msk, struct sk_buff *skb)
 end:
 	skb_condense(skb);
 	skb_set_owner_r(skb, sk);
+
+	/* skb may have filled the hole in front of the next range */
+	if (skb1 && MPTCP_SKB_CB(skb1)->map_seq == MPTCP_SKB_CB(skb)->end_seq)
+		mptcp_ooo_merge_next(msk, skb, skb1);
 }
 
 static bool __mptcp_move_skb(struct mptcp_sock *msk, struct sock *ssk,
@@ -1332,8 +1371,11 @@ bool mptcp_subflow_active(struct mptcp_subflow_context *subflow)
 /* implement the mptcp packet scheduler;
  * returns the subflow that will transmit the next DSS
  * additionally updates the rtx timeout
+ * @owd: also account for half the subflow srtt, so that a slower but
+ * idle path is not preferred over a busier path with a much lower
+ * propagation delay
  */
-struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk)
+static struct sock *__mptcp_subflow_get_send(struct mptcp_sock *msk, bool owd)
 {
 	struct subflow_send_info send_info[SSK_MODE_MAX];
 	struct mptcp_subflow_context *subflow;
@@ -1370,6 +1412,9 @@ struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk)
 		}
 
 		linger_time = div_u64((u64)READ_ONCE(ssk->sk_wmem_queued) << 32, pace);
+		if (owd)
+			linger_time += div_u64((u64)(READ_ONCE(tcp_sk(ssk)->srtt_us) >> 4) << 32,
+					       USEC_PER_SEC);
 		if (linger_time < send_info[backup].linger_time) {
 			send_info[backup].ssk = ssk;
 			send_info[backup].linger_time = linger_time;
@@ -1409,6 +1454,16 @@ struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk)
 	return ssk;
 }
 
+struct sock *mptcp_subflow_get_send(struct mptcp_sock *msk)
+{
+	return __mptcp_subflow_get_send(msk, false);
+}
+
+struct sock *mptcp_subflow_get_send_owd(struct mptcp_sock *msk)
+{
+	return __mptcp_subflow_get_send(msk, true);
+}
+
 static void mptcp_push_release(struct sock *ssk, struct mptcp_sendmsg_info *info)
 {
 	tcp_push(ssk, 0, info->mss_now, tcp_sk(ssk)->nonagle, info->size_goal);
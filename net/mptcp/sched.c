@@ -47,6 +47,29 @@ static struct mptcp_sched_ops mptcp_sched_default = {
 	.owner		= THIS_MODULE,
 };
 
+static int mptcp_sched_latency_get_send(struct mptcp_sock *msk)
+{
+	struct sock *ssk;
+
+	ssk = mptcp_subflow_get_send_owd(msk);
+	if (!ssk)
+		return -EINVAL;
+
+	mptcp_subflow_set_scheduled(mptcp_subflow_ctx(ssk), true);
+	return 0;
+}
+
+/* Like the default scheduler, but estimates when the next chunk would be
+ * delivered rather than when it would be sent, for paths with very
+ * different RTTs.
+ */
+static struct mptcp_sched_ops mptcp_sched_latency = {
+	.get_send	= mptcp_sched_latency_get_send,
+	.get_retrans	= mptcp_sched_default_get_retrans,
+	.name		= "latency",
+	.owner		= THIS_MODULE,
+};
+
 /* Must be called with rcu read lock held */
 struct mptcp_sched_ops *mptcp_sched_find(const char *name)
 {
@@ -114,7 +137,7 @@ int mptcp_register_scheduler(struct mptcp_sched_ops *sched)
 
 void mptcp_unregister_scheduler(struct mptcp_sched_ops *sched)
 {
-	if (sched == &mptcp_sched_default)
+	if (sched == &mptcp_sched_default || sched == &mptcp_sched_latency)
 		return;
 
 	spin_lock(&mptcp_sched_list_lock);
@@ -125,6 +148,7 @@ void mptcp_unregister_scheduler(struct mptcp_sched_ops *sched)
 void mptcp_sched_init(void)
 {
 	mptcp_register_scheduler(&mptcp_sched_default);
+	mptcp_register_scheduler(&mptcp_sched_latency);
 }
 
 int mptcp_init_sched(struct mptcp_sock *msk,
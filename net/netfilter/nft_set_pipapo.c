@@ -438,17 +438,26 @@ bool nft_pipapo_lookup(const struct net *net, const struct nft_set *set,
 
 	nft_pipapo_for_each_field(f, i, m) {
 		bool last = i == m->field_count - 1;
+		bool match;
 		int b;
 
 		/* For each bit group: select lookup table bucket depending on
-		 * packet bytes value, then AND bucket value
+		 * packet bytes value, then AND bucket value. Stop as soon as
+		 * no rule is left: fill_map is untouched and still clean.
 		 */
 		if (likely(f->bb == 8))
-			pipapo_and_field_buckets_8bit(f, res_map, rp);
+			match = pipapo_and_field_buckets_8bit(f, res_map, rp);
 		else
-			pipapo_and_field_buckets_4bit(f, res_map, rp);
+			match = pipapo_and_field_buckets_4bit(f, res_map, rp);
 		NFT_PIPAPO_GROUP_BITS_ARE_8_OR_4;
 
+		if (!match) {
+			scratch->map_index = map_index;
+			local_bh_enable();
+
+			return false;
+		}
+
 		rp += f->groups / NFT_PIPAPO_GROUPS_PER_BYTE(f);
 
 		/* Now populate the bitmap for the next field, unless this is
@@ -185,8 +185,10 @@ int pipapo_refill(unsigned long *map, unsigned int len, unsigned int rules,
  * @f:		Field including lookup table
  * @dst:	Area to store result
  * @data:	Input data selecting table buckets
+ *
+ * Return: false if @dst became empty, i.e. no rule can match, true otherwise.
  */
-static inline void pipapo_and_field_buckets_4bit(const struct nft_pipapo_field *f,
+static inline bool pipapo_and_field_buckets_4bit(const struct nft_pipapo_field *f,
 						 unsigned long *dst,
 						 const u8 *data)
 {
@@ -197,15 +199,19 @@ static inline void pipapo_and_field_buckets_4bit(const struct nft_pipapo_field *
 		u8 v;
 
 		v = *data >> 4;
-		__bitmap_and(dst, dst, lt + v * f->bsize,
-			     f->bsize * BITS_PER_LONG);
+		if (!__bitmap_and(dst, dst, lt + v * f->bsize,
+				  f->bsize * BITS_PER_LONG))
+			return false;
 		lt += f->bsize * NFT_PIPAPO_BUCKETS(4);
 
 		v = *data & 0x0f;
-		__bitmap_and(dst, dst, lt + v * f->bsize,
-			     f->bsize * BITS_PER_LONG);
+		if (!__bitmap_and(dst, dst, lt + v * f->bsize,
+				  f->bsize * BITS_PER_LONG))
+			return false;
 		lt += f->bsize * NFT_PIPAPO_BUCKETS(4);
 	}
+
+	return true;
 }
 
 /**
@@ -213,8 +219,10 @@ static inline void pipapo_and_field_buckets_4bit(const struct nft_pipapo_field *
  * @f:		Field including lookup table
  * @dst:	Area to store result
  * @data:	Input data selecting table buckets
+ *
+ * Return: false if @dst became empty, i.e. no rule can match, true otherwise.
  */
-static inline void pipapo_and_field_buckets_8bit(const struct nft_pipapo_field *f,
+static inline bool pipapo_and_field_buckets_8bit(const struct nft_pipapo_field *f,
 						 unsigned long *dst,
 						 const u8 *data)
 {
@@ -222,10 +230,13 @@ static inline void pipapo_and_field_buckets_8bit(const struct nft_pipapo_field *
 	int group;
 
 	for (group = 0; group < f->groups; group++, data++) {
-		__bitmap_and(dst, dst, lt + *data * f->bsize,
-			     f->bsize * BITS_PER_LONG);
+		if (!__bitmap_and(dst, dst, lt + *data * f->bsize,
+				  f->bsize * BITS_PER_LONG))
+			return false;
 		lt += f->bsize * NFT_PIPAPO_BUCKETS(8);
 	}
+
+	return true;
 }
 
 /**
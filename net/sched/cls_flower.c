@@ -321,6 +321,19 @@ static u16 fl_ct_info_to_flower_map[] = {
 					TCA_FLOWER_KEY_CT_FLAGS_NEW,
 };
 
+/* The key dissected for @prev can be looked up with @mask as well if both
+ * masks dissect the same set of keys and every byte @mask looks at was
+ * either cleared or written for @prev.
+ */
+static bool fl_can_reuse_key(const struct fl_flow_mask *prev,
+			     const struct fl_flow_mask *mask)
+{
+	return prev &&
+	       prev->dissector.used_keys == mask->dissector.used_keys &&
+	       mask->range.start >= prev->range.start &&
+	       mask->range.end <= prev->range.end;
+}
+
 TC_INDIRECT_SCOPE int fl_classify(struct sk_buff *skb,
 				  const struct tcf_proto *tp,
 				  struct tcf_result *res)
@@ -328,11 +341,14 @@ TC_INDIRECT_SCOPE int fl_classify(struct sk_buff *skb,
 	struct cls_fl_head *head = rcu_dereference_bh(tp->root);
 	bool post_ct = tc_skb_cb(skb)->post_ct;
 	u16 zone = tc_skb_cb(skb)->zone;
+	struct fl_flow_mask *mask, *dissected = NULL;
 	struct fl_flow_key skb_key;
-	struct fl_flow_mask *mask;
 	struct cls_fl_filter *f;
 
 	list_for_each_entry_rcu(mask, &head->masks, list) {
+		if (fl_can_reuse_key(dissected, mask))
+			goto lookup;
+
 		flow_dissector_init_keys(&skb_key.control, &skb_key.basic);
 		fl_clear_masked_range(&skb_key, mask);
 
@@ -349,7 +365,8 @@ TC_INDIRECT_SCOPE int fl_classify(struct sk_buff *skb,
 		skb_flow_dissect_hash(skb, &mask->dissector, &skb_key);
 		skb_flow_dissect(skb, &mask->dissector, &skb_key,
 				 FLOW_DISSECTOR_F_STOP_BEFORE_ENCAP);
-
+		dissected = mask;
+lookup:
 		f = fl_mask_lookup(mask, &skb_key);
 		if (f && !tc_skip_sw(f->flags)) {
 			*res = f->res;
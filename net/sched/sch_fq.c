@@ -135,6 +135,7 @@ struct fq_sched_data {
 	struct fq_perband_flows band_flows[FQ_BANDS];
 
 	struct fq_flow	internal;	/* fastpath queue. */
+	struct fq_flow	*last_flow;	/* last flow returned by fq_classify() */
 	struct rb_root	delayed;	/* for rate limited flows */
 	u64		time_next_delayed_flow;
 	unsigned long	unthrottle_latency_ns;
@@ -290,6 +291,8 @@ static void fq_gc(struct fq_sched_data *q,
 
 	for (i = fcnt; i > 0; ) {
 		f = tofree[--i];
+		if (f == q->last_flow)
+			q->last_flow = NULL;
 		rb_erase(&f->fq_node, root);
 	}
 	q->flows -= fcnt;
@@ -400,6 +403,14 @@ static struct fq_flow *fq_classify(struct Qdisc *sch, struct sk_buff *skb,
 		return &q->internal;
 	}
 
+	/* Consecutive packets mostly belong to the same flow (GSO trains,
+	 * bulk senders): skip the tree walk and gc for them.
+	 */
+	f = q->last_flow;
+	if (f && f->sk == sk &&
+	    (skb->sk != sk || f->socket_hash == sk->sk_hash))
+		return f;
+
 	root = &q->fq_root[hash_ptr(sk, q->fq_trees_log)];
 
 	fq_gc(q, root, sk);
@@ -427,6 +438,7 @@ static struct fq_flow *fq_classify(struct Qdisc *sch, struct sk_buff *skb,
 					fq_flow_unset_throttled(q, f);
 				f->time_next_packet = 0ULL;
 			}
+			q->last_flow = f;
 			return f;
 		}
 		if (f->sk > sk)
@@ -457,6 +469,7 @@ static struct fq_flow *fq_classify(struct Qdisc *sch, struct sk_buff *skb,
 
 	q->flows++;
 	q->inactive_flows++;
+	q->last_flow = f;
 	return f;
 }
 
@@ -808,6 +821,7 @@ static void fq_reset(struct Qdisc *sch)
 	sch->qstats.backlog = 0;
 
 	fq_flow_purge(&q->internal);
+	q->last_flow = NULL;
 
 	if (!q->fq_root)
 		return;
@@ -843,6 +857,7 @@ static void fq_rehash(struct fq_sched_data *q,
 	int fcnt = 0;
 	u32 idx;
 
+	q->last_flow = NULL;
 	for (idx = 0; idx < (1U << old_log); idx++) {
 		oroot = &old_array[idx];
 		while ((op = rb_first(oroot)) != NULL) {
@@ -231,7 +231,12 @@ static struct htb_class *htb_classify(struct sk_buff *skb, struct Qdisc *sch,
 	 */
 	if (skb->priority == sch->handle)
 		return HTB_DIRECT;	/* X:0 (direct flow) selected */
-	cl = htb_find(skb->priority, sch);
+	/* only a priority with our major number can name one of our classes,
+	 * skip the class hash lookup for plain socket priorities
+	 */
+	cl = NULL;
+	if (TC_H_MAJ(skb->priority) == TC_H_MAJ(sch->handle))
+		cl = htb_find(skb->priority, sch);
 	if (cl) {
 		if (cl->level == 0)
 			return cl;
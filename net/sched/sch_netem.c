@@ -114,6 +114,9 @@ struct netem_sched_data {
 	} prng;
 
 	struct disttable *delay_dist;
+	/* replay delay_dist as a trace instead of sampling it */
+	bool delay_replay;
+	u32 delay_pos;
 
 	enum  {
 		CLG_RANDOM,
@@ -326,10 +329,14 @@ static bool loss_event(struct netem_sched_data *q)
  * std deviation sigma.  Uses table lookup to approximate the desired
  * distribution, and a uniformly-distributed pseudo-random source.
  */
+/* If @pos is not NULL, @dist is consumed in order starting at *@pos
+ * (trace replay) instead of being sampled randomly.
+ */
 static s64 tabledist(s64 mu, s32 sigma,
 		     struct crndstate *state,
 		     struct prng *prng,
-		     const struct disttable *dist)
+		     const struct disttable *dist,
+		     u32 *pos)
 {
 	s64 x;
 	long t;
@@ -338,6 +345,13 @@ static s64 tabledist(s64 mu, s32 sigma,
 	if (sigma == 0)
 		return mu;
 
+	if (dist && pos) {
+		t = dist->table[*pos];
+		if (++*pos >= dist->size)
+			*pos = 0;
+		goto scale;
+	}
+
 	rnd = get_crandom(state, prng);
 
 	/* default uniform distribution */
@@ -345,6 +359,7 @@ static s64 tabledist(s64 mu, s32 sigma,
 		return ((rnd % (2 * (u32)sigma)) + mu) - sigma;
 
 	t = dist->table[rnd % dist->size];
+scale:
 	x = (sigma % NETEM_DIST_SCALE) * t;
 	if (x >= 0)
 		x += NETEM_DIST_SCALE/2;
@@ -556,7 +571,8 @@ static int netem_enqueue(struct sk_buff *skb, struct Qdisc *sch,
 		s64 delay;
 
 		delay = tabledist(q->latency, q->jitter,
-				  &q->delay_cor, &q->prng, q->delay_dist);
+				  &q->delay_cor, &q->prng, q->delay_dist,
+				  q->delay_replay ? &q->delay_pos : NULL);
 
 		now = ktime_get_ns();
 
@@ -663,7 +679,7 @@ static void get_slot_next(struct netem_sched_data *q, u64 now)
 	else
 		next_delay = tabledist(q->slot_config.dist_delay,
 				       (s32)(q->slot_config.dist_jitter),
-				       NULL, &q->prng, q->slot_dist);
+				       NULL, &q->prng, q->slot_dist, NULL);
 
 	q->slot.slot_next = now + next_delay;
 	q->slot.packets_left = q->slot_config.max_packets;
@@ -952,6 +968,7 @@ static const struct nla_policy netem_policy[TCA_NETEM_MAX + 1] = {
 	[TCA_NETEM_JITTER64]	= { .type = NLA_S64 },
 	[TCA_NETEM_SLOT]	= { .len = sizeof(struct tc_netem_slot) },
 	[TCA_NETEM_PRNG_SEED]	= { .type = NLA_U64 },
+	[TCA_NETEM_DELAY_REPLAY] = { .type = NLA_FLAG },
 };
 
 static int parse_attr(struct nlattr *tb[], int maxtype, struct nlattr *nla,
@@ -1067,6 +1084,9 @@ static int netem_change(struct Qdisc *sch, struct nlattr *opt,
 	if (tb[TCA_NETEM_SLOT])
 		get_slot(q, tb[TCA_NETEM_SLOT]);
 
+	q->delay_replay = nla_get_flag(tb[TCA_NETEM_DELAY_REPLAY]);
+	q->delay_pos = 0;
+
 	/* capping jitter to the range acceptable by tabledist() */
 	q->jitter = min_t(s64, abs(q->jitter), INT_MAX);
 
@@ -1225,6 +1245,9 @@ static int netem_dump(struct Qdisc *sch, struct sk_buff *skb)
 	if (q->ecn && nla_put_u32(skb, TCA_NETEM_ECN, q->ecn))
 		goto nla_put_failure;
 
+	if (q->delay_replay && nla_put_flag(skb, TCA_NETEM_DELAY_REPLAY))
+		goto nla_put_failure;
+
 	if (dump_loss_model(q, skb) != 0)
 		goto nla_put_failure;
 
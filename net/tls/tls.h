@@ -50,6 +50,9 @@
 	SNMP_INC_STATS((net)->mib.tls_statistics, field)
 #define TLS_DEC_STATS(net, field)				\
 	SNMP_DEC_STATS((net)->mib.tls_statistics, field)
+/* Per socket counters, reported locklessly by tls_get_info() */
+#define TLS_CTX_INC_STATS(field)				\
+	WRITE_ONCE(field, (field) + 1)
 
 struct tls_cipher_desc {
 	unsigned int nonce;
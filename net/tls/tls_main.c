@@ -1110,6 +1110,19 @@ static int tls_get_info(struct sock *sk, struct sk_buff *skb, bool net_admin)
 		if (err)
 			goto nla_failure;
 	}
+	if (ctx->rx_conf == TLS_SW) {
+		err = nla_put_uint(skb, TLS_INFO_RX_ZC, READ_ONCE(ctx->rx_zc));
+		if (err)
+			goto nla_failure;
+		err = nla_put_uint(skb, TLS_INFO_RX_ZC_NO_PAD,
+				   READ_ONCE(ctx->rx_zc_no_pad));
+		if (err)
+			goto nla_failure;
+		err = nla_put_uint(skb, TLS_INFO_RX_ZC_SHORT_BUF,
+				   READ_ONCE(ctx->rx_zc_short_buf));
+		if (err)
+			goto nla_failure;
+	}
 
 	rcu_read_unlock();
 	nla_nest_end(skb, start);
@@ -1132,6 +1145,9 @@ static size_t tls_get_info_size(const struct sock *sk, bool net_admin)
 		nla_total_size(sizeof(u16)) +	/* TLS_INFO_TXCONF */
 		nla_total_size(0) +		/* TLS_INFO_ZC_RO_TX */
 		nla_total_size(0) +		/* TLS_INFO_RX_NO_PAD */
+		nla_total_size(sizeof(u64)) +	/* TLS_INFO_RX_ZC */
+		nla_total_size(sizeof(u64)) +	/* TLS_INFO_RX_ZC_NO_PAD */
+		nla_total_size(sizeof(u64)) +	/* TLS_INFO_RX_ZC_SHORT_BUF */
 		0;
 
 	return size;
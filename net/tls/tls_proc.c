@@ -27,6 +27,9 @@ static const struct snmp_mib tls_mib_list[] = {
 	SNMP_MIB_ITEM("TlsTxRekeyOk", LINUX_MIB_TLSTXREKEYOK),
 	SNMP_MIB_ITEM("TlsTxRekeyError", LINUX_MIB_TLSTXREKEYERROR),
 	SNMP_MIB_ITEM("TlsRxRekeyReceived", LINUX_MIB_TLSRXREKEYRECEIVED),
+	SNMP_MIB_ITEM("TlsRxZeroCopy", LINUX_MIB_TLSRXZC),
+	SNMP_MIB_ITEM("TlsRxZcNoPadOff", LINUX_MIB_TLSRXZCNOPAD),
+	SNMP_MIB_ITEM("TlsRxZcShortBuf", LINUX_MIB_TLSRXZCSHORTBUF),
 	SNMP_MIB_SENTINEL
 };
 
@@ -2044,8 +2044,7 @@ int tls_sw_recvmsg(struct sock *sk,
 	target = sock_rcvlowat(sk, flags & MSG_WAITALL, len);
 	len = len - copied;
 
-	zc_capable = !bpf_strp_enabled && !is_kvec && !is_peek &&
-		ctx->zc_capable;
+	zc_capable = !bpf_strp_enabled && !is_kvec && !is_peek;
 	decrypted = 0;
 	while (len && (decrypted + copied < target || tls_strp_msg_ready(ctx))) {
 		struct tls_decrypt_arg darg;
@@ -2073,9 +2072,20 @@ int tls_sw_recvmsg(struct sock *sk,
 
 		to_decrypt = rxm->full_len - prot->overhead_size;
 
-		if (zc_capable && to_decrypt <= len &&
-		    tlm->control == TLS_RECORD_TYPE_DATA)
-			darg.zc = true;
+		/* Account for why a data record that could have been
+		 * decrypted straight into the user buffer was not.
+		 */
+		if (zc_capable && tlm->control == TLS_RECORD_TYPE_DATA) {
+			if (!ctx->zc_capable) {
+				TLS_INC_STATS(sock_net(sk), LINUX_MIB_TLSRXZCNOPAD);
+				TLS_CTX_INC_STATS(tls_ctx->rx_zc_no_pad);
+			} else if (to_decrypt > len) {
+				TLS_INC_STATS(sock_net(sk), LINUX_MIB_TLSRXZCSHORTBUF);
+				TLS_CTX_INC_STATS(tls_ctx->rx_zc_short_buf);
+			} else {
+				darg.zc = true;
+			}
+		}
 
 		/* Do not use async mode if record is non-data */
 		if (tlm->control == TLS_RECORD_TYPE_DATA && !bpf_strp_enabled)
@@ -2168,6 +2178,9 @@ int tls_sw_recvmsg(struct sock *sk,
 			}
 
 			consume_skb(skb);
+		} else {
+			TLS_INC_STATS(sock_net(sk), LINUX_MIB_TLSRXZC);
+			TLS_CTX_INC_STATS(tls_ctx->rx_zc);
 		}
 
 		decrypted += chunk;
@@ -86,6 +86,7 @@
 #include <linux/filter.h>
 #include <linux/fs.h>
 #include <linux/fs_struct.h>
+#include <linux/in.h>
 #include <linux/init.h>
 #include <linux/kernel.h>
 #include <linux/mount.h>
@@ -637,6 +638,8 @@ static void unix_sock_destructor(struct sock *sk)
 	struct unix_sock *u = unix_sk(sk);
 
 	skb_queue_purge_reason(&sk->sk_receive_queue, SKB_DROP_REASON_SOCKET_CLOSE);
+	/* MSG_ZEROCOPY notifications may still be queued, even after release */
+	skb_queue_purge(&sk->sk_error_queue);
 
 	DEBUG_NET_WARN_ON_ONCE(refcount_read(&sk->sk_wmem_alloc));
 	DEBUG_NET_WARN_ON_ONCE(!sk_unhashed(sk));
@@ -2316,6 +2319,7 @@ static int queue_oob(struct sock *sk, struct msghdr *msg, struct sock *other,
 static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			       size_t len)
 {
+	struct ubuf_info *uarg = NULL;
 	struct sock *sk = sock->sk;
 	struct sk_buff *skb = NULL;
 	struct sock *other = NULL;
@@ -2353,11 +2357,28 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	if (READ_ONCE(sk->sk_shutdown) & SEND_SHUTDOWN)
 		goto out_pipe;
 
+	if ((msg->msg_flags & MSG_ZEROCOPY) && len &&
+	    !(msg->msg_flags & MSG_SPLICE_PAGES) &&
+	    sock_flag(sk, SOCK_ZEROCOPY)) {
+		uarg = msg_zerocopy_realloc(sk, len, NULL, false);
+		if (!uarg) {
+			err = -ENOBUFS;
+			goto out_err;
+		}
+	}
+
 	while (sent < len) {
 		int size = len - sent;
 		int data_len;
 
 		if (unlikely(msg->msg_flags & MSG_SPLICE_PAGES)) {
+			skb = sock_alloc_send_pskb(sk, 0, 0,
+						   msg->msg_flags & MSG_DONTWAIT,
+						   &err, 0);
+		} else if (uarg) {
+			/* Keep two messages in the pipe so it schedules better */
+			size = min_t(int, size, (READ_ONCE(sk->sk_sndbuf) >> 1) - 64);
+
 			skb = sock_alloc_send_pskb(sk, 0, 0,
 						   msg->msg_flags & MSG_DONTWAIT,
 						   &err, 0);
@@ -2395,6 +2416,21 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 
 			size = err;
 			refcount_add(size, &sk->sk_wmem_alloc);
+		} else if (uarg) {
+			/* No socket to charge: the pinned pages then go to
+			 * skb->sk->sk_wmem_alloc, which is what limits a unix
+			 * sender, rather than to sk_wmem_queued.  The skb is
+			 * fresh, so on error drop it whole, with the pages it
+			 * pinned and their charge, instead of trimming it.
+			 */
+			err = __zerocopy_sg_from_iter(msg, NULL, skb,
+						      &msg->msg_iter, size,
+						      NULL);
+			if (err && (err != -EMSGSIZE || !skb->len))
+				goto out_free;
+
+			skb_zcopy_set(skb, uarg, NULL);
+			size = skb->len;
 		} else {
 			skb_put(skb, size - data_len);
 			skb->data_len = data_len;
@@ -2433,6 +2469,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	}
 #endif
 
+	net_zcopy_put(uarg);
 	scm_destroy(&scm);
 
 	return sent;
@@ -2446,6 +2483,10 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 out_free:
 	consume_skb(skb);
 out_err:
+	if (sent)
+		net_zcopy_put(uarg);
+	else
+		net_zcopy_put_abort(uarg, true);
 	scm_destroy(&scm);
 	return sent ? : err;
 }
@@ -2802,6 +2843,14 @@ static int unix_stream_read_skb(struct sock *sk, skb_read_actor_t recv_actor)
 	if (!skb)
 		return err;
 
+	/* The sender is told its pages are free once this skb is; do not
+	 * let a redirect keep them beyond that.
+	 */
+	if (skb_orphan_frags_rx(skb, GFP_ATOMIC)) {
+		kfree_skb_reason(skb, SKB_DROP_REASON_NOMEM);
+		return -ENOMEM;
+	}
+
 #if IS_ENABLED(CONFIG_AF_UNIX_OOB)
 	if (unlikely(skb == READ_ONCE(u->oob_skb))) {
 		bool drop = false;
@@ -3068,11 +3117,15 @@ static int unix_stream_recvmsg(struct socket *sock, struct msghdr *msg,
 		.size = size,
 		.flags = flags
 	};
-
-#ifdef CONFIG_BPF_SYSCALL
 	struct sock *sk = sock->sk;
+#ifdef CONFIG_BPF_SYSCALL
 	const struct proto *prot = READ_ONCE(sk->sk_prot);
+#endif
 
+	if (unlikely(flags & MSG_ERRQUEUE))
+		return sock_recv_errqueue(sk, msg, size, SOL_IP, IP_RECVERR);
+
+#ifdef CONFIG_BPF_SYSCALL
 	if (prot != &unix_stream_proto)
 		return prot->recvmsg(sk, msg, size, flags, NULL);
 #endif
@@ -3083,6 +3136,12 @@ static int unix_stream_splice_actor(struct sk_buff *skb,
 				    int skip, int chunk,
 				    struct unix_stream_read_state *state)
 {
+	/* Pages in a pipe outlive the skb, and with it the sender's
+	 * MSG_ZEROCOPY completion.
+	 */
+	if (skb_orphan_frags_rx(skb, GFP_KERNEL))
+		return -ENOMEM;
+
 	return skb_splice_bits(skb, state->socket->sk,
 			       UNIXCB(skb).consumed + skip,
 			       state->pipe, chunk, state->splice_flags);
@@ -3301,8 +3360,10 @@ static __poll_t unix_poll(struct file *file, struct socket *sock, poll_table *wa
 	state = READ_ONCE(sk->sk_state);
 
 	/* exceptional events? */
-	if (READ_ONCE(sk->sk_err))
-		mask |= EPOLLERR;
+	if (READ_ONCE(sk->sk_err) ||
+	    !skb_queue_empty_lockless(&sk->sk_error_queue))
+		mask |= EPOLLERR |
+			(sock_flag(sk, SOCK_SELECT_ERR_QUEUE) ? EPOLLPRI : 0);
 	if (shutdown == SHUTDOWN_MASK)
 		mask |= EPOLLHUP;
 	if (shutdown & RCV_SHUTDOWN)
@@ -470,6 +470,10 @@ static inline int avc_reclaim_node(void)
 		head = &selinux_avc.avc_cache.slots[hvalue];
 		lock = &selinux_avc.avc_cache.slots_lock[hvalue];
 
+		/* Reclaim is best effort, don't bounce locks of empty slots. */
+		if (hlist_empty(head))
+			continue;
+
 		if (!spin_trylock_irqsave(lock, flags))
 			continue;
 
@@ -134,6 +134,9 @@ enum {
 	NETDEV_A_NAPI_DEFER_HARD_IRQS,
 	NETDEV_A_NAPI_GRO_FLUSH_TIMEOUT,
 	NETDEV_A_NAPI_IRQ_SUSPEND_TIMEOUT,
+	NETDEV_A_NAPI_GRO_FLUSH_EVICT,
+	NETDEV_A_NAPI_GRO_FLUSH_PROTO,
+	NETDEV_A_NAPI_GRO_FLUSH_POLL,
 
 	__NETDEV_A_NAPI_MAX,
 	NETDEV_A_NAPI_MAX = (__NETDEV_A_NAPI_MAX - 1)
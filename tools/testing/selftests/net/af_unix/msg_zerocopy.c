@@ -0,0 +1,321 @@
+// SPDX-License-Identifier: GPL-2.0
+/* MSG_ZEROCOPY on AF_UNIX stream sockets */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/bpf.h>
+#include <linux/errqueue.h>
+#include <linux/sockios.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+#include "../../kselftest_harness.h"
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY	60
+#endif
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY	0x4000000
+#endif
+
+#define BUF_SIZE	(64 * 1024)
+#define LEAK_ITERS	4096
+
+FIXTURE(msg_zerocopy)
+{
+	int fd[2];
+	char *buf;
+};
+
+FIXTURE_SETUP(msg_zerocopy)
+{
+	int ret, one = 1;
+
+	ret = socketpair(AF_UNIX, SOCK_STREAM, 0, self->fd);
+	ASSERT_EQ(0, ret);
+
+	ret = setsockopt(self->fd[0], SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one));
+	ASSERT_EQ(0, ret);
+
+	self->buf = malloc(BUF_SIZE);
+	ASSERT_NE(NULL, self->buf);
+	memset(self->buf, 'a', BUF_SIZE);
+}
+
+FIXTURE_TEARDOWN(msg_zerocopy)
+{
+	if (self->fd[0] >= 0)
+		close(self->fd[0]);
+	if (self->fd[1] >= 0)
+		close(self->fd[1]);
+	free(self->buf);
+}
+
+/* Wait for, then read one completion and return its ee_code. */
+static int read_notification(struct __test_metadata *_metadata, int fd,
+			     unsigned int lo, unsigned int hi)
+{
+	char control[CMSG_SPACE(sizeof(struct sock_extended_err))];
+	struct pollfd pfd = { .fd = fd };
+	struct sock_extended_err *serr;
+	struct msghdr msg = {
+		.msg_control = control,
+		.msg_controllen = sizeof(control),
+	};
+	struct cmsghdr *cm;
+	int ret;
+
+	ret = poll(&pfd, 1, 1000);
+	ASSERT_EQ(1, ret);
+	ASSERT_TRUE(pfd.revents & POLLERR);
+
+	ret = recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+	ASSERT_EQ(0, ret);
+
+	cm = CMSG_FIRSTHDR(&msg);
+	ASSERT_NE(NULL, cm);
+	ASSERT_EQ(SOL_IP, cm->cmsg_level);
+	ASSERT_EQ(IP_RECVERR, cm->cmsg_type);
+
+	serr = (struct sock_extended_err *)CMSG_DATA(cm);
+	ASSERT_EQ(SO_EE_ORIGIN_ZEROCOPY, serr->ee_origin);
+	ASSERT_EQ(0, serr->ee_errno);
+	ASSERT_EQ(lo, serr->ee_info);
+	ASSERT_EQ(hi, serr->ee_data);
+
+	return serr->ee_code;
+}
+
+static void recv_all(struct __test_metadata *_metadata, int fd, char c)
+{
+	char rbuf[4096];
+	int total = 0, ret, i;
+
+	while (total < BUF_SIZE) {
+		ret = read(fd, rbuf, sizeof(rbuf));
+		ASSERT_LT(0, ret);
+
+		for (i = 0; i < ret; i++)
+			ASSERT_EQ(c, rbuf[i]);
+		total += ret;
+	}
+}
+
+TEST_F(msg_zerocopy, basic)
+{
+	int ret;
+
+	ret = send(self->fd[0], self->buf, BUF_SIZE, MSG_ZEROCOPY);
+	ASSERT_EQ(BUF_SIZE, ret);
+
+	recv_all(_metadata, self->fd[1], 'a');
+	read_notification(_metadata, self->fd[0], 0, 0);
+}
+
+/* A fault after some pages were pinned must give back their charge. */
+TEST_F(msg_zerocopy, fault)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	struct iovec iov[2];
+	struct msghdr msg = {
+		.msg_iov = iov,
+		.msg_iovlen = 2,
+	};
+	int ret, outq;
+	char *map;
+
+	map = mmap(NULL, 2 * page, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ASSERT_NE(MAP_FAILED, map);
+	memset(map, 'a', page);
+	ASSERT_EQ(0, munmap(map + page, page));
+
+	iov[0].iov_base = map;
+	iov[0].iov_len = page;
+	iov[1].iov_base = map + page;
+	iov[1].iov_len = page;
+
+	ret = sendmsg(self->fd[0], &msg, MSG_ZEROCOPY);
+	ASSERT_EQ(-1, ret);
+	ASSERT_EQ(EFAULT, errno);
+
+	/* Nothing was queued, so nothing may stay charged to the sender. */
+	ASSERT_EQ(0, ioctl(self->fd[0], SIOCOUTQ, &outq));
+	ASSERT_EQ(0, outq);
+
+	munmap(map, page);
+}
+
+static long slab_active_objs(const char *name)
+{
+	char line[512], cache[64];
+	long active = -1, n;
+	FILE *f;
+
+	f = fopen("/proc/slabinfo", "r");
+	if (!f)
+		return -1;
+
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "%63s %ld", cache, &n) == 2 &&
+		    !strcmp(cache, name)) {
+			active = n;
+			break;
+		}
+	}
+	fclose(f);
+
+	return active;
+}
+
+/* Notifications nobody read must be freed with the socket. */
+TEST_F(msg_zerocopy, close_unread)
+{
+	long before, after;
+	int i, ret, one = 1;
+
+	before = slab_active_objs("skbuff_head_cache");
+	if (before < 0)
+		SKIP(return, "skbuff_head_cache not in /proc/slabinfo");
+
+	for (i = 0; i < LEAK_ITERS; i++) {
+		int fd[2];
+
+		ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fd);
+		ASSERT_EQ(0, ret);
+
+		ret = setsockopt(fd[0], SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one));
+		ASSERT_EQ(0, ret);
+
+		ret = send(fd[0], self->buf, 4096, MSG_ZEROCOPY);
+		ASSERT_EQ(4096, ret);
+
+		/* Free the data skb so that the notification gets queued. */
+		ret = read(fd[1], self->buf, 4096);
+		ASSERT_EQ(4096, ret);
+
+		close(fd[0]);
+		close(fd[1]);
+	}
+
+	/* Let any deferred skb and socket frees run first. */
+	sleep(2);
+
+	after = slab_active_objs("skbuff_head_cache");
+	ASSERT_LT(after - before, LEAK_ITERS / 2);
+}
+
+/* The pipe must not keep referencing the pages after the completion. */
+TEST_F(msg_zerocopy, splice)
+{
+	int pipefd[2], ret, code;
+	char rbuf[4096];
+	int total = 0, i;
+
+	ASSERT_EQ(0, pipe(pipefd));
+	ret = fcntl(pipefd[1], F_SETPIPE_SZ, BUF_SIZE);
+	ASSERT_LE(BUF_SIZE, ret);
+
+	ret = send(self->fd[0], self->buf, BUF_SIZE, MSG_ZEROCOPY);
+	ASSERT_EQ(BUF_SIZE, ret);
+
+	while (total < BUF_SIZE) {
+		ret = splice(self->fd[1], NULL, pipefd[1], NULL,
+			     BUF_SIZE - total, 0);
+		ASSERT_LT(0, ret);
+		total += ret;
+	}
+
+	/* The data is still in the pipe, but the pages were copied out. */
+	code = read_notification(_metadata, self->fd[0], 0, 0);
+	ASSERT_EQ(SO_EE_CODE_ZEROCOPY_COPIED, code);
+
+	memset(self->buf, 'b', BUF_SIZE);
+
+	for (total = 0; total < BUF_SIZE; total += ret) {
+		ret = read(pipefd[0], rbuf, sizeof(rbuf));
+		ASSERT_LT(0, ret);
+
+		for (i = 0; i < ret; i++)
+			ASSERT_EQ('a', rbuf[i]);
+	}
+
+	close(pipefd[0]);
+	close(pipefd[1]);
+}
+
+static int sys_bpf(int cmd, union bpf_attr *attr)
+{
+	return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+/* sockmap reads the skb through ->read_skb() and keeps it on a psock. */
+TEST_F(msg_zerocopy, sockmap)
+{
+	struct bpf_insn prog[] = {
+		/* r0 = SK_PASS; exit */
+		{ .code = BPF_ALU64 | BPF_MOV | BPF_K, .dst_reg = BPF_REG_0, .imm = 1 },
+		{ .code = BPF_JMP | BPF_EXIT },
+	};
+	union bpf_attr attr;
+	int map_fd, prog_fd, ret, code, key = 0;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.map_type = BPF_MAP_TYPE_SOCKMAP;
+	attr.key_size = sizeof(int);
+	attr.value_size = sizeof(int);
+	attr.max_entries = 1;
+	map_fd = sys_bpf(BPF_MAP_CREATE, &attr);
+	if (map_fd < 0 && (errno == EPERM || errno == EINVAL))
+		SKIP(return, "cannot create a sockmap: %s", strerror(errno));
+	ASSERT_LE(0, map_fd);
+
+	memset(&attr, 0, sizeof(attr));
+	attr.prog_type = BPF_PROG_TYPE_SK_SKB;
+	attr.expected_attach_type = BPF_SK_SKB_VERDICT;
+	attr.insns = (unsigned long)prog;
+	attr.insn_cnt = sizeof(prog) / sizeof(prog[0]);
+	attr.license = (unsigned long)"GPL";
+	prog_fd = sys_bpf(BPF_PROG_LOAD, &attr);
+	ASSERT_LE(0, prog_fd);
+
+	memset(&attr, 0, sizeof(attr));
+	attr.target_fd = map_fd;
+	attr.attach_bpf_fd = prog_fd;
+	attr.attach_type = BPF_SK_SKB_VERDICT;
+	ret = sys_bpf(BPF_PROG_ATTACH, &attr);
+	ASSERT_EQ(0, ret);
+
+	memset(&attr, 0, sizeof(attr));
+	attr.map_fd = map_fd;
+	attr.key = (unsigned long)&key;
+	attr.value = (unsigned long)&self->fd[1];
+	ret = sys_bpf(BPF_MAP_UPDATE_ELEM, &attr);
+	ASSERT_EQ(0, ret);
+
+	ret = send(self->fd[0], self->buf, BUF_SIZE, MSG_ZEROCOPY);
+	ASSERT_EQ(BUF_SIZE, ret);
+
+	/* Completion fires before the receiver reads from its psock. */
+	code = read_notification(_metadata, self->fd[0], 0, 0);
+	ASSERT_EQ(SO_EE_CODE_ZEROCOPY_COPIED, code);
+
+	memset(self->buf, 'b', BUF_SIZE);
+	recv_all(_metadata, self->fd[1], 'a');
+
+	close(prog_fd);
+	close(map_fd);
+}
+
+TEST_HARNESS_MAIN